@@ -0,0 +1,554 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+
+#include <string>
+
+#include <ibpp.h>
+
+#include "config/Config.h"
+#include "core/StringUtils.h"
+#include "gui/controls/DataGridRows.h"
+#include "metadata/database.h"
+#include "metadata/server.h"
+#include "metadata/table.h"
+#include "sql/MultiStatement.h"
+#include "sql/SqlTokenizer.h"
+
+// flamerobin_bench creates a scratch database on a local Firebird server,
+// runs the selected benchmark suites against it and writes one JSON object
+// per measurement to stdout.  The database is dropped afterwards unless
+// --keep is given.
+
+// BenchResult class
+// Collects the values of a single measurement and prints them as one line
+// of JSON.
+class BenchResult
+{
+private:
+    wxString lineM;
+
+    static wxString quote(const wxString& s);
+public:
+    BenchResult(const wxString& suite, const wxString& name);
+
+    BenchResult& add(const wxString& key, double value);
+    BenchResult& add(const wxString& key, const wxString& value);
+    void print();
+};
+
+BenchResult::BenchResult(const wxString& suite, const wxString& name)
+    : lineM("{\"suite\": " + quote(suite) + ", \"case\": " + quote(name))
+{
+}
+
+/*static*/
+wxString BenchResult::quote(const wxString& s)
+{
+    wxString result(s);
+    result.Replace("\\", "\\\\");
+    result.Replace("\"", "\\\"");
+    return "\"" + result + "\"";
+}
+
+BenchResult& BenchResult::add(const wxString& key, double value)
+{
+    // no locale is set, so the decimal separator is always a dot
+    lineM += ", " + quote(key) + ": " + wxString::Format("%.3f", value);
+    return *this;
+}
+
+BenchResult& BenchResult::add(const wxString& key, const wxString& value)
+{
+    lineM += ", " + quote(key) + ": " + quote(value);
+    return *this;
+}
+
+void BenchResult::print()
+{
+    wxPuts(lineM + "}");
+    fflush(stdout);
+}
+
+static double secondsSince(wxStopWatch& sw)
+{
+    return sw.TimeInMicro().ToDouble() / 1e6;
+}
+
+static double perSecond(double count, double seconds)
+{
+    return (seconds > 0) ? count / seconds : 0;
+}
+
+// columns of the BENCH_DATA table, one per data type, with the expression
+// used to fill them from the row number :i
+struct BenchColumn
+{
+    const char* name;
+    const char* type;
+    const char* value;
+};
+
+static const BenchColumn benchColumns[] =
+{
+    { "C_SMALLINT", "smallint", "mod(:i, 32000)" },
+    { "C_INTEGER", "integer", ":i" },
+    { "C_BIGINT", "bigint", ":i * 1000003" },
+    { "C_NUMERIC", "numeric(18,4)", ":i / 7.0" },
+    { "C_DOUBLE", "double precision", ":i * 1.5" },
+    { "C_VARCHAR", "varchar(100)",
+        "'row ' || :i || ' ' || lpad('', mod(:i, 80), 'x')" },
+    { "C_CHAR", "char(20)", "'c' || mod(:i, 1000)" },
+    { "C_DATE", "date", "dateadd(mod(:i, 10000) day to date '2000-01-01')" },
+    { "C_TIMESTAMP", "timestamp",
+        "dateadd(:i second to timestamp '2000-01-01 00:00:00')" },
+    { "C_BLOB", "blob sub_type text", "'blob ' || :i" }
+};
+
+// BenchApp class
+class BenchApp: public wxAppConsole
+{
+private:
+    wxString serverM;
+    wxString databasePathM;
+    wxString userM;
+    wxString passwordM;
+    long rowsM;
+    long tablesM;
+    long scriptSizeM;
+    bool keepM;
+    wxArrayString suitesM;
+
+    IBPP::Database ibppDatabaseM;
+    ServerPtr serverModelM;
+    DatabasePtr databaseModelM;
+
+    bool runSuite(const wxString& suite) const;
+    void execute(const std::string& sql);
+    void createDatabase();
+    void createBenchData();
+    void createSchema();
+    void connectModel();
+
+    void benchFetch();
+    void benchDataGridRows();
+    void benchParser();
+    void benchMetadata();
+public:
+    BenchApp();
+
+    virtual void OnInitCmdLine(wxCmdLineParser& parser);
+    virtual bool OnCmdLineParsed(wxCmdLineParser& parser);
+    virtual int OnRun();
+};
+
+IMPLEMENT_APP_CONSOLE(BenchApp)
+
+BenchApp::BenchApp()
+    : userM("SYSDBA"), passwordM("masterkey"), rowsM(100000),
+      tablesM(500), scriptSizeM(8), keepM(false)
+{
+}
+
+void BenchApp::OnInitCmdLine(wxCmdLineParser& parser)
+{
+    wxAppConsole::OnInitCmdLine(parser);
+    parser.AddOption("s", "server",
+        "Firebird server, empty for an embedded connection");
+    parser.AddOption("d", "database",
+        "File name of the scratch database (default: in the temp dir)");
+    parser.AddOption("u", "user", "User name (default: SYSDBA)");
+    parser.AddOption("p", "password",
+        "Password (default: ISC_PASSWORD or masterkey)");
+    parser.AddOption("r", "rows", "Rows in the fetch table (default: 100000)",
+        wxCMD_LINE_VAL_NUMBER);
+    parser.AddOption("t", "tables",
+        "Tables in the synthetic schema (default: 500)",
+        wxCMD_LINE_VAL_NUMBER);
+    parser.AddOption("m", "script-mb",
+        "Size of the parser test script in MB (default: 8)",
+        wxCMD_LINE_VAL_NUMBER);
+    parser.AddOption("b", "suites",
+        "Comma separated suites to run: fetch,rows,parser,metadata");
+    parser.AddSwitch("k", "keep", "Don't drop the scratch database");
+}
+
+bool BenchApp::OnCmdLineParsed(wxCmdLineParser& parser)
+{
+    if (!wxAppConsole::OnCmdLineParsed(parser))
+        return false;
+
+    wxString envPassword;
+    if (wxGetEnv("ISC_PASSWORD", &envPassword))
+        passwordM = envPassword;
+    wxString envUser;
+    if (wxGetEnv("ISC_USER", &envUser))
+        userM = envUser;
+
+    parser.Found("server", &serverM);
+    parser.Found("user", &userM);
+    parser.Found("password", &passwordM);
+    parser.Found("rows", &rowsM);
+    parser.Found("tables", &tablesM);
+    parser.Found("script-mb", &scriptSizeM);
+    keepM = parser.Found("keep");
+
+    wxString suites("fetch,rows,parser,metadata");
+    parser.Found("suites", &suites);
+    suitesM = wxSplit(suites, ',');
+
+    if (!parser.Found("database", &databasePathM))
+    {
+        databasePathM = wxFileName::CreateTempFileName("frbench");
+        // only the unique name is needed, the server creates the file
+        wxRemoveFile(databasePathM);
+        databasePathM += ".fdb";
+    }
+    return true;
+}
+
+bool BenchApp::runSuite(const wxString& suite) const
+{
+    return suitesM.Index(suite) != wxNOT_FOUND;
+}
+
+int BenchApp::OnRun()
+{
+    int result = 0;
+    // keep settings and the metadata cache away from the user's files
+    wxString homePath(wxFileName::CreateTempFileName("frbenchhome"));
+    wxRemoveFile(homePath);
+    wxFileName::Mkdir(homePath, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    config().setUserHomePath(homePath);
+
+    try
+    {
+        if (!IBPP::CheckVersion(IBPP::Version))
+        {
+            wxFprintf(stderr, "Wrong IBPP version.\n");
+            return 1;
+        }
+        createDatabase();
+        if (runSuite("fetch"))
+            benchFetch();
+        if (runSuite("rows"))
+            benchDataGridRows();
+        if (runSuite("parser"))
+            benchParser();
+        if (runSuite("metadata"))
+            benchMetadata();
+    }
+    catch (IBPP::Exception& e)
+    {
+        wxFprintf(stderr, "%s\n", e.what());
+        result = 1;
+    }
+    catch (std::exception& e)
+    {
+        wxFprintf(stderr, "%s\n", e.what());
+        result = 1;
+    }
+
+    try
+    {
+        if (databaseModelM)
+            databaseModelM->disconnect();
+        if (ibppDatabaseM != 0 && ibppDatabaseM->Connected())
+        {
+            if (keepM)
+                ibppDatabaseM->Disconnect();
+            else
+                ibppDatabaseM->Drop();
+        }
+    }
+    catch (IBPP::Exception& e)
+    {
+        wxFprintf(stderr, "%s\n", e.what());
+        result = 1;
+    }
+    wxFileName::Rmdir(homePath, wxPATH_RMDIR_RECURSIVE);
+    return result;
+}
+
+// executes sql in a transaction of its own
+void BenchApp::execute(const std::string& sql)
+{
+    IBPP::Transaction tr = IBPP::TransactionFactory(ibppDatabaseM);
+    tr->Start();
+    IBPP::Statement st = IBPP::StatementFactory(ibppDatabaseM, tr);
+    st->Execute(sql);
+    tr->Commit();
+}
+
+void BenchApp::createDatabase()
+{
+    ibppDatabaseM = IBPP::DatabaseFactory(wx2std(serverM),
+        wx2std(databasePathM), wx2std(userM), wx2std(passwordM), "", "UTF8",
+        "");
+    ibppDatabaseM->Create(3);
+    ibppDatabaseM->Connect();
+
+    if (runSuite("fetch") || runSuite("rows"))
+        createBenchData();
+    if (runSuite("metadata"))
+        createSchema();
+}
+
+void BenchApp::createBenchData()
+{
+    std::string columns("ID integer not null primary key");
+    std::string values(":i");
+    for (size_t i = 0; i < WXSIZEOF(benchColumns); ++i)
+    {
+        columns += std::string(", ") + benchColumns[i].name + " "
+            + benchColumns[i].type;
+        values += std::string(", ") + benchColumns[i].value;
+    }
+    execute("create table BENCH_DATA (" + columns + ")");
+
+    wxStopWatch sw;
+    execute("execute block as declare i integer = 0; begin "
+        "while (i < " + std::to_string(rowsM) + ") do begin "
+        "insert into BENCH_DATA values (" + values + "); i = i + 1; end end");
+    BenchResult("setup", "insert_rows").add("rows", rowsM)
+        .add("seconds", secondsSince(sw)).print();
+}
+
+void BenchApp::createSchema()
+{
+    wxStopWatch sw;
+    IBPP::Transaction tr = IBPP::TransactionFactory(ibppDatabaseM);
+    tr->Start();
+    for (long t = 0; t < tablesM; ++t)
+    {
+        wxString columns(wxString::Format("ID_%ld integer not null", t));
+        for (int c = 1; c < 20; ++c)
+        {
+            columns += wxString::Format(", COL_%d %s", c,
+                benchColumns[c % WXSIZEOF(benchColumns)].type);
+        }
+        IBPP::Statement st = IBPP::StatementFactory(ibppDatabaseM, tr);
+        st->Execute(wx2std(wxString::Format(
+            "create table SCHEMA_T%ld (%s, constraint PK_SCHEMA_T%ld "
+            "primary key (ID_%ld))", t, columns, t, t)));
+        if (t % 10 == 9)
+        {
+            // views and procedures depend on committed tables
+            tr->Commit();
+            tr->Start();
+            st = IBPP::StatementFactory(ibppDatabaseM, tr);
+            st->Execute(wx2std(wxString::Format(
+                "create view SCHEMA_V%ld as select * from SCHEMA_T%ld",
+                t, t)));
+            st->Execute(wx2std(wxString::Format(
+                "create procedure SCHEMA_P%ld (ID integer) returns (C integer)"
+                " as begin select count(*) from SCHEMA_T%ld where ID_%ld = :ID"
+                " into :C; suspend; end", t, t, t)));
+            tr->Commit();
+            tr->Start();
+        }
+    }
+    tr->Commit();
+    BenchResult("setup", "create_schema").add("tables", tablesM)
+        .add("seconds", secondsSince(sw)).print();
+}
+
+// connects the metadata model the application uses to the scratch database
+void BenchApp::connectModel()
+{
+    if (databaseModelM)
+    {
+        databaseModelM->connect(passwordM);
+        return;
+    }
+    serverModelM.reset(new Server());
+    serverModelM->setHostname(serverM);
+    databaseModelM = serverModelM->addDatabase();
+    databaseModelM->setPath(databasePathM);
+    databaseModelM->setUsername(userM);
+    databaseModelM->setConnectionCharset("UTF8");
+    databaseModelM->connect(passwordM);
+}
+
+void BenchApp::benchFetch()
+{
+    wxArrayString selects;
+    for (size_t i = 0; i < WXSIZEOF(benchColumns); ++i)
+        selects.Add(benchColumns[i].name);
+    selects.Add("*");
+
+    IBPP::Transaction tr = IBPP::TransactionFactory(ibppDatabaseM,
+        IBPP::amRead);
+    tr->Start();
+    for (size_t i = 0; i < selects.size(); ++i)
+    {
+        IBPP::Statement st = IBPP::StatementFactory(ibppDatabaseM, tr);
+        st->Prepare(wx2std("select " + selects[i] + " from BENCH_DATA"));
+        int rowSize = 0;
+        for (int c = 1; c <= st->Columns(); ++c)
+            rowSize += st->ColumnSize(c);
+
+        wxStopWatch sw;
+        st->Execute();
+        long rows = 0;
+        while (st->Fetch())
+            ++rows;
+        double seconds = secondsSince(sw);
+
+        BenchResult("fetch", (selects[i] == "*") ? wxString("ALL")
+                : selects[i].Mid(2))
+            .add("rows", rows).add("seconds", seconds)
+            .add("rows_per_second", perSecond(rows, seconds))
+            .add("mb_per_second",
+                perSecond(double(rows) * rowSize / (1024 * 1024), seconds))
+            .print();
+    }
+    tr->Commit();
+}
+
+void BenchApp::benchDataGridRows()
+{
+    connectModel();
+    IBPP::Database& db = databaseModelM->getIBPPDatabase();
+    IBPP::Transaction tr = IBPP::TransactionFactory(db, IBPP::amRead);
+    tr->Start();
+    IBPP::Statement st = IBPP::StatementFactory(db, tr);
+    st->Prepare("select * from BENCH_DATA");
+    st->Execute();
+
+    DataGridRows rows(databaseModelM.get());
+    rows.initialize(st);
+    wxStopWatch sw;
+    while (st->Fetch())
+        rows.addRow(st);
+    double seconds = secondsSince(sw);
+
+    unsigned count = rows.getRowCount();
+    size_t memory = rows.getMemoryUsage();
+    BenchResult("rows", "addRow")
+        .add("rows", count).add("seconds", seconds)
+        .add("us_per_row", count ? seconds * 1e6 / count : 0)
+        .add("memory_bytes", memory)
+        .add("bytes_per_row", count ? double(memory) / count : 0)
+        .print();
+
+    rows.clear();
+    tr->Commit();
+}
+
+void BenchApp::benchParser()
+{
+    static const char* statements[] =
+    {
+        "select r.rdb$relation_name, f.rdb$field_name, f.rdb$field_position\n"
+        "from rdb$relations r\n"
+        "join rdb$relation_fields f on f.rdb$relation_name = r.rdb$relation_name\n"
+        "where r.rdb$system_flag = 0 and f.rdb$null_flag is null\n"
+        "order by 1, 3;\n",
+        "-- keep the customer names in sync\n"
+        "update CUSTOMER set NAME = 'O''Brien; Sons', UPDATED = current_timestamp\n"
+        "where ID in (select CUSTOMER_ID from ORDERS where AMOUNT > 1000.50);\n",
+        "insert into ORDERS (ID, CUSTOMER_ID, AMOUNT, NOTE)\n"
+        "values (gen_id(GEN_ORDERS, 1), 42, 17.25, 'semicolon; in a string');\n",
+        "/* multi-line comment with a ; terminator inside\n"
+        "   that the splitter has to skip */\n"
+        "create or alter view V_TOTALS as\n"
+        "select CUSTOMER_ID, sum(AMOUNT) as TOTAL, count(*) as CNT\n"
+        "from ORDERS group by CUSTOMER_ID having count(*) > 2;\n",
+        "delete from ORDER_LINES where ORDER_ID not in (select ID from ORDERS);\n"
+    };
+
+    size_t targetSize = size_t(scriptSizeM) * 1024 * 1024;
+    wxString script;
+    script.reserve(targetSize + 1024);
+    for (size_t i = 0; script.length() < targetSize; ++i)
+        script += statements[i % WXSIZEOF(statements)];
+    double megabytes = script.length() / (1024.0 * 1024.0);
+
+    wxStopWatch sw;
+    SqlTokenizer tokenizer(script);
+    long tokens = 0;
+    while (tokenizer.nextToken())
+        ++tokens;
+    double seconds = secondsSince(sw);
+    BenchResult("parser", "SqlTokenizer")
+        .add("mb", megabytes).add("tokens", tokens).add("seconds", seconds)
+        .add("mb_per_second", perSecond(megabytes, seconds))
+        .print();
+
+    sw.Start();
+    MultiStatement multiStatement(script);
+    long count = 0;
+    while (multiStatement.getNextStatement().isValid())
+        ++count;
+    seconds = secondsSince(sw);
+    BenchResult("parser", "MultiStatement")
+        .add("mb", megabytes).add("statements", count).add("seconds", seconds)
+        .add("mb_per_second", perSecond(megabytes, seconds))
+        .print();
+}
+
+void BenchApp::benchMetadata()
+{
+    if (databaseModelM)
+        databaseModelM->disconnect();
+
+    // the first connection fills the metadata cache, the second one
+    // after disconnecting is served from it
+    wxStopWatch sw;
+    connectModel();
+    double seconds = secondsSince(sw);
+    TablesPtr tables = databaseModelM->getTables();
+    BenchResult("metadata", "connect_cold")
+        .add("tables", tables->getChildrenCount()).add("seconds", seconds)
+        .print();
+
+    sw.Start();
+    for (Tables::iterator it = tables->begin(); it != tables->end(); ++it)
+        (*it)->ensureChildrenLoaded();
+    seconds = secondsSince(sw);
+    BenchResult("metadata", "load_columns")
+        .add("tables", tables->getChildrenCount()).add("seconds", seconds)
+        .add("tables_per_second",
+            perSecond(tables->getChildrenCount(), seconds))
+        .print();
+
+    databaseModelM->disconnect();
+    sw.Start();
+    connectModel();
+    seconds = secondsSince(sw);
+    BenchResult("metadata", "connect_warm")
+        .add("tables", databaseModelM->getTables()->getChildrenCount())
+        .add("seconds", seconds)
+        .print();
+}
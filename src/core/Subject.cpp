@@ -38,10 +38,13 @@
 
 typedef std::list<Observer*> ObserverList;
 
+static unsigned long lastChangeStamp = 0;
+
 Subject::Subject()
 {
     locksCountM = 0;
     needsNotifyObjectsM = false;
+    changeStampM = ++lastChangeStamp;
 }
 
 Subject::~Subject()
@@ -93,8 +96,14 @@ bool Subject::isObservedBy(Observer* observer) const
         observersM.end(), observer);
 }
 
+unsigned long Subject::getChangeStamp() const
+{
+    return changeStampM;
+}
+
 void Subject::notifyObservers()
 {
+    changeStampM = ++lastChangeStamp;
     if (isLocked())
         needsNotifyObjectsM = true;
     else
@@ -37,6 +37,7 @@ private:
     unsigned int locksCountM;
     std::list<Observer*> observersM;
     bool needsNotifyObjectsM;
+    unsigned long changeStampM;
 
     void detachAllObservers();
     bool isObservedBy(Observer* observer) const;
@@ -55,6 +56,9 @@ public:
     void attachObserver(Observer* observer, bool callUpdate);
     void detachObserver(Observer* observer);
     void notifyObservers();
+    // increases on every notification, the values are unique over all
+    // subjects so a new subject never has the stamp of a previous one
+    unsigned long getChangeStamp() const;
 };
 
 class SubjectLocker
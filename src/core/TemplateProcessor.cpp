@@ -30,6 +30,9 @@
     #include "wx/wx.h"
 #endif
 
+#include <wx/datetime.h>
+#include <wx/hashmap.h>
+#include <wx/thread.h>
 #include <wx/tokenzr.h>
 
 #include "config/Config.h"
@@ -41,6 +44,216 @@
 #include "TemplateProcessor.h"
 
 #include <algorithm>
+#include <unordered_map>
+
+// Parsed form of a template text: literal text runs and commands with their
+// (still unexpanded) parameters, in order of appearance.
+class CompiledTemplate
+{
+public:
+    struct Node
+    {
+        bool isCommandM;
+        // literal text, or the command name for command nodes
+        wxString textM;
+        TemplateCmdParams paramsM;
+    };
+    std::vector<Node> nodesM;
+
+    CompiledTemplate(const wxString& inputText);
+private:
+    void addText(const wxString& text);
+    void addCommand(const wxString& cmd);
+};
+
+CompiledTemplate::CompiledTemplate(const wxString& inputText)
+{
+    // parse commands
+    wxString::size_type pos = 0, oldpos = 0, endpos = 0;
+    while (true)
+    {
+        pos = inputText.find("{%", pos);
+        if (pos == wxString::npos)
+        {
+            addText(inputText.substr(oldpos));
+            break;
+        }
+
+        wxString::size_type check, startpos = pos;
+        int cnt = 1;
+        while (cnt > 0)
+        {
+            endpos = inputText.find("%}", startpos+1);
+            if (endpos == wxString::npos)
+                break;
+
+            check = inputText.find("{%", startpos+1);
+            if (check == wxString::npos)
+                startpos = endpos;
+            else
+            {
+                startpos = (check < endpos ? check : endpos);
+                if (startpos == check)
+                    cnt++;
+            }
+            if (startpos == endpos)
+                cnt--;
+            startpos++;
+        }
+
+        if (cnt > 0)    // no matching closing %}
+            break;
+
+        addText(inputText.substr(oldpos, pos - oldpos));
+        addCommand(inputText.substr(pos + 2, endpos - pos - 2)); // 2 = start_marker_len = end_marker_len
+        oldpos = pos = endpos + 2;
+    }
+}
+
+void CompiledTemplate::addText(const wxString& text)
+{
+    if (text.empty())
+        return;
+    if (!nodesM.empty() && !nodesM.back().isCommandM)
+        nodesM.back().textM += text;
+    else
+    {
+        Node node;
+        node.isCommandM = false;
+        node.textM = text;
+        nodesM.push_back(node);
+    }
+}
+
+void CompiledTemplate::addCommand(const wxString& cmd)
+{
+    // parse command name and params.
+    TemplateCmdParams cmdParams;
+
+    enum TemplateCmdState
+    {
+        inText,
+        inString1,
+        inString2
+    };
+    TemplateCmdState state = inText;
+    wxString buffer;
+    unsigned int nestLevel = 0;
+    for (wxString::size_type i = 0; i < cmd.Length(); i++)
+    {
+        wxChar c = cmd[i];
+
+        if (c == ':')
+        {
+            if ((nestLevel == 0) && (state == inText))
+            {
+                cmdParams.Add(buffer);
+                buffer.Clear();
+                continue;
+            }
+        }
+        buffer += c;
+
+        if ((c == '{') && (i < cmd.Length() - 1) && (cmd[i + 1] == '%'))
+            nestLevel++;
+        else if ((c == '}') && (i > 0) && (cmd[i - 1] == '%'))
+            nestLevel--;
+        else if (c == '\'')
+            state == inString1 ? state = inText : state = inString1;
+        else if (c == '"')
+            state == inString2 ? state = inText : state = inString2;
+    }
+    if (buffer.Length() > 0)
+        cmdParams.Add(buffer);
+
+    if (cmdParams.Count() == 0 || cmdParams[0].IsEmpty())
+        return;
+
+    Node node;
+    node.isCommandM = true;
+    node.textM = cmdParams[0];
+    cmdParams.RemoveAt(0);
+    node.paramsM = cmdParams;
+    nodesM.push_back(node);
+}
+
+// Built-in commands, see TemplateProcessor::processCommand().
+enum BuiltinTemplateCmd
+{
+    cmdUnknown,
+    cmdComment,
+    cmdTemplateRoot,
+    cmdGetVar,
+    cmdSetVar,
+    cmdClearVar,
+    cmdClearVars,
+    cmdGetConf,
+    cmdSetConf,
+    cmdGetGlobalConf,
+    cmdAbort,
+    cmdParentWindow,
+    cmdColon,
+    cmdIf,
+    cmdIfEq,
+    cmdNot,
+    cmdIfContains,
+    cmdForAll,
+    cmdCountAll,
+    cmdAlternate,
+    cmdSubstr,
+    cmdUppercase,
+    cmdLowercase,
+    cmdWrap,
+    cmdKw,
+    cmdTab
+};
+
+// Returns cmdUnknown for unknown commands and for built-in commands given
+// too few parameters; both are passed on to the external handlers.
+static BuiltinTemplateCmd findBuiltinTemplateCmd(const wxString& cmdName,
+    size_t paramCount)
+{
+    struct CmdInfo
+    {
+        BuiltinTemplateCmd cmd;
+        size_t minParams;
+    };
+    typedef std::unordered_map<wxString, CmdInfo, wxStringHash, wxStringEqual>
+        CmdInfoMap;
+    static const CmdInfoMap builtins = {
+        { "--", { cmdComment, 0 } },
+        { "template_root", { cmdTemplateRoot, 0 } },
+        { "getvar", { cmdGetVar, 1 } },
+        { "setvar", { cmdSetVar, 1 } },
+        { "clearvar", { cmdClearVar, 1 } },
+        { "clearvars", { cmdClearVars, 0 } },
+        { "getconf", { cmdGetConf, 1 } },
+        { "setconf", { cmdSetConf, 1 } },
+        { "getglobalconf", { cmdGetGlobalConf, 1 } },
+        { "abort", { cmdAbort, 0 } },
+        { "parent_window", { cmdParentWindow, 0 } },
+        { "colon", { cmdColon, 0 } },
+        { "if", { cmdIf, 2 } },
+        { "ifeq", { cmdIfEq, 3 } },
+        { "!", { cmdNot, 1 } },
+        { "not", { cmdNot, 1 } },
+        { "ifcontains", { cmdIfContains, 3 } },
+        { "forall", { cmdForAll, 3 } },
+        { "countall", { cmdCountAll, 1 } },
+        { "alternate", { cmdAlternate, 2 } },
+        { "substr", { cmdSubstr, 3 } },
+        { "uppercase", { cmdUppercase, 1 } },
+        { "lowercase", { cmdLowercase, 1 } },
+        { "wrap", { cmdWrap, 1 } },
+        { "kw", { cmdKw, 1 } },
+        { "tab", { cmdTab, 0 } }
+    };
+
+    CmdInfoMap::const_iterator it = builtins.find(cmdName);
+    if (it == builtins.end() || paramCount < it->second.minParams)
+        return cmdUnknown;
+    return it->second.cmd;
+}
 
 TemplateProcessor::TemplateProcessor(ProcessableObject* object, wxWindow* window)
     : objectM(object), windowM(window)
@@ -51,54 +264,60 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
     const TemplateCmdParams& cmdParams, ProcessableObject* object,
     wxString& processedText)
 {
-    if (cmdName == "--")
-        // Comment.
-        ;
+    switch (findBuiltinTemplateCmd(cmdName, cmdParams.Count()))
+    {
+    // {%--:<text>%}
+    // Comment.
+    case cmdComment:
+        break;
 
     // {%template_root%}
     // Expands to the full path of the folder containing the currently
     // processed template, including the final path separator.
     // May expand to a blank string if the template being processed does
     // not come from a text file.
-    else if (cmdName == "template_root")
+    case cmdTemplateRoot:
         processedText += getTemplatePath();
+        break;
 
     // {%getvar:name%}
     // Expands to the value of the specified string variable, or a blank
     // string if the variable is not defined.
-    else if (cmdName == "getvar" && !cmdParams.IsEmpty())
+    case cmdGetVar:
         processedText += getVar(cmdParams.all());
+        break;
 
     // {%setvar:name:value%}
     // Sets the value of the specified variable and expands to a blank string.
     // If the variable is already defined overwrites it.
-    else if (cmdName == "setvar" && !cmdParams.IsEmpty())
-    {
+    case cmdSetVar:
         if (cmdParams.Count() == 1)
             clearVar(cmdParams[0]);
         else
             setVar(cmdParams[0], cmdParams[1]);
-    }
+        break;
 
     // {%clearvar:name%}
     // Sets the value of the specified variable to a blank string.
     // If the variable is not defined it does nothing.
     // Expands to a blank string.
-    else if (cmdName == "clearvar" && !cmdParams.IsEmpty())
+    case cmdClearVar:
         clearVar(cmdParams.all());
+        break;
 
     // {%clearvars%}
     // Sets all defined variables to blank strings.
     // Expands to a blank string.
-    else if (cmdName == "clearvars")
+    case cmdClearVars:
         clearVars();
+        break;
 
     // {%getconf:key:default%}
     // Expands to the value of the specified local config key,
     // or a blank string if the key is not found.
     // The local config is associated to the template - this is
     // not one of FlameRobin's global config files.
-    else if (cmdName == "getconf" && !cmdParams.IsEmpty())
+    case cmdGetConf:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams[0], object);
@@ -106,50 +325,53 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
         if (cmdParams.Count() > 1)
             defValue = cmdParams.from(1);
         processedText += configM.get(text, defValue);
+        break;
     }
 
     // {%setconf:key:value%}
     // Sets the value of the specified local config key.
     // If the key is already defined overwrites it.
     // Expands to a blank string.
-    else if (cmdName == "setconf" && !cmdParams.IsEmpty())
-    {
+    case cmdSetConf:
         if (cmdParams.Count() == 1)
             configM.setValue(cmdParams[0], wxString(""));
         else
             configM.setValue(cmdParams[0], cmdParams[1]);
-    }
+        break;
 
     // {%getglobalconf:key%}
     // Expands to the value of the specified global config key,
     // or a blank string if the key is not found.
-    else if (cmdName == "getglobalconf" && !cmdParams.IsEmpty())
+    case cmdGetGlobalConf:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams.all(), object);
         processedText += config().get(text, wxString(""));
+        break;
     }
 
     // {%abort%}
     // Throws a silent exception, interrupting the processing.
     // Expands to a blank string.
-    else if (cmdName == "abort")
+    case cmdAbort:
         throw FRAbort();
 
     // {%parent_window%}
     // Expands to the current window's numeric memory address.
     // Used to call FR's commands through URIs.
-    else if (cmdName == "parent_window")
+    case cmdParentWindow:
         processedText += wxString::Format("%p", windowM);
+        break;
 
     // {%colon%}
-    else if (cmdName == "colon")
+    case cmdColon:
         processedText += ":";
+        break;
 
     // {%if:<term>:<true output>[:<false output>]%}
     // If <term> equals true expands to <true output>, otherwise
     // expands to <false output> (or an empty string).
-    else if (cmdName == "if" && (cmdParams.Count() >= 2))
+    case cmdIf:
     {
         wxString val;
         internalProcessTemplateText(val, cmdParams[0], object);
@@ -163,12 +385,13 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             processedText += trueText;
         else
             processedText += falseText;
+        break;
     }
 
     // {%ifeq:<left term>:<right term>:<true output>[:<false output>]%}
     // If <left term> equals <right term> expands to <true output>, otherwise
     // expands to <false output> (or an empty string).
-    else if (cmdName == "ifeq" && (cmdParams.Count() >= 3))
+    case cmdIfEq:
     {
         wxString val1;
         internalProcessTemplateText(val1, cmdParams[0], object);
@@ -183,6 +406,7 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             processedText += trueText;
         else
             processedText += falseText;
+        break;
     }
 
     // {%!:<input>%} or {%not:<input>%}
@@ -190,7 +414,7 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
     // if <input> equals "false" returns "true";
     // otherwise returns <input>.
     // Always expands the argument before evaluating it.
-    else if ((cmdName == "!" || (cmdName == "not")) && (cmdParams.Count()))
+    case cmdNot:
     {
         wxString input;
         internalProcessTemplateText(input, cmdParams[0], object);
@@ -200,13 +424,14 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             processedText += getBooleanAsString(true);
         else
             processedText += input;
+        break;
     }
 
     // {%ifcontains:<list>:<term>:<true output>[:<false output>]%}
     // If <list> contains <term> expands to <true output>, otherwise
     // expands to <false output> (or an empty string).
     // <list> is a list of comma-separated values.
-    else if (cmdName == "ifcontains" && (cmdParams.Count() >= 3))
+    case cmdIfContains:
     {
         wxString listStr;
         internalProcessTemplateText(listStr, cmdParams[0], object);
@@ -224,6 +449,7 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             processedText += trueText;
         else
             processedText += falseText;
+        break;
     }
 
     // {%forall:<list>:<separator>:<text>%}
@@ -232,7 +458,7 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
     // <list> is a list of comma-separated values.
     // Inside <text> use the placeholder %%current_value%% to
     // mean the current string in the list.
-    else if (cmdName == "forall" && (cmdParams.Count() >= 3))
+    case cmdForAll:
     {
         wxString listStr;
         internalProcessTemplateText(listStr, cmdParams[0], object);
@@ -258,24 +484,26 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
                 firstItem = false;
             processedText += newText;
         }
+        break;
     }
 
     // {%countall:<list>%}
     // Expands to the number of strings in <list>.
     // <list> is a list of comma-separated values.
-    else if (cmdName == "countall" && (cmdParams.Count() >= 1))
+    case cmdCountAll:
     {
         wxString listStr;
         internalProcessTemplateText(listStr, cmdParams.all(), object);
         wxArrayString list(wxStringTokenize(listStr, ","));
         processedText << list.Count();
+        break;
     }
 
     // {%alternate:<text1>:<text2>%}
     // Alternates expanding to <text1> and <text2> at each call,
     // starting with <text1>.
     // Used to alternate table row colours, for example.
-    else if (cmdName == "alternate" && (cmdParams.Count() >= 2))
+    case cmdAlternate:
     {
         static bool first = false;
         first = !first;
@@ -283,13 +511,14 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             processedText += cmdParams[0];
         else
             processedText += cmdParams[1];
+        break;
     }
 
     // {%substr:<text>:<from>:<for>%}
     // Extracts a substring of <for> characters from <text>
     // starting at character <from>.
     // <from> defaults to 0. <for> defaults to <text>'s length minus 1.
-    else if (cmdName == "substr" && (cmdParams.Count() >= 3))
+    case cmdSubstr:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams[0], object);
@@ -305,26 +534,29 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             forI = text.Length() - 1;
 
         processedText += text.SubString(fromI, fromI + forI - 1);
+        break;
     }
 
     // {%uppercase:<text>%}
     // Converts <text> to upper case.
-    else if (cmdName == "uppercase" && (cmdParams.Count() >= 1))
+    case cmdUppercase:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams.all(), object);
 
         processedText += text.Upper();
+        break;
     }
 
     // {%lowercase:<text>%}
     // Converts <text> to lower case.
-    else if (cmdName == "lowercase" && (cmdParams.Count() >= 1))
+    case cmdLowercase:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams.all(), object);
 
         processedText += text.Lower();
+        break;
     }
 
     // {%wrap:<text>[:<width>[:<indent>]]%}
@@ -332,7 +564,7 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
     // resulting lines after the first one by <indent> chars.
     // <width> defaults to config item sqlEditorEdgeColumn, or 80.
     // <indent> defaults to config item sqlEditorTabSize, or 4.
-    else if (cmdName == "wrap" && (cmdParams.Count() >= 1))
+    case cmdWrap:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams[0], object);
@@ -360,12 +592,13 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             indentI = config().get("sqlEditorTabSize", 4);
 
         processedText += wrapText(text, widthI, indentI);
+        break;
     }
 
     // {%kw:<text>%}
     // Formats <text> as a keyword (upper or lower case)
     // according to config item SQLKeywordsUpperCase.
-    else if (cmdName == "kw" && (cmdParams.Count() >= 1))
+    case cmdKw:
     {
         wxString text;
         internalProcessTemplateText(text, cmdParams.all(), object);
@@ -374,119 +607,114 @@ void TemplateProcessor::processCommand(const wxString& cmdName,
             processedText += text.Upper();
         else
             processedText += text.Lower();
+        break;
     }
 
     // {%tab%}
     // Expands to a number of spaces defined by config item
     // sqlEditorTabSize.
-    else if (cmdName == "tab")
+    case cmdTab:
     {
         wxString tab;
         processedText += tab.Pad(config().get("sqlEditorTabSize", 4));
+        break;
     }
 
     // Only if no internal commands are recognized, call external command handlers.
-    else
-    {
+    default:
         getTemplateCmdHandlerRepository().handleTemplateCmd(this, cmdName,
            cmdParams, object, processedText);
+        break;
     }
 }
 
-void TemplateProcessor::internalProcessTemplateText(wxString& processedText,
-    const wxString& inputText, ProcessableObject* object)
+std::shared_ptr<const CompiledTemplate> TemplateProcessor::getCompiledTemplate(
+    const wxString& inputText)
 {
-    if (object == 0)
-        object = objectM;
+    typedef std::unordered_map<wxString, std::shared_ptr<const CompiledTemplate>,
+        wxStringHash, wxStringEqual> CompiledTemplateMap;
+    // Nested command parameters are compiled (and cached) separately, and
+    // {%forall%} creates a new text per list item, so the cache is simply
+    // emptied once it grows too large.
+    static const size_t maxCachedTemplates = 4096;
+    static CompiledTemplateMap cache;
+    static wxMutex mutex;
 
-    // parse commands
-    wxString::size_type pos = 0, oldpos = 0, endpos = 0;
-    while (true)
     {
-        pos = inputText.find("{%", pos);
-        if (pos == wxString::npos)
-        {
-            processedText += inputText.substr(oldpos);
-            break;
-        }
+        wxMutexLocker lock(mutex);
+        CompiledTemplateMap::const_iterator it = cache.find(inputText);
+        if (it != cache.end())
+            return it->second;
+    }
 
-        wxString::size_type check, startpos = pos;
-        int cnt = 1;
-        while (cnt > 0)
-        {
-            endpos = inputText.find("%}", startpos+1);
-            if (endpos == wxString::npos)
-                break;
+    std::shared_ptr<const CompiledTemplate> compiled(
+        std::make_shared<CompiledTemplate>(inputText));
 
-            check = inputText.find("{%", startpos+1);
-            if (check == wxString::npos)
-                startpos = endpos;
-            else
-            {
-                startpos = (check < endpos ? check : endpos);
-                if (startpos == check)
-                    cnt++;
-            }
-            if (startpos == endpos)
-                cnt--;
-            startpos++;
-        }
+    wxMutexLocker lock(mutex);
+    if (cache.size() >= maxCachedTemplates)
+        cache.clear();
+    cache[inputText] = compiled;
+    return compiled;
+}
 
-        if (cnt > 0)    // no matching closing %}
-            break;
+void TemplateProcessor::internalProcessTemplateText(wxString& processedText,
+    const wxString& inputText, ProcessableObject* object)
+{
+    if (object == 0)
+        object = objectM;
 
-        processedText += inputText.substr(oldpos, pos - oldpos);
-        wxString cmd = inputText.substr(pos + 2, endpos - pos - 2); // 2 = start_marker_len = end_marker_len
+    // plain text needs neither parsing nor caching
+    if (inputText.find("{%") == wxString::npos)
+    {
+        processedText += inputText;
+        return;
+    }
 
-        // parse command name and params.
-        wxString cmdName;
-        TemplateCmdParams cmdParams;
+    std::shared_ptr<const CompiledTemplate> compiled(
+        getCompiledTemplate(inputText));
+    for (std::vector<CompiledTemplate::Node>::const_iterator it =
+        compiled->nodesM.begin(); it != compiled->nodesM.end(); ++it)
+    {
+        if (it->isCommandM)
+            processCommand(it->textM, it->paramsM, object, processedText);
+        else
+            processedText += it->textM;
+    }
+}
 
-        enum TemplateCmdState
-        {
-            inText,
-            inString1,
-            inString2
-        };
-        TemplateCmdState state = inText;
-        wxString buffer;
-        unsigned int nestLevel = 0;
-        for (wxString::size_type i = 0; i < cmd.Length(); i++)
-        {
-            wxChar c = cmd[i];
+// Returns the contents of the template file, re-reading it only when its
+// modification time has changed since the last call.
+static wxString loadTemplateFile(const wxFileName& fileName)
+{
+    struct CachedFile
+    {
+        wxDateTime modifiedM;
+        wxString textM;
+    };
+    static std::map<wxString, CachedFile> files;
+    static wxMutex mutex;
+
+    wxDateTime modified;
+    if (fileName.FileExists())
+        modified = fileName.GetModificationTime();
+    if (!modified.IsValid())
+        return loadEntireFile(fileName);
+
+    wxString path(fileName.GetFullPath());
+    {
+        wxMutexLocker lock(mutex);
+        std::map<wxString, CachedFile>::const_iterator it = files.find(path);
+        if (it != files.end() && it->second.modifiedM == modified)
+            return it->second.textM;
+    }
 
-            if (c == ':')
-            {
-                if ((nestLevel == 0) && (state == inText))
-                {
-                    cmdParams.Add(buffer);
-                    buffer.Clear();
-                    continue;
-                }
-            }
-            buffer += c;
-
-            if ((c == '{') && (i < cmd.Length() - 1) && (cmd[i + 1] == '%'))
-                nestLevel++;
-            else if ((c == '}') && (i > 0) && (cmd[i - 1] == '%'))
-                nestLevel--;
-            else if (c == '\'')
-                state == inString1 ? state = inText : state = inString1;
-            else if (c == '"')
-                state == inString2 ? state = inText : state = inString2;
-        }
-        if (buffer.Length() > 0)
-            cmdParams.Add(buffer);
+    CachedFile file;
+    file.modifiedM = modified;
+    file.textM = loadEntireFile(fileName);
 
-        if (cmdParams.Count() > 0)
-        {
-            cmdName = cmdParams[0];
-            cmdParams.RemoveAt(0);
-            if (!cmdName.IsEmpty())
-                processCommand(cmdName, cmdParams, object, processedText);
-        }
-        oldpos = pos = endpos + 2;
-    }
+    wxMutexLocker lock(mutex);
+    files[path] = file;
+    return file.textM;
 }
 
 void TemplateProcessor::processTemplateFile(wxString& processedText,
@@ -498,16 +726,23 @@ void TemplateProcessor::processTemplateFile(wxString& processedText,
     wxFileName infoFileName(inputFileName);
     infoFileName.SetExt("info");
     infoM.setConfigFileName(infoFileName);
+    configM.setConfigFileName(getConfigFileName(inputFileName));
+    progressIndicatorM = progressIndicator;
+    internalProcessTemplateText(processedText, loadTemplateFile(fileNameM),
+        object);
+}
+
+/*static*/
+wxFileName TemplateProcessor::getConfigFileName(
+    const wxFileName& templateFileName)
+{
     // put settings file in user writable directory
-    wxString confFileNameStr(inputFileName.GetFullPath());
+    wxString confFileNameStr(templateFileName.GetFullPath());
     confFileNameStr.Replace(config().getHomePath(),
         config().getUserHomePath(), false);
     wxFileName confFileName(confFileNameStr);
     confFileName.SetExt("conf");
-    configM.setConfigFileName(confFileName);
-    progressIndicatorM = progressIndicator;
-    internalProcessTemplateText(processedText, loadEntireFile(fileNameM),
-        object);
+    return confFileName;
 }
 
 void TemplateProcessor::processTemplateText(wxString& processedText,
@@ -602,13 +837,33 @@ void TemplateCmdHandlerRepository::handleTemplateCmd(TemplateProcessor *tp,
     const wxString& cmdName, const TemplateCmdParams& cmdParams,
     ProcessableObject* object, wxString& processedText)
 {
+    const HandlerVector& handlers = getHandlersFor(cmdName);
+    for (HandlerVector::const_iterator it = handlers.begin();
+        it != handlers.end(); ++it)
+    {
+        (*it)->handleTemplateCmd(tp, cmdName, cmdParams, object,
+            processedText);
+    }
+}
+
+const TemplateCmdHandlerRepository::HandlerVector&
+    TemplateCmdHandlerRepository::getHandlersFor(const wxString& cmdName)
+{
+    wxMutexLocker lock(dispatchMutexM);
+    std::map<wxString, HandlerVector>::const_iterator found =
+        dispatchM.find(cmdName);
+    if (found != dispatchM.end())
+        return found->second;
+
     checkHandlerListSorted();
+    HandlerVector& handlers = dispatchM[cmdName];
     for (std::list<TemplateCmdHandler*>::iterator it = handlersM.begin();
         it != handlersM.end(); ++it)
     {
-        (*it)->handleTemplateCmd(tp, cmdName, cmdParams, object,
-            processedText);
+        if ((*it)->handlesCommand(cmdName))
+            handlers.push_back(*it);
     }
+    return handlers;
 }
 
 void TemplateCmdHandlerRepository::addHandler(TemplateCmdHandler* handler)
@@ -617,15 +872,19 @@ void TemplateCmdHandlerRepository::addHandler(TemplateCmdHandler* handler)
     // serves TemplateCmdHandler::operator< is virtual, and this function (addHandler)
     // is called in the constructor of TemplateCmdHandler.
     // The list will be sorted on demand (see checkHandlerListSorted()).
+    wxMutexLocker lock(dispatchMutexM);
     handlersM.push_back(handler);
     handler->setRepository(this);
     handlerListSortedM = false;
+    dispatchM.clear();
 }
 
 void TemplateCmdHandlerRepository::removeHandler(TemplateCmdHandler* handler)
 {
+    wxMutexLocker lock(dispatchMutexM);
     handlersM.erase(std::find(handlersM.begin(), handlersM.end(), handler));
     handler->setRepository(0);
+    dispatchM.clear();
 }
 
 TemplateCmdHandler::TemplateCmdHandler() :
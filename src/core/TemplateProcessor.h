@@ -27,9 +27,12 @@
 
 #include <wx/filename.h>
 #include <wx/arrstr.h>
+#include <wx/thread.h>
 
 #include <list>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "config/Config.h"
 #include "core/ProcessableObject.h"
@@ -48,6 +51,7 @@ public:
 typedef std::map<wxString, wxString> wxStringMap;
 
 class TemplateCmdHandler;
+class CompiledTemplate;
 
 class TemplateProcessor
 {
@@ -60,6 +64,11 @@ private:
     Config configM;
     Config infoM;
     wxWindow* windowM;
+
+    // Returns the parsed form of inputText, compiling it on first use.
+    // Compiled templates are shared by all processor instances.
+    static std::shared_ptr<const CompiledTemplate> getCompiledTemplate(
+        const wxString& inputText);
 protected:
     TemplateProcessor(ProcessableObject* object, wxWindow* window);
     // Processes a command found in template text
@@ -68,11 +77,19 @@ protected:
         wxString& processedText);
     // Returns the loaded file's path, including the trailing separator.
     wxString getTemplatePath();
+    // Returns the object passed to the constructor.
+    ProcessableObject* getObject() const { return objectM; }
 public:
     wxWindow* getWindow() { return windowM; };
     // Returns a reference to the current progress indicator, so that
     // external command handlers can use it.
     ProgressIndicator* getProgressIndicator() { return progressIndicatorM; };
+    // Replaces the progress indicator passed to processTemplateFile(), for
+    // processors that are kept around to process more text later.
+    void setProgressIndicator(ProgressIndicator* progressIndicator)
+    {
+        progressIndicatorM = progressIndicator;
+    }
     // Processes all known commands found in template text
     // commands are in format: {%cmdName:cmdParams%}
     // cmdParams field may be empty, in which case the format is {%cmdName*}
@@ -94,6 +111,9 @@ public:
     // The internal config object, used to store user-supplied parameters in
     // interactive templates.
     Config& getConfig() { return configM; }
+    // Name of the file getConfig() uses for a template file, in the user
+    // writable directory.
+    static wxFileName getConfigFileName(const wxFileName& templateFileName);
     // The template info config object, used to store template metadata such as
     // title, position in menu, etc.
     Config& getInfo() { return infoM; }
@@ -127,6 +147,12 @@ private:
     bool handlerListSortedM;
     void checkHandlerListSorted();
 
+    // Handlers interested in a command, resolved once per command name.
+    typedef std::vector<TemplateCmdHandler*> HandlerVector;
+    std::map<wxString, HandlerVector> dispatchM;
+    wxMutex dispatchMutexM;
+    const HandlerVector& getHandlersFor(const wxString& cmdName);
+
     // only getTemplateCmdHandlerRepository() may instantiate an object of this class.
     friend TemplateCmdHandlerRepository& getTemplateCmdHandlerRepository();
 
@@ -150,6 +176,13 @@ public:
     virtual void handleTemplateCmd(TemplateProcessor* tp,
         const wxString& cmdName, const TemplateCmdParams& cmdParams,
         ProcessableObject* object, wxString& processedText) = 0;
+    // Returns false for commands this handler never processes. The
+    // repository caches the answer per command name, so handlers that
+    // can't match are skipped without being called.
+    virtual bool handlesCommand(const wxString& /*cmdName*/) const
+    {
+        return true;
+    }
 
     bool operator<(const TemplateCmdHandler& right) const
     {
@@ -30,9 +30,16 @@
     #include "wx/wx.h"
 #endif
 
+#include <wx/stopwatch.h>
+
 #include "engine/MetadataLoader.h"
 #include "metadata/database.h"
 
+MetadataLoader::Statistics::Statistics()
+    : hits(0), misses(0), evictions(0), prepares(0), prepareTime(0)
+{
+}
+
 MetadataLoader::MetadataLoader(Database& database, unsigned maxStatements)
     : databaseM(database.getIBPPDatabase()), transactionM(),
         transactionLevelM(0), statementsM(), maxStatementsM(maxStatements)
@@ -54,6 +61,9 @@ void MetadataLoader::transactionStart()
         }
         catch (IBPP::LogicException&)
         {
+            // the cached statements belong to the old transaction
+            statementIndexM.clear();
+            statementsM.clear();
             transactionM = 0;
         }
     }
@@ -66,12 +76,12 @@ void MetadataLoader::transactionStart()
 
 void MetadataLoader::transactionCommit()
 {
+    // the transaction object is kept, so that the prepared statements
+    // attached to it can be executed again in the next transaction;
+    // the commit closes their cursors on the server, and IBPP marks them
+    // closed so that the next Execute() doesn't try to close them again
     if (--transactionLevelM == 0 && transactionM != 0)
-    {
-        statementsM.clear();
         transactionM->Commit();
-        transactionM = 0;
-    }
 }
 
 bool MetadataLoader::transactionStarted()
@@ -79,22 +89,30 @@ bool MetadataLoader::transactionStarted()
     return (transactionM != 0 && transactionM->Started());
 }
 
+IBPP::Statement MetadataLoader::prepareStatement(const std::string& sql)
+{
+    wxStopWatch sw;
+    IBPP::Statement stmt = IBPP::StatementFactory(databaseM, transactionM,
+        sql);
+    ++statisticsM.prepares;
+    statisticsM.prepareTime += sw.TimeInMicro().GetValue();
+    return stmt;
+}
+
 IBPP::Statement MetadataLoader::createStatement(const std::string& sql)
 {
     wxASSERT(transactionStarted());
 
-    return IBPP::StatementFactory(databaseM, transactionM, sql);
+    return prepareStatement(sql);
 }
 
 MetadataLoader::IBPPStatementListIterator MetadataLoader::findStatement(
     const std::string& sql)
 {
-    for (IBPPStatementListIterator it = statementsM.begin();
-        it != statementsM.end(); ++it)
-    {
-        if ((*it)->Sql() == sql)
-            return it;
-    }
+    std::unordered_map<std::string, IBPPStatementListIterator>::iterator it =
+        statementIndexM.find(sql);
+    if (it != statementIndexM.end())
+        return (*it).second;
     return statementsM.end();
 }
 
@@ -102,18 +120,18 @@ IBPP::Statement& MetadataLoader::getStatement(const std::string& sql)
 {
     wxASSERT(transactionStarted());
 
-    IBPP::Statement stmt;
     IBPPStatementListIterator it = findStatement(sql);
     if (it != statementsM.end())
     {
-        stmt = (*it);
-        statementsM.erase(it);
-    }
-    else
-    {
-        stmt = IBPP::StatementFactory(databaseM, transactionM, sql);
+        ++statisticsM.hits;
+        // move to the front, iterators and references stay valid
+        statementsM.splice(statementsM.begin(), statementsM, it);
+        return statementsM.front();
     }
-    statementsM.push_front(stmt);
+
+    ++statisticsM.misses;
+    statementsM.push_front(prepareStatement(sql));
+    statementIndexM[sql] = statementsM.begin();
     limitListSize();
     return statementsM.front();
 }
@@ -123,12 +141,17 @@ void MetadataLoader::limitListSize()
     if (maxStatementsM)
     {
         while (statementsM.size() > maxStatementsM)
-            statementsM.remove(statementsM.back());
+        {
+            statementIndexM.erase(statementsM.back()->Sql());
+            statementsM.pop_back();
+            ++statisticsM.evictions;
+        }
     }
 }
 
 void MetadataLoader::releaseStatements()
 {
+    statementIndexM.clear();
     statementsM.clear();
     if (transactionM != 0 && transactionM->Started())
     {
@@ -146,6 +169,21 @@ void MetadataLoader::setMaximumConcurrentStatements(unsigned count)
     }
 }
 
+const MetadataLoader::Statistics& MetadataLoader::getStatistics() const
+{
+    return statisticsM;
+}
+
+size_t MetadataLoader::getCachedStatementCount() const
+{
+    return statementsM.size();
+}
+
+unsigned MetadataLoader::getMaximumConcurrentStatements() const
+{
+    return maxStatementsM;
+}
+
 IBPP::Blob MetadataLoader::createBlob()
 {
     wxASSERT(transactionStarted());
@@ -26,6 +26,7 @@
 
 #include <list>
 #include <string>
+#include <unordered_map>
 
 #include <ibpp.h>
 
@@ -34,6 +35,19 @@ class MetadataLoaderTransaction;
 
 class MetadataLoader
 {
+public:
+    // counters of the prepared statement cache, prepare time is the total
+    // time spent in preparing statements in microseconds
+    struct Statistics
+    {
+        Statistics();
+
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long evictions;
+        unsigned long prepares;
+        long long prepareTime;
+    };
 private:
     typedef std::list<IBPP::Statement> IBPPStatementList;
     typedef std::list<IBPP::Statement>::iterator IBPPStatementListIterator;
@@ -44,13 +58,20 @@ private:
     IBPP::Transaction transactionM;
     unsigned transactionLevelM;
 
-    std::list<IBPP::Statement> statementsM;
+    // prepared statements, most recently used first, with an index keyed
+    // by the SQL text; the statements stay attached to transactionM,
+    // which is restarted for every metadata transaction, so they survive
+    // the commit of the transaction
+    IBPPStatementList statementsM;
+    std::unordered_map<std::string, IBPPStatementListIterator> statementIndexM;
     unsigned maxStatementsM;
+    Statistics statisticsM;
     // Returns an iterator to the prepared IBPP::Statement object
     // for the sql statement if available, else returns statementsM.end().
     IBPPStatementListIterator findStatement(const std::string& sql);
     // Releases any assigned statement objects beyond the list size limit.
     void limitListSize();
+    IBPP::Statement prepareStatement(const std::string& sql);
 
     // A read-only transaction is used to read metadata from the database.
     // The first call of transactionStart() starts the transaction, further
@@ -92,6 +113,10 @@ public:
     // server ressources!
     void setMaximumConcurrentStatements(unsigned count);
 
+    const Statistics& getStatistics() const;
+    size_t getCachedStatementCount() const;
+    unsigned getMaximumConcurrentStatements() const;
+
     // Creates an IBPP::Blob object using the database and transaction
     IBPP::Blob createBlob();
 };
@@ -0,0 +1,231 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+#include <wx/textfile.h>
+
+#include "engine/StatementProfiler.h"
+
+StatementProfile::StatementProfile()
+    : id(0), succeeded(false), prepareTime(-1), executeTime(-1),
+      firstRowsTime(-1), fetchTime(-1), rows(-1), bytes(0), rowSize(0),
+      hasCounts(false), fetches(0), marks(0), reads(0), writes(0)
+{
+}
+
+double StatementProfile::getRowsPerSecond() const
+{
+    long elapsed = (fetchTime >= 0) ? fetchTime : firstRowsTime;
+    if (rows <= 0 || elapsed < 0)
+        return 0;
+    // anything below one millisecond is measured as 0
+    return rows * 1000.0 / (elapsed > 0 ? elapsed : 1);
+}
+
+int StatementProfile::getIndexedReads() const
+{
+    int sum = 0;
+    for (std::vector<ProfileTableCounts>::const_iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        sum += (*it).indexedReads;
+    }
+    return sum;
+}
+
+int StatementProfile::getNaturalReads() const
+{
+    int sum = 0;
+    for (std::vector<ProfileTableCounts>::const_iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        sum += (*it).naturalReads;
+    }
+    return sum;
+}
+
+StatementProfiler::StatementProfiler()
+    : nextIdM(1), maxProfilesM(1000)
+{
+}
+
+/*static*/
+StatementProfiler& StatementProfiler::get()
+{
+    static StatementProfiler profiler;
+    return profiler;
+}
+
+unsigned StatementProfiler::add(const StatementProfile& profile)
+{
+    if (profilesM.size() >= maxProfilesM)
+        profilesM.pop_front();
+    profilesM.push_back(profile);
+    profilesM.back().id = nextIdM;
+    return nextIdM++;
+}
+
+StatementProfile* StatementProfiler::find(unsigned id)
+{
+    // ids are assigned in ascending order and profiles are only removed
+    // from the front, so the position follows from the first id
+    if (id == 0 || profilesM.empty() || id < profilesM.front().id)
+        return 0;
+    size_t index = id - profilesM.front().id;
+    if (index >= profilesM.size())
+        return 0;
+    return &profilesM[index];
+}
+
+size_t StatementProfiler::size() const
+{
+    return profilesM.size();
+}
+
+const StatementProfile& StatementProfiler::getProfile(size_t index) const
+{
+    return profilesM[index];
+}
+
+void StatementProfiler::clear()
+{
+    profilesM.clear();
+}
+
+static wxString quoteCsv(const wxString& s)
+{
+    wxString result(s);
+    result.Replace("\"", "\"\"");
+    return "\"" + result + "\"";
+}
+
+static wxString quoteJson(const wxString& s)
+{
+    wxString result("\"");
+    for (wxString::const_iterator it = s.begin(); it != s.end(); ++it)
+    {
+        wxUniChar c = *it;
+        switch (c.GetValue())
+        {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (c.GetValue() < 0x20)
+                    result += wxString::Format("\\u%04x", int(c.GetValue()));
+                else
+                    result += c;
+        }
+    }
+    return result + "\"";
+}
+
+static wxString formatTimestamp(const wxDateTime& dt)
+{
+    return dt.IsValid() ? dt.Format("%Y-%m-%dT%H:%M:%S") : wxString();
+}
+
+static bool writeUtf8File(const wxString& fileName, const wxString& contents)
+{
+    wxFFile file(fileName, "wb");
+    if (!file.IsOpened())
+        return false;
+    return file.Write(contents, wxConvUTF8) && file.Close();
+}
+
+bool StatementProfiler::exportCsv(const wxString& fileName) const
+{
+    wxString eol(wxTextFile::GetEOL());
+    wxString csv("id,executed_at,database,succeeded,prepare_ms,execute_ms,"
+        "first_rows_ms,fetch_ms,rows,rows_per_second,bytes,fetches,marks,"
+        "reads,writes,indexed_reads,natural_reads,sql" + eol);
+    for (std::deque<StatementProfile>::const_iterator it = profilesM.begin();
+        it != profilesM.end(); ++it)
+    {
+        const StatementProfile& p = *it;
+        csv += wxString::Format("%u,%s,%s,%d,%ld,%ld,%ld,%ld,%ld,%.1f,%s,",
+            p.id, formatTimestamp(p.executedAt), quoteCsv(p.databaseName),
+            p.succeeded ? 1 : 0, p.prepareTime, p.executeTime,
+            p.firstRowsTime, p.fetchTime, p.rows, p.getRowsPerSecond(),
+            p.bytes.ToString());
+        if (p.hasCounts)
+        {
+            csv += wxString::Format("%d,%d,%d,%d,%d,%d,", p.fetches, p.marks,
+                p.reads, p.writes, p.getIndexedReads(), p.getNaturalReads());
+        }
+        else
+            csv += ",,,,,,";
+        csv += quoteCsv(p.sql) + eol;
+    }
+    return writeUtf8File(fileName, csv);
+}
+
+bool StatementProfiler::exportJson(const wxString& fileName) const
+{
+    wxString json("[");
+    for (std::deque<StatementProfile>::const_iterator it = profilesM.begin();
+        it != profilesM.end(); ++it)
+    {
+        const StatementProfile& p = *it;
+        if (it != profilesM.begin())
+            json += ",";
+        json += wxString::Format("\n  {\"id\": %u, \"executed_at\": %s, "
+            "\"database\": %s, \"succeeded\": %s, \"prepare_ms\": %ld, "
+            "\"execute_ms\": %ld, \"first_rows_ms\": %ld, \"fetch_ms\": %ld, "
+            "\"rows\": %ld, \"rows_per_second\": %.1f, \"bytes\": %s",
+            p.id, quoteJson(formatTimestamp(p.executedAt)),
+            quoteJson(p.databaseName), p.succeeded ? "true" : "false",
+            p.prepareTime, p.executeTime, p.firstRowsTime, p.fetchTime,
+            p.rows, p.getRowsPerSecond(), p.bytes.ToString());
+        if (p.hasCounts)
+        {
+            json += wxString::Format(", \"fetches\": %d, \"marks\": %d, "
+                "\"reads\": %d, \"writes\": %d, \"tables\": [",
+                p.fetches, p.marks, p.reads, p.writes);
+            for (size_t i = 0; i < p.tables.size(); ++i)
+            {
+                const ProfileTableCounts& t = p.tables[i];
+                if (i)
+                    json += ", ";
+                json += wxString::Format("{\"relation\": %s, "
+                    "\"indexed_reads\": %d, \"natural_reads\": %d, "
+                    "\"inserts\": %d, \"updates\": %d, \"deletes\": %d}",
+                    quoteJson(t.relationName), t.indexedReads,
+                    t.naturalReads, t.inserts, t.updates, t.deletes);
+            }
+            json += "]";
+        }
+        json += ", \"sql\": " + quoteJson(p.sql) + "}";
+    }
+    json += "\n]\n";
+    return writeUtf8File(fileName, json);
+}
@@ -0,0 +1,104 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef FR_STATEMENTPROFILER_H
+#define FR_STATEMENTPROFILER_H
+
+#include <wx/datetime.h>
+
+#include <deque>
+#include <vector>
+
+// Per-relation counter deltas of a single statement execution, as reported
+// by IBPP::IDatabase::DetailedCounts().
+struct ProfileTableCounts
+{
+    int relationId;
+    wxString relationName;
+    int indexedReads;
+    int naturalReads;
+    int inserts;
+    int updates;
+    int deletes;
+};
+
+// Timing and server counter breakdown of a single statement execution.
+// Times are in milliseconds, -1 means the value is not (yet) known.
+struct StatementProfile
+{
+    StatementProfile();
+
+    unsigned id;
+    wxDateTime executedAt;
+    wxString databaseName;
+    wxString sql;
+    bool succeeded;
+
+    long prepareTime;
+    long executeTime;
+    long firstRowsTime;     // execute to first batch of rows in the grid
+    long fetchTime;         // execute to last row fetched
+    long rows;
+    wxLongLong bytes;       // estimated from the column buffer sizes
+    int rowSize;
+
+    bool hasCounts;
+    int fetches;
+    int marks;
+    int reads;
+    int writes;
+    std::vector<ProfileTableCounts> tables;
+
+    double getRowsPerSecond() const;
+    int getIndexedReads() const;
+    int getNaturalReads() const;
+};
+
+// Keeps the profiles of the statements executed in this session, the
+// oldest ones are dropped once maxProfiles is reached.
+class StatementProfiler
+{
+private:
+    std::deque<StatementProfile> profilesM;
+    unsigned nextIdM;
+    size_t maxProfilesM;
+
+    StatementProfiler();
+public:
+    static StatementProfiler& get();
+
+    // stores a copy of profile and returns the id assigned to it
+    unsigned add(const StatementProfile& profile);
+    // returns 0 if the profile has been dropped or cleared meanwhile
+    StatementProfile* find(unsigned id);
+
+    size_t size() const;
+    const StatementProfile& getProfile(size_t index) const;
+    void clear();
+
+    bool exportCsv(const wxString& fileName) const;
+    bool exportJson(const wxString& fileName) const;
+};
+
+#endif // FR_STATEMENTPROFILER_H
@@ -318,19 +318,58 @@ void AdvancedSearchFrame::addResult(Database* db, MetadataItem* item)
     listctrl_results->GetEventHandler()->AddPendingEvent(ev);
 }
 
-// returns true if "text" matches all criteria of type "type"
-bool AdvancedSearchFrame::match(CriteriaItem::Type type, const wxString& text)
+static MetadataSearchIndex::Aspect getSearchAspect(CriteriaItem::Type type)
 {
+    switch (type)
+    {
+        case CriteriaItem::ctDescription:
+            return MetadataSearchIndex::aDescription;
+        case CriteriaItem::ctDDL:
+            return MetadataSearchIndex::aDDL;
+        case CriteriaItem::ctField:
+            return MetadataSearchIndex::aField;
+        default:
+            return MetadataSearchIndex::aName;
+    }
+}
+
+// returns true if the indexed text of "item" matches any criteria of
+// type "type", or if there are no criteria of that type
+bool AdvancedSearchFrame::match(const MetadataSearchIndex& index,
+    MetadataItem* item, CriteriaItem::Type type)
+{
+    if (searchCriteriaM.count(type) == 0)
+        return true;
     for (CriteriaCollection::const_iterator ci =
         searchCriteriaM.lower_bound(type); ci !=
         searchCriteriaM.upper_bound(type); ++ci)
     {
-        if (text.Upper().Matches((*ci).second.value))
+        if (index.matches(item, getSearchAspect(type), (*ci).second.value))
             return true;
     }
     return false;
 }
 
+// collects the objects which may match any criteria of type "type",
+// returns false if the criteria can't be used to narrow down the objects
+bool AdvancedSearchFrame::getCandidates(const MetadataSearchIndex& index,
+    CriteriaItem::Type type, MetadataSearchIndex::Items& candidates)
+{
+    if (searchCriteriaM.count(type) == 0)
+        return false;
+    for (CriteriaCollection::const_iterator ci =
+        searchCriteriaM.lower_bound(type); ci !=
+        searchCriteriaM.upper_bound(type); ++ci)
+    {
+        if (!index.addCandidates(getSearchAspect(type), (*ci).second.value,
+            candidates))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 // OBSERVER functions
 void AdvancedSearchFrame::update()
 {
@@ -538,6 +577,17 @@ void AdvancedSearchFrame::OnButtonStartClick(wxCommandEvent& WXUNUSED(event))
         }
     }
 
+    // texts of the objects that need to be indexed
+    unsigned aspects = 0;
+    for (int t = CriteriaItem::ctName; t <= CriteriaItem::ctField; ++t)
+    {
+        if (searchCriteriaM.count(CriteriaItem::Type(t)) != 0)
+        {
+            aspects |= MetadataSearchIndex::aspectFlag(
+                getSearchAspect(CriteriaItem::Type(t)));
+        }
+    }
+
     int database_count = 0;
     for (CriteriaCollection::const_iterator
         cid = searchCriteriaM.lower_bound(CriteriaItem::ctDB);
@@ -561,75 +611,85 @@ void AdvancedSearchFrame::OnButtonStartClick(wxCommandEvent& WXUNUSED(event))
         if (!db->isConnected() && !connectDatabase(db, this, &pd))
             continue;
 
+        // searching in DDL or fields loads every relation, so load all of
+        // them with a few set-based queries instead of one by one
+        bool searchRelations = types.empty()
+            || types.count(ntTable) || types.count(ntGTT)
+            || types.count(ntView) || types.count(ntSysTable);
+        try
+        {
+            if (searchRelations
+                && searchCriteriaM.count(CriteriaItem::ctDDL) > 0)
+            {
+                db->prefetchMetadata(&pd);
+            }
+            else if (searchRelations
+                && searchCriteriaM.count(CriteriaItem::ctField) > 0)
+            {
+                db->prefetchRelationColumns(&pd);
+            }
+        }
+        catch (CancelProgressException&)
+        {
+            return;
+        }
+
         pd.initProgress(_("Searching database: ")+db->getName_(),
             database_count, current++, 1);
 
-        std::vector<MetadataItem *> colls;
-        db->getCollections(colls, false);   // false = not system objects
-        for (std::vector<MetadataItem *>::iterator col = colls.begin(); col !=
-            colls.end(); ++col)
+        // the index is kept by the database between searches, only the
+        // objects which have changed since the last search are indexed again
+        MetadataSearchIndex& index = db->getSearchIndex();
+        try
         {
-            std::vector<MetadataItem *> ch;
-            (*col)->getChildren(ch);
-            pd.initProgress(wxEmptyString, ch.size(), 0, 2);
-            for (std::vector<MetadataItem *>::iterator it = ch.begin(); it !=
-                ch.end(); ++it)
+            index.update(*db, aspects, types, &pd);
+        }
+        catch (CancelProgressException&)
+        {
+            return;
+        }
+
+        // look up the objects that can match in the index tokens
+        MetadataSearchIndex::Items candidates;
+        bool useCandidates = false;
+        for (int t = CriteriaItem::ctName; t <= CriteriaItem::ctField; ++t)
+        {
+            MetadataSearchIndex::Items found;
+            if (!getCandidates(index, CriteriaItem::Type(t), found))
+                continue;
+            if (!useCandidates)
             {
-                if (!types.empty() &&
-                    types.find((*it)->getType()) == types.end())
-                    break;
-                pd.setProgressMessage(_("Searching ") + (*col)->getName_() +
-                    ": " + (*it)->getName_(), 2);
-                pd.stepProgress(1, 2);
-                if (pd.isCanceled())
-                    return;
-                if (searchCriteriaM.count(CriteriaItem::ctName) > 0)
-                {
-                    wxString name = (*it)->getName_();
-                    if (!match(CriteriaItem::ctName, name))
-                        continue;
-                }
-                if (searchCriteriaM.count(CriteriaItem::ctDescription) > 0)
-                {
-                    wxString desc;
-                    if (!(*it)->getDescription(desc))
-                        continue;
-                    if (!match(CriteriaItem::ctDescription, desc))
-                        continue;
-                }
-                if (searchCriteriaM.count(CriteriaItem::ctDDL) > 0)
-                {
-                    // TODO: add ProgressDialog, and link it up in here
-                    CreateDDLVisitor cdv;
-                    (*it)->acceptVisitor(&cdv);
-                    if (!match(CriteriaItem::ctDDL, cdv.getSql()))
-                        continue;
-                }
-                if (searchCriteriaM.count(CriteriaItem::ctField) > 0)
-                {
-                    Relation* r = dynamic_cast<Relation*>(*it);
-                    Procedure* p = dynamic_cast<Procedure*>(*it);
-                    if (r || p)
-                    {
-                        (*it)->ensureChildrenLoaded();
-                        bool found = false;
-                        if (r)
-                        {
-                            found |= std::any_of(r->begin(), r->end(),
-                                                 [this](ColumnPtr i) { return match(CriteriaItem::ctField, i->getName_()); });
-                        }
-                        if (p)
-                        {
-                            found |= std::any_of(p->begin(), p->end(),
-                                                 [this](ParameterPtr i) { return match(CriteriaItem::ctField, i->getName_()); });
-                        }
-                        if (!found)     // object doesn't contain that field
-                            continue;
-                    }
-                }
-                // everything criteria is matched -> add to results
-                addResult(db, *it);
+                candidates.swap(found);
+                useCandidates = true;
+                continue;
+            }
+            for (MetadataSearchIndex::Items::iterator it = candidates.begin();
+                it != candidates.end(); )
+            {
+                if (found.find(*it) == found.end())
+                    it = candidates.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        const std::vector<MetadataItem*>& items = index.getItems();
+        for (std::vector<MetadataItem*>::const_iterator it = items.begin();
+            it != items.end(); ++it)
+        {
+            if (!types.empty() && types.find((*it)->getType()) == types.end())
+                continue;
+            if (useCandidates && candidates.find(*it) == candidates.end())
+                continue;
+            if (!match(index, *it, CriteriaItem::ctName)
+                || !match(index, *it, CriteriaItem::ctDescription)
+                || !match(index, *it, CriteriaItem::ctDDL)
+                || !match(index, *it, CriteriaItem::ctField))
+            {
+                continue;
             }
+            // everything criteria is matched -> add to results
+            addResult(db, *it);
         }
     }
 }
@@ -31,6 +31,7 @@
 
 #include "core/Observer.h"
 #include "gui/BaseFrame.h"
+#include "metadata/MetadataSearchIndex.h"
 
 class CriteriaItem
 {
@@ -80,7 +81,10 @@ private:
     void rebuildList();
     std::vector<MetadataItem *> results;
     void addResult(Database* db, MetadataItem* item);
-    bool match(CriteriaItem::Type type, const wxString& text);
+    bool match(const MetadataSearchIndex& index, MetadataItem* item,
+        CriteriaItem::Type type);
+    bool getCandidates(const MetadataSearchIndex& index,
+        CriteriaItem::Type type, MetadataSearchIndex::Items& candidates);
 
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
@@ -42,8 +42,10 @@ enum {
     Query_Execute,
     Query_Show_plan,
     Query_Show_Statistics,
+    Query_Show_Profiles,
     Query_Execute_selection,
     Query_Execute_from_cursor,
+    Query_Execute_file,
     Query_Commit,
     Query_Rollback,
     // next 4: order is important, because EVT_MENU_RANGE is used
@@ -71,6 +73,7 @@ enum {
     DataGrid_Copy_as_upins,
     DataGrid_Save_as_html,
     DataGrid_Save_as_csv,
+    DataGrid_Export_all,
     DataGrid_Log_changes,
 
     Menu_RegisterServer = 600,
@@ -35,6 +35,7 @@
 #include <wx/file.h>
 
 #include <wx/filename.h>
+#include <wx/thread.h>
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/xml/xml.h>
@@ -42,6 +43,13 @@
 // needed for random
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <set>
+#include <vector>
+
 #include "core/ArtProvider.h"
 #include "core/FRError.h"
 #include "core/StringUtils.h"
@@ -419,6 +427,21 @@ DataGeneratorFrame::DataGeneratorFrame(wxWindow* parent, Database* db)
     wxBoxSizer* buttonSizer;
     buttonSizer = new wxBoxSizer( wxHORIZONTAL );
 
+    connectionsLabel = new wxStaticText( outerPanel, wxID_ANY, "Connections:", wxDefaultPosition, wxDefaultSize, 0 );
+    buttonSizer->Add( connectionsLabel, 0, wxALIGN_CENTER_VERTICAL|wxLEFT, 5 );
+
+    int cpus = wxThread::GetCPUCount();
+    spinConnections = new wxSpinCtrl( outerPanel, wxID_ANY, wxEmptyString, wxDefaultPosition,
+        wxDefaultSize, wxSP_ARROW_KEYS, 1, 64, (cpus > 1 ? cpus : 1));
+    buttonSizer->Add( spinConnections, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+
+    commitEveryLabel = new wxStaticText( outerPanel, wxID_ANY, "Commit every (records, 0 = per table):", wxDefaultPosition, wxDefaultSize, 0 );
+    buttonSizer->Add( commitEveryLabel, 0, wxALIGN_CENTER_VERTICAL|wxLEFT, 10 );
+
+    spinCommitEvery = new wxSpinCtrl( outerPanel, wxID_ANY, wxEmptyString, wxDefaultPosition,
+        wxDefaultSize, wxSP_ARROW_KEYS, 0, 1000000, 0);
+    buttonSizer->Add( spinCommitEvery, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+
     buttonSizer->Add( 0, 0, 1, wxALL, 5 );
 
     saveButton = new wxButton( outerPanel, ID_button_save, "Save settings", wxDefaultPosition, wxDefaultSize, 0 );
@@ -1047,8 +1070,7 @@ bool DataGeneratorFrame::sortTables(std::list<Table *>& order)
 }
 
 // range = comma separated list of values or ranges
-wxString getCharFromRange(const wxString& range, bool rnd, int recNo,
-    int charNo, int chars)
+wxString getValuesetFromRange(const wxString& range)
 {
     wxString valueset;
     size_t start = 0;
@@ -1074,47 +1096,13 @@ wxString getCharFromRange(const wxString& range, bool rnd, int recNo,
         else
             throw FRError(_("Bad range: section length not 1 or 2: ") + one);
     }
-
-    if (rnd)
-        return valueset.Mid(frRandom(valueset.Length()), 1);
-
-    // sequential: we support stuff like 001,002,003 or AAA,AAB,AAC
-    //             by converting the record counter to number with n-th base
-    //             where n is a number of characters in valueset
-    int base = valueset.Length();
-    int record = recNo;
-    for (int i=0; i<chars-charNo-1; i++)    // get the charNo-th digit
-        record /= base;
-    return valueset.Mid(record % base, 1);
+    if (valueset.IsEmpty())
+        throw FRError(_("Bad range: no characters"));
+    return valueset;
 }
 
-void setFromFile(IBPP::Statement st, int param,
-    GeneratorSettings *gs, int recNo)
+void setFromString(IBPP::Statement st, int param, const wxString& selected)
 {
-    // load strings from file to vector
-    wxFileInputStream stream(gs->fileName);
-    if (!stream.Ok())
-        throw FRError(_("Cannot open file: ")+gs->fileName);
-    wxTextInputStream text(stream);
-
-    std::vector<wxString> values;
-    while (true)
-    {
-        wxString s = text.ReadLine();
-        if (s.IsEmpty())
-            break;
-        values.push_back(s);
-    }
-    if (values.empty())
-        return;
-
-    // select (random/sequential) string from vector
-    wxString selected;
-    if (gs->randomValues)
-        selected = values[frRandom(values.size())];
-    else
-        selected = values[recNo % values.size()];
-
     // convert string to datatype
     int mydate, mytime;
     IBPP::SDT dt = st->ParameterType(param);
@@ -1195,305 +1183,433 @@ void setFromFile(IBPP::Statement st, int param,
     };
 }
 
-template<typename T>
-void setFromOther(IBPP::Statement st, int param,
-    GeneratorSettings *gs, size_t recNo)
+// ValueRanges: list of ranges of values with equal distance, the prefix
+// sums of the range sizes allow to find the n-th value of all ranges with a
+// binary search instead of walking the list
+class ValueRanges
 {
-    IBPP::Statement st2 =
-        IBPP::StatementFactory(st->DatabasePtr(), st->TransactionPtr());
-
-    wxString sql = "SELECT " + gs->sourceColumn + " FROM "
-        + gs->sourceTable + " WHERE " + gs->sourceColumn
-        + " IS NOT NULL";
-    if (!gs->randomValues)
-        sql += " ORDER BY 1";
-    st2->Prepare(wx2std(sql));
-    st2->Execute();
-    std::vector<T> values;
-    while (st2->Fetch())
-    {
-        T value;
-        st2->Get(1, value);
-        values.push_back(value);
-        if (values.size() > recNo && !gs->randomValues)
-        {
-            st->Set(param, value);
-            return;
-        }
-        if (values.size() > 99 && gs->randomValues)
-            break;
+private:
+    long stepM;
+    std::vector<long> firstM;
+    std::vector<long> endsM;    // prefix sums of range sizes
+public:
+    ValueRanges(long step = 1)
+        : stepM(step)
+    {
     }
-    if (values.size() == 0)
+    void add(long first, long last)
     {
-        if (gs->nullPercent > 0)
-        {
+        long size = (last - first) / stepM + 1;
+        if (size < 1)
+            throw FRError(_("Invalid range: end before start"));
+        firstM.push_back(first);
+        endsM.push_back((endsM.empty() ? 0 : endsM.back()) + size);
+    }
+    long size() const
+    {
+        return (endsM.empty() ? 0 : endsM.back());
+    }
+    long get(long n) const
+    {
+        size_t i = std::upper_bound(endsM.begin(), endsM.end(), n)
+            - endsM.begin();
+        wxASSERT(i < firstM.size());
+        return firstM[i] + (n - (i ? endsM[i - 1] : 0)) * stepM;
+    }
+    long pick(bool randomValue, int recNo) const
+    {
+        long n = size();
+        if (!n)
+            return 0;
+        return get(randomValue ? frRandom(n) : (recNo % n));
+    }
+};
+
+// ValueGenerator: the settings of one column compiled for the parameter of
+// the insert statement, created once per table so that ranges, masks, files
+// and source columns aren't parsed, read or queried again for every record
+class ValueGenerator
+{
+protected:
+    GeneratorSettings* settingsM;
+    virtual void setValue(IBPP::Statement st, int param, int recNo) = 0;
+public:
+    ValueGenerator(GeneratorSettings* gs)
+        : settingsM(gs)
+    {
+    }
+    virtual ~ValueGenerator()
+    {
+    }
+    void setParam(IBPP::Statement st, int param, int recNo)
+    {
+        if (settingsM->nullPercent > frRandom(100))
             st->SetNull(param);
-            return;
-        }
         else
-            throw FRError(_("No records found in table: ") + gs->sourceTable);
+            setValue(st, param, recNo);
     }
+};
 
-    if (gs->randomValues)
-        st->Set(param, values[frRandom(values.size())]);
-    else
-        st->Set(param, values[recNo % values.size()]);
-}
+class NullGenerator: public ValueGenerator
+{
+protected:
+    virtual void setValue(IBPP::Statement st, int param, int)
+    {
+        st->SetNull(param);
+    }
+public:
+    NullGenerator(GeneratorSettings* gs)
+        : ValueGenerator(gs)
+    {
+    }
+};
 
-// format for values:
-// number[value or range(s)]
-// example: 25[az,AZ,09] means: 25 letters or numbers
-// example: 10[a,x,5]       means: 10 chars, each either of 'a', 'x' or '5'
-void DataGeneratorFrame::setString(IBPP::Statement st, int param,
-    GeneratorSettings* gs, int recNo)
+// value pool loaded from file once, one value per line
+class FileGenerator: public ValueGenerator
 {
-    wxString value;
-    long chars = 1;
-    size_t start = 0;
-    while (start < gs->range.Length())
+private:
+    std::vector<wxString> valuesM;
+protected:
+    virtual void setValue(IBPP::Statement st, int param, int recNo)
     {
-        if (gs->range.Mid(start, 1) == "[")
+        if (valuesM.empty())
         {
-            size_t p = gs->range.find("]", start+1);
-            if (p == wxString::npos)    // invalid mask
-                throw FRError(_("Invalid mask: missing ]"));
-            for (int i = 0; i < chars; i++)
-            {
-                value += getCharFromRange(gs->range.Mid(start+1,
-                    p-start-1), gs->randomValues, recNo, i, chars);
-            }
-            start = p+1;
-            chars = 1;
+            st->SetNull(param);
+            return;
         }
+        // select (random/sequential) string from vector
+        if (settingsM->randomValues)
+            setFromString(st, param, valuesM[frRandom(valuesM.size())]);
         else
+            setFromString(st, param, valuesM[recNo % valuesM.size()]);
+    }
+public:
+    FileGenerator(GeneratorSettings* gs)
+        : ValueGenerator(gs)
+    {
+        // load strings from file to vector
+        wxFileInputStream stream(gs->fileName);
+        if (!stream.Ok())
+            throw FRError(_("Cannot open file: ")+gs->fileName);
+        wxTextInputStream text(stream);
+        while (true)
         {
-            size_t p = gs->range.find("[", start+1);
-            if (p == wxString::npos)    // invalid mask
-                throw FRError(_("Invalid mask, missing ["));
-            wxString number = gs->range.Mid(start, p-start);
-            if (!number.ToLong(&chars))
-                throw FRError(_("Bad number: ")+number);
-            start = p;
+            wxString s = text.ReadLine();
+            if (s.IsEmpty())
+                break;
+            valuesM.push_back(s);
         }
     }
-    st->Set(param, wx2std(value, databaseM->getCharsetConverter()));
-}
+};
 
-// gs->range = x,x-y,...
+// values of the source column, fetched once before the first record is
+// generated, or for every record when the source is the table itself
 template<typename T>
-void setNumber(IBPP::Statement st, int param, GeneratorSettings* gs, int recNo)
+class ColumnGenerator: public ValueGenerator
 {
-    std::vector< std::pair<long,long> > ranges;
-    long rangesize = 0;
-    size_t start = 0;
-    while (start < gs->range.Length())
+private:
+    std::vector<T> valuesM;
+    size_t maxValuesM;
+    bool reloadM;
+    bool loadedM;
+
+    void load(IBPP::Statement st)
     {
-        // last
-        wxString one = gs->range.Mid(start);
-        size_t p = gs->range.find(",", start);
-        if (p != wxString::npos)
+        IBPP::Statement st2 =
+            IBPP::StatementFactory(st->DatabasePtr(), st->TransactionPtr());
+
+        wxString sql = "SELECT " + settingsM->sourceColumn + " FROM "
+            + settingsM->sourceTable + " WHERE " + settingsM->sourceColumn
+            + " IS NOT NULL";
+        if (!settingsM->randomValues)
+            sql += " ORDER BY 1";
+        st2->Prepare(wx2std(sql));
+        st2->Execute();
+        valuesM.clear();
+        while (valuesM.size() < maxValuesM && st2->Fetch())
         {
-            one = gs->range.Mid(start, p-start);
-            start = p + 1;
+            T value;
+            st2->Get(1, value);
+            valuesM.push_back(value);
         }
-        else
-            start = gs->range.Length(); // exit on next loop
-
-        p = one.find("-");
-        if (p == wxString::npos)
+        loadedM = true;
+    }
+protected:
+    virtual void setValue(IBPP::Statement st, int param, int recNo)
+    {
+        if (reloadM || !loadedM)
+            load(st);
+        if (valuesM.empty())
         {
-            long l;
-            if (!one.ToLong(&l))
-                throw FRError(_("Invalid number: ") + one);
-            ranges.push_back(std::pair<long,long>(l, l));
-            rangesize++;
+            if (settingsM->nullPercent > 0)
+            {
+                st->SetNull(param);
+                return;
+            }
+            throw FRError(_("No records found in table: ")
+                + settingsM->sourceTable);
         }
+        if (settingsM->randomValues)
+            st->Set(param, valuesM[frRandom(valuesM.size())]);
         else
-        {
-            long l1, l2;
-            if (!one.Mid(0, p).ToLong(&l1) || !one.Mid(p+1).ToLong(&l2))
-                throw FRError(_("Invalid range: ") + one);
-            ranges.push_back(std::pair<long,long>(l1, l2));
-            rangesize += (l2-l1+1);
-        }
+            st->Set(param, valuesM[recNo % valuesM.size()]);
     }
+public:
+    ColumnGenerator(GeneratorSettings* gs, int records, bool reload)
+        : ValueGenerator(gs), reloadM(reload), loadedM(false)
+    {
+        // random values are picked from the first 100 values only,
+        // sequential values need one value per record at most
+        maxValuesM = (gs->randomValues ? 100 : records);
+        if (maxValuesM == 0)
+            maxValuesM = 1;
+    }
+};
 
-    long toget = (gs->randomValues ?
-        frRandom(rangesize) : (recNo % rangesize));
-
-    for (std::vector< std::pair<long,long> >::iterator it =
-        ranges.begin(); it != ranges.end(); ++it)
+// gs->range = x,x-y,...
+template<typename T>
+class NumberGenerator: public ValueGenerator
+{
+private:
+    ValueRanges rangesM;
+protected:
+    virtual void setValue(IBPP::Statement st, int param, int recNo)
     {
-        long sz = (*it).second - (*it).first + 1;
-        if (sz > toget)
+        st->Set(param, (T)rangesM.pick(settingsM->randomValues, recNo));
+    }
+public:
+    NumberGenerator(GeneratorSettings* gs)
+        : ValueGenerator(gs)
+    {
+        size_t start = 0;
+        while (start < gs->range.Length())
         {
-            st->Set(param, (T)((*it).first + toget));
-            return;
+            // last
+            wxString one = gs->range.Mid(start);
+            size_t p = gs->range.find(",", start);
+            if (p != wxString::npos)
+            {
+                one = gs->range.Mid(start, p-start);
+                start = p + 1;
+            }
+            else
+                start = gs->range.Length(); // exit on next loop
+
+            p = one.find("-");
+            if (p == wxString::npos)
+            {
+                long l;
+                if (!one.ToLong(&l))
+                    throw FRError(_("Invalid number: ") + one);
+                rangesM.add(l, l);
+            }
+            else
+            {
+                long l1, l2;
+                if (!one.Mid(0, p).ToLong(&l1) || !one.Mid(p+1).ToLong(&l2))
+                    throw FRError(_("Invalid range: ") + one);
+                rangesM.add(l1, l2);
+            }
         }
-        toget -= sz;
+        if (!rangesM.size())
+            throw FRError(_("Invalid range: no values"));
     }
-}
+};
 
-void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
-    int recNo)
+class DatetimeGenerator: public ValueGenerator
 {
-    std::vector< std::pair<int,int> > dateRanges;
-    std::vector< std::pair<int,int> > timeRanges;
-    int dateRangesize = 0;
-    int timeRangesize = 0;
-
-    IBPP::SDT dt = st->ParameterType(param);
-    size_t start = 0;
-    while (start < gs->range.Length())
+private:
+    IBPP::SDT typeM;
+    ValueRanges dateRangesM;
+    ValueRanges timeRangesM;
+protected:
+    virtual void setValue(IBPP::Statement st, int param, int recNo)
     {
-        // last
-        wxString one = gs->range.Mid(start);
-        size_t p = gs->range.find(",", start);
-        if (p != wxString::npos)
+        int myDate = dateRangesM.pick(settingsM->randomValues, recNo);
+        int myTime = timeRangesM.pick(settingsM->randomValues, recNo);
+
+        if (typeM == IBPP::sdDate)
+            st->Set(param, IBPP::Date(myDate));
+        if (typeM == IBPP::sdTime)
+            st->Set(param, IBPP::Time(IBPP::Time::tmNone, myTime, IBPP::Time::TZ_NONE));
+        if (typeM == IBPP::sdTimestamp)
         {
-            one = gs->range.Mid(start, p-start);
-            start = p + 1;
+            int y, mo, d, h, mi, s, t;
+            IBPP::dtoi(myDate, &y, &mo, &d);
+            IBPP::ttoi(myTime, &h, &mi, &s, &t);
+            st->Set(param, IBPP::Timestamp(y, mo, d, IBPP::Time::tmNone, h, mi, s, t, IBPP::Time::TZ_NONE, NULL));
         }
-        else
-            start = gs->range.Length(); // exit on next loop
-
-        // convert first value
-        int date, time;
-        if ((dt == IBPP::sdDate || dt == IBPP::sdTimestamp))
-            str2date(one.Mid(0,10), date);
-        if (dt == IBPP::sdTime)
-            str2time(one.Mid(0,8), time);
-        if (dt == IBPP::sdTimestamp)
-            str2time(one.Mid(11,8), time);
-
-        p = one.find("-");
-        if (p == wxString::npos)
+    }
+public:
+    DatetimeGenerator(GeneratorSettings* gs, IBPP::SDT type)
+        : ValueGenerator(gs), typeM(type), dateRangesM(1),
+          timeRangesM(10000)    // seconds
+    {
+        IBPP::SDT dt = typeM;
+        size_t start = 0;
+        while (start < gs->range.Length())
         {
-            if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
+            // last
+            wxString one = gs->range.Mid(start);
+            size_t p = gs->range.find(",", start);
+            if (p != wxString::npos)
             {
-                dateRanges.push_back(std::pair<int,int>(date, date));
-                dateRangesize++;
+                one = gs->range.Mid(start, p-start);
+                start = p + 1;
             }
-            if (dt == IBPP::sdTime || dt == IBPP::sdTimestamp)
-            {
-                timeRanges.push_back(std::pair<int,int>(time, time));
-                timeRangesize++;
-            }
-        }
-        else    // range, convert second date/time
-        {
-            int date2, time2;
-            if (dt == IBPP::sdDate)
-                str2date(one.Mid(11,10), date2);
-            if (dt == IBPP::sdTimestamp)
-                str2date(one.Mid(20,10), date2);
+            else
+                start = gs->range.Length(); // exit on next loop
+
+            // convert first value
+            int date = 0, time = 0;
+            if ((dt == IBPP::sdDate || dt == IBPP::sdTimestamp))
+                str2date(one.Mid(0,10), date);
             if (dt == IBPP::sdTime)
-                str2time(one.Mid( 9, 8), time2);
+                str2time(one.Mid(0,8), time);
             if (dt == IBPP::sdTimestamp)
-                str2time(one.Mid(31, 8), time2);
+                str2time(one.Mid(11,8), time);
 
-            if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
+            // range, convert second date/time
+            int date2 = date, time2 = time;
+            if (one.find("-") != wxString::npos)
             {
-                dateRanges.push_back(std::pair<int,int>(date, date2));
-                dateRangesize += (date2-date+1);
+                if (dt == IBPP::sdDate)
+                    str2date(one.Mid(11,10), date2);
+                if (dt == IBPP::sdTimestamp)
+                    str2date(one.Mid(20,10), date2);
+                if (dt == IBPP::sdTime)
+                    str2time(one.Mid( 9, 8), time2);
+                if (dt == IBPP::sdTimestamp)
+                    str2time(one.Mid(31, 8), time2);
             }
+
+            if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
+                dateRangesM.add(date, date2);
             if (dt == IBPP::sdTime || dt == IBPP::sdTimestamp)
-            {
-                timeRanges.push_back(std::pair<int,int>(time, time2));
-                timeRangesize += ((time2-time) / 10000 + 1);
-            }
+                timeRangesM.add(time, time2);
         }
     }
+};
 
-    int dateToGet, timeToGet;
-    if (gs->randomValues)
-    {
-        dateToGet = (dateRangesize ? frRandom(dateRangesize) : 0);
-        timeToGet = (timeRangesize ? frRandom(timeRangesize) : 0);
-    }
-    else
+// format for values:
+// number[value or range(s)]
+// example: 25[az,AZ,09] means: 25 letters or numbers
+// example: 10[a,x,5]       means: 10 chars, each either of 'a', 'x' or '5'
+class StringGenerator: public ValueGenerator
+{
+private:
+    struct MaskPart
     {
-        dateToGet = (dateRangesize ? recNo % dateRangesize : 0);
-        timeToGet = (timeRangesize ? recNo % timeRangesize : 0);
-    }
-
-    int myDate = 0;
-    int myTime = 0;
-    for (std::vector< std::pair<int,int> >::iterator it =
-        dateRanges.begin(); it != dateRanges.end(); ++it)
+        long chars;
+        wxString valueset;
+    };
+    std::vector<MaskPart> partsM;
+    wxMBConv* converterM;
+    wxString valueM;
+protected:
+    virtual void setValue(IBPP::Statement st, int param, int recNo)
     {
-        int sz = (*it).second - (*it).first + 1;
-        if (sz > dateToGet)
+        valueM.clear();
+        for (std::vector<MaskPart>::iterator it = partsM.begin();
+            it != partsM.end(); ++it)
         {
-            myDate = ((*it).first + dateToGet);
-            break;
+            const wxString& valueset((*it).valueset);
+            int base = valueset.Length();
+            if (settingsM->randomValues)
+            {
+                for (long i = 0; i < (*it).chars; i++)
+                    valueM += valueset[frRandom(base)];
+                continue;
+            }
+            // sequential: we support stuff like 001,002,003 or AAA,AAB,AAC
+            //             by converting the record counter to number with
+            //             n-th base where n is a number of characters in
+            //             valueset, the last character is the lowest digit
+            size_t pos = valueM.Length();
+            valueM.append((*it).chars, ' ');
+            int record = recNo;
+            for (long i = (*it).chars - 1; i >= 0; i--)
+            {
+                valueM[pos + i] = valueset[record % base];
+                record /= base;
+            }
         }
-        dateToGet -= sz;
+        st->Set(param, wx2std(valueM, converterM));
     }
-    for (std::vector< std::pair<int,int> >::iterator it =
-        timeRanges.begin(); it != timeRanges.end(); ++it)
+public:
+    StringGenerator(GeneratorSettings* gs, wxMBConv* converter)
+        : ValueGenerator(gs), converterM(converter)
     {
-        int sz = ((*it).second - (*it).first)/10000 + 1;
-        if (sz > timeToGet)
+        long chars = 1;
+        size_t start = 0;
+        while (start < gs->range.Length())
         {
-            myTime = ((*it).first + timeToGet*10000);
-            break;
+            if (gs->range.Mid(start, 1) == "[")
+            {
+                size_t p = gs->range.find("]", start+1);
+                if (p == wxString::npos)    // invalid mask
+                    throw FRError(_("Invalid mask: missing ]"));
+                MaskPart part;
+                part.chars = chars;
+                part.valueset = getValuesetFromRange(gs->range.Mid(start+1,
+                    p-start-1));
+                partsM.push_back(part);
+                start = p+1;
+                chars = 1;
+            }
+            else
+            {
+                size_t p = gs->range.find("[", start+1);
+                if (p == wxString::npos)    // invalid mask
+                    throw FRError(_("Invalid mask, missing ["));
+                wxString number = gs->range.Mid(start, p-start);
+                if (!number.ToLong(&chars))
+                    throw FRError(_("Bad number: ")+number);
+                start = p;
+            }
         }
-        timeToGet -= sz;
-    }
-
-    if (dt == IBPP::sdDate)
-        st->Set(param, IBPP::Date(myDate));
-    if (dt == IBPP::sdTime)
-        st->Set(param, IBPP::Time(IBPP::Time::tmNone, myTime, IBPP::Time::TZ_NONE));
-    if (dt == IBPP::sdTimestamp)
-    {
-        int y, mo, d, h, mi, s, t;
-        IBPP::dtoi(myDate, &y, &mo, &d);
-        IBPP::ttoi(myTime, &h, &mi, &s, &t);
-        st->Set(param, IBPP::Timestamp(y, mo, d, IBPP::Time::tmNone, h, mi, s, t, IBPP::Time::TZ_NONE, NULL));
     }
-}
+};
 
-void DataGeneratorFrame::setParam(IBPP::Statement st, int param,
-    GeneratorSettings* gs, int recNo)
+ValueGenerator* createGenerator(IBPP::Statement st, int param,
+    GeneratorSettings* gs, const wxString& tableName, int records,
+    wxMBConv* converter)
 {
-    if (gs->nullPercent > frRandom(100))
-    {
-        st->SetNull(param);
-        return;
-    }
-
     if (gs->valueType == GeneratorSettings::vtColumn)   // copy from column
     {
+        // values copied from the table itself include the records inserted
+        // before, so they have to be fetched again for every record
+        bool reload = (gs->sourceTable == tableName);
         switch (st->ParameterType(param))
         {
             case IBPP::sdBoolean: // Firebird v3
-                setFromOther<std::string>(st, param, gs, recNo);  break;
+                return new ColumnGenerator<std::string>(gs, records, reload);
             case IBPP::sdString:
-                setFromOther<std::string>(st, param, gs, recNo);  break;
+                return new ColumnGenerator<std::string>(gs, records, reload);
             case IBPP::sdSmallint:
-                setFromOther<int16_t>(st, param, gs, recNo);      break;
+                return new ColumnGenerator<int16_t>(gs, records, reload);
             case IBPP::sdInteger:
-                setFromOther<int32_t>(st, param, gs, recNo);      break;
+                return new ColumnGenerator<int32_t>(gs, records, reload);
             case IBPP::sdLargeint:
-                setFromOther<int64_t>(st, param, gs, recNo);      break;
+                return new ColumnGenerator<int64_t>(gs, records, reload);
             case IBPP::sdFloat:
-                setFromOther<float>(st, param, gs, recNo);        break;
+                return new ColumnGenerator<float>(gs, records, reload);
             case IBPP::sdDouble:
-                setFromOther<double>(st, param, gs, recNo);       break;
+                return new ColumnGenerator<double>(gs, records, reload);
             case IBPP::sdDate:
-                setFromOther<IBPP::Date>(st, param, gs, recNo);   break;
+                return new ColumnGenerator<IBPP::Date>(gs, records, reload);
             case IBPP::sdTime:
-                setFromOther<IBPP::Time>(st, param, gs, recNo);   break;
+                return new ColumnGenerator<IBPP::Time>(gs, records, reload);
             case IBPP::sdTimestamp:
-                setFromOther<IBPP::Timestamp>(st, param, gs, recNo);  break;
+                return new ColumnGenerator<IBPP::Timestamp>(gs, records,
+                    reload);
             case IBPP::sdBlob:
                 throw FRError(_("Blob datatype not supported"));
             case IBPP::sdArray:
                 throw FRError(_("Array datatype not supported"));
+            default:
+                return new NullGenerator(gs);
         };
-        return;
     }
 
     if (gs->valueType == GeneratorSettings::vtRange)
@@ -1501,60 +1617,220 @@ void DataGeneratorFrame::setParam(IBPP::Statement st, int param,
         switch (st->ParameterType(param))
         {
             case IBPP::sdBoolean: // Firebird v3
-                setString(st, param, gs, recNo);          break;
+                return new StringGenerator(gs, converter);
             case IBPP::sdString:
-                setString(st, param, gs, recNo);          break;
+                return new StringGenerator(gs, converter);
             case IBPP::sdSmallint:
-                setNumber<int16_t>(st, param, gs, recNo); break;
+                return new NumberGenerator<int16_t>(gs);
             case IBPP::sdInteger:
-                setNumber<int32_t>(st, param, gs, recNo); break;
+                return new NumberGenerator<int32_t>(gs);
             case IBPP::sdLargeint:
-                setNumber<int64_t>(st, param, gs, recNo); break;
+                return new NumberGenerator<int64_t>(gs);
             case IBPP::sdFloat:
-                setNumber<float>  (st, param, gs, recNo); break;
+                return new NumberGenerator<float>(gs);
             case IBPP::sdDouble:
-                setNumber<double> (st, param, gs, recNo); break;
+                return new NumberGenerator<double>(gs);
             case IBPP::sdDate:
             case IBPP::sdTime:
             case IBPP::sdTimestamp:
-                setDatetime(st, param, gs, recNo);
-                break;
+                return new DatetimeGenerator(gs, st->ParameterType(param));
             case IBPP::sdBlob:
                 throw FRError(_("Blob datatype not supported"));
             case IBPP::sdArray:
                 throw FRError(_("Array datatype not supported"));
             default:
-                st->SetNull(param);
+                return new NullGenerator(gs);
         };
     }
 
     if (gs->valueType == GeneratorSettings::vtFile)
-        setFromFile(st, param, gs, recNo);
+        return new FileGenerator(gs);
+    return new NullGenerator(gs);
 }
 
-void DataGeneratorFrame::generateData(std::list<Table *>& order)
+void executeBatch(IBPP::Batch batch, wxMBConv* converter)
 {
-    ProgressDialog pd(this, _("Generating data"), 2);
-    pd.doShow();
-    pd.initProgress(_("Inserting into tables"), order.size());
+    int rows = batch->Rows();
+    if (batch->Execute() == 0)
+        return;
+    for (int i = 0; i < rows; i++)
+    {
+        if (batch->RowState(i) == IBPP::brFailed)
+        {
+            throw FRError(wxString(batch->RowError(i).c_str(), *converter));
+        }
+    }
+}
+
+// DataGeneratorJob: everything needed to fill one table, collected on the
+// main thread as the metadata objects must not be used by worker threads
+struct DataGeneratorJob
+{
+    enum State { jsPending, jsRunning, jsDone };
+
+    wxString tableName;
+    wxString sql;
+    std::vector<GeneratorSettings *> settings;
+    std::list<wxString> dependsOn;
+    int records;
+    State state;
+    // written by the worker thread, error is only read after finished is set
+    std::atomic<int> inserted;
+    std::atomic<bool> finished;
+    wxString error;
+
+    DataGeneratorJob()
+        : records(0), state(jsPending), inserted(0), finished(false)
+    {
+    }
+};
+
+typedef std::vector<std::unique_ptr<DataGeneratorJob> > DataGeneratorJobs;
+
+// returns true if the job filling table "from" waits for table "to",
+// directly or through the jobs it waits for
+static bool jobWaitsFor(const DataGeneratorJobs& jobs, const wxString& from,
+    const wxString& to, std::set<wxString>& visited)
+{
+    if (from == to)
+        return true;
+    if (!visited.insert(from).second)
+        return false;
+    for (DataGeneratorJobs::const_iterator it = jobs.begin();
+        it != jobs.end(); ++it)
+    {
+        if ((*it)->tableName != from)
+            continue;
+        for (std::list<wxString>::const_iterator dep =
+            (*it)->dependsOn.begin(); dep != (*it)->dependsOn.end(); ++dep)
+        {
+            if (jobWaitsFor(jobs, *dep, to, visited))
+                return true;
+        }
+        break;
+    }
+    return false;
+}
+
+// DataGeneratorThread class
+// Fills the table of one job using an attachment of its own, the attachment
+// is not used by any other thread until this thread has been joined.
+class DataGeneratorThread: public wxThread
+{
+private:
+    DataGeneratorJob* jobM;
+    IBPP::Database databaseM;
+    wxMBConv* converterM;
+    int commitEveryM;
+
+    void generate();
+public:
+    DataGeneratorThread(DataGeneratorJob* job, IBPP::Database db,
+        wxMBConv* converter, int commitEvery);
+
+    virtual ExitCode Entry();
+};
+
+DataGeneratorThread::DataGeneratorThread(DataGeneratorJob* job,
+        IBPP::Database db, wxMBConv* converter, int commitEvery)
+    : wxThread(wxTHREAD_JOINABLE), jobM(job), databaseM(db),
+      converterM(converter), commitEveryM(commitEvery)
+{
+}
 
-    // one big transaction (perhaps this should be configurable)
-    IBPP::Transaction tr =
-        IBPP::TransactionFactory(databaseM->getIBPPDatabase());
+void DataGeneratorThread::generate()
+{
+    IBPP::Transaction tr = IBPP::TransactionFactory(databaseM);
     tr->Start();
 
+    IBPP::Statement st = IBPP::StatementFactory(databaseM, tr);
+    st->Prepare(wx2std(jobM->sql));
+
+    // rows are sent to the server in batches, unless values are copied
+    // from the table itself, which needs the previous rows inserted;
+    // batches of wide rows are sent when the batch buffer is full
+    int batchSize = 1000;
+    for (std::vector<GeneratorSettings *>::iterator gs =
+        jobM->settings.begin(); gs != jobM->settings.end(); ++gs)
+    {
+        if ((*gs)->valueType == GeneratorSettings::vtColumn
+            && (*gs)->sourceTable == jobM->tableName)
+        {
+            batchSize = 1;
+        }
+    }
+    if (commitEveryM > 0 && commitEveryM < batchSize)
+        batchSize = commitEveryM;
+    IBPP::Batch batch = IBPP::BatchFactory(st);
+
+    // settings are compiled once per table, not for every record
+    std::vector<std::unique_ptr<ValueGenerator> > generators;
+    for (int p = 0; p < st->Parameters(); ++p)
+    {
+        generators.push_back(std::unique_ptr<ValueGenerator>(
+            createGenerator(st, p+1, jobM->settings[p], jobM->tableName,
+                jobM->records, converterM)));
+    }
+
+    int records = jobM->records;
+    for (int i = 0; i < records; i++)
+    {
+        if (TestDestroy())
+            return;     // transaction is rolled back
+        for (size_t p = 0; p < generators.size(); ++p)
+            generators[p]->setParam(st, p+1, i);
+        batch->Add();
+        bool commit = (commitEveryM > 0 && (i + 1) % commitEveryM == 0);
+        if (batch->Rows() >= batchSize || batch->Full() || commit
+            || i == records - 1)
+        {
+            executeBatch(batch, converterM);
+            jobM->inserted = i + 1;
+        }
+        if (commit && i < records - 1)
+            tr->CommitRetain();
+    }
+    tr->Commit();
+}
+
+wxThread::ExitCode DataGeneratorThread::Entry()
+{
+    try
+    {
+        generate();
+    }
+    catch (IBPP::Exception& e)
+    {
+        jobM->error = e.what();
+    }
+    catch (std::exception& e)
+    {
+        jobM->error = e.what();
+    }
+    catch (...)
+    {
+        jobM->error = _("Unknown error");
+    }
+    jobM->finished = true;
+    return 0;
+}
+
+// Tables are filled concurrently on a pool of attachments, a table is only
+// started when all tables it references have been filled and committed.
+void DataGeneratorFrame::generateData(std::list<Table *>& order)
+{
+    // collect everything the worker threads need on the main thread
+    DataGeneratorJobs jobs;
+    int totalRecords = 0;
     for (std::list<Table *>::iterator it = order.begin();
         it != order.end(); ++it)
     {
-        pd.setProgressMessage((*it)->getName_(), 1);
-        pd.stepProgress();
-
         std::map<wxString, int>::iterator i2 =
             tableRecordsM.find((*it)->getQuotedName());
-        int records = (*i2).second;
-
-        pd.initProgress(wxString::Format(_("Inserting %d records."), records),
-            records, 0, 2);
+        std::unique_ptr<DataGeneratorJob> job(new DataGeneratorJob);
+        job->tableName = (*it)->getQuotedName();
+        job->records = (*i2).second;
+        job->dependsOn = TableDep(*it, tableRecordsM).dependsOn;
 
         // collect columns + create insert statement
         wxString ins = "INSERT INTO " + (*it)->getQuotedName()
@@ -1562,7 +1838,6 @@ void DataGeneratorFrame::generateData(std::list<Table *>& order)
         wxString params(") VALUES (");
         (*it)->ensureChildrenLoaded();
         bool first = true;
-        std::vector<GeneratorSettings *> colSet;
         for (ColumnPtrs::iterator col = (*it)->begin();
             col != (*it)->end(); ++col)
         {
@@ -1579,26 +1854,160 @@ void DataGeneratorFrame::generateData(std::list<Table *>& order)
             }
             ins += (*col)->getQuotedName();
             params += "?";
-            colSet.push_back(gs);
+            job->settings.push_back(gs);
         }
         if (first)  // no columns
-            continue;
+            job->state = DataGeneratorJob::jsDone;
+        else
+            totalRecords += job->records;
+        job->sql = ins + params + ")";
+        jobs.push_back(std::move(job));
+    }
 
-        IBPP::Statement st =
-            IBPP::StatementFactory(databaseM->getIBPPDatabase(), tr);
-        st->Prepare(wx2std(ins + params + ")"));
+    // values copied from another table are read when the job starts, so
+    // that table has to be filled and committed before, unless both tables
+    // would then wait for each other
+    for (DataGeneratorJobs::iterator it = jobs.begin(); it != jobs.end();
+        ++it)
+    {
+        DataGeneratorJob* job = (*it).get();
+        for (std::vector<GeneratorSettings *>::iterator gs =
+            job->settings.begin(); gs != job->settings.end(); ++gs)
+        {
+            const wxString& source = (*gs)->sourceTable;
+            if ((*gs)->valueType != GeneratorSettings::vtColumn
+                || source == job->tableName
+                || std::find(job->dependsOn.begin(), job->dependsOn.end(),
+                    source) != job->dependsOn.end())
+            {
+                continue;
+            }
+            std::set<wxString> visited;
+            if (!jobWaitsFor(jobs, source, job->tableName, visited))
+                job->dependsOn.push_back(source);
+        }
+    }
 
-        for (int i = 0; i < records; i++)
+    ProgressDialog pd(this, _("Generating data"), 2);
+    pd.doShow();
+    pd.initProgress(_("Connecting"), jobs.size());
+    pd.initProgress(wxEmptyString, totalRecords, 0, 2);
+
+    size_t connectionCount = spinConnections->GetValue();
+    if (connectionCount < 1)
+        connectionCount = 1;
+    if (connectionCount > jobs.size())
+        connectionCount = jobs.size();
+    std::vector<IBPP::Database> idleConnections;
+    for (size_t i = 0; i < connectionCount; ++i)
+    {
+        IBPP::Database db = databaseM->getIBPPDatabase()->Clone();
+        db->Connect();
+        idleConnections.push_back(db);
+    }
+    int commitEvery = spinCommitEvery->GetValue();
+    wxMBConv* converter = databaseM->getCharsetConverter();
+
+    struct RunningJob
+    {
+        DataGeneratorJob* job;
+        DataGeneratorThread* thread;
+        IBPP::Database connection;
+    };
+    std::list<RunningJob> running;
+    wxString error;
+    bool canceled = false;
+    size_t done = 0;
+    while (true)
+    {
+        // join finished threads and return their attachments to the pool
+        for (std::list<RunningJob>::iterator it = running.begin();
+            it != running.end(); )
         {
-            if (pd.isCanceled())
-                return;
-            pd.stepProgress(1, 2);
-            for (int p = 0; p < st->Parameters(); ++p)
-                setParam(st, p+1, colSet[p], i);
-            st->Execute();
+            if (!(*it).job->finished)
+            {
+                ++it;
+                continue;
+            }
+            (*it).thread->Wait();
+            delete (*it).thread;
+            (*it).job->state = DataGeneratorJob::jsDone;
+            if (!(*it).job->error.empty() && error.empty())
+                error = (*it).job->tableName + ": " + (*it).job->error;
+            idleConnections.push_back((*it).connection);
+            it = running.erase(it);
         }
+        if (!canceled && (pd.isCanceled() || !error.empty()))
+        {
+            // Delete() makes TestDestroy() return true and joins the thread
+            canceled = true;
+            for (std::list<RunningJob>::iterator it = running.begin();
+                it != running.end(); ++it)
+            {
+                (*it).thread->Delete();
+                delete (*it).thread;
+                (*it).job->state = DataGeneratorJob::jsDone;
+                if (!(*it).job->error.empty() && error.empty())
+                    error = (*it).job->tableName + ": " + (*it).job->error;
+            }
+            running.clear();
+        }
+
+        // start all jobs whose referenced tables have been filled
+        done = 0;
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            DataGeneratorJob* job = jobs[i].get();
+            if (job->state == DataGeneratorJob::jsDone)
+                ++done;
+            if (canceled || idleConnections.empty()
+                || job->state != DataGeneratorJob::jsPending)
+            {
+                continue;
+            }
+            bool ready = true;
+            for (size_t j = 0; j < jobs.size() && ready; ++j)
+            {
+                if (jobs[j]->state != DataGeneratorJob::jsDone
+                    && std::find(job->dependsOn.begin(), job->dependsOn.end(),
+                        jobs[j]->tableName) != job->dependsOn.end())
+                {
+                    ready = false;
+                }
+            }
+            if (!ready)
+                continue;
+
+            RunningJob rj;
+            rj.job = job;
+            rj.connection = idleConnections.back();
+            rj.thread = new DataGeneratorThread(job, rj.connection,
+                converter, commitEvery);
+            if (rj.thread->Run() != wxTHREAD_NO_ERROR)
+            {
+                delete rj.thread;
+                error = _("Could not start the data generator thread.");
+                break;
+            }
+            idleConnections.pop_back();
+            job->state = DataGeneratorJob::jsRunning;
+            running.push_back(rj);
+        }
+        if (running.empty() && (canceled || error.empty()))
+            break;
+
+        int inserted = 0;
+        for (size_t i = 0; i < jobs.size(); ++i)
+            inserted += jobs[i]->inserted;
+        pd.setProgressMessage(wxString::Format(
+            _("Inserting into tables (%d running)"), (int)running.size()), 1);
+        pd.setProgressPosition(done, 1);
+        pd.setProgressMessage(wxString::Format(_("Inserted %d of %d records."),
+            inserted, totalRecords), 2);
+        pd.setProgressPosition(inserted, 2);
+        wxMilliSleep(50);
     }
 
-    tr->Commit();
+    if (!error.empty())
+        throw FRError(error);
 }
-
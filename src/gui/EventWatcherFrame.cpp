@@ -33,6 +33,8 @@
 #include <wx/datetime.h>
 #include <wx/ffile.h>
 #include <wx/file.h>
+#include <wx/time.h>
+#include <wx/wupdlock.h>
 
 #include "config/Config.h"
 #include "controls/LogTextControl.h"
@@ -49,6 +51,7 @@ public:
     EventLogControl(wxWindow* parent, wxWindowID id = wxID_ANY);
     void logAction(const wxString& action);
     void logEvent(const wxString& name, int count);
+    void trimLines(int maxLines);
 };
 
 EventLogControl::EventLogControl(wxWindow* parent, wxWindowID id)
@@ -71,8 +74,32 @@ void EventLogControl::logEvent(const wxString& name, int count)
     addStyledText(wxString::Format(" (%d)\n", count), logStyleError);
 }
 
+//! removes the oldest lines so that at most maxLines remain
+void EventLogControl::trimLines(int maxLines)
+{
+    int excess = GetLineCount() - maxLines;
+    if (excess <= 0)
+        return;
+    SetReadOnly(false);
+    DeleteRange(0, PositionFromLine(excess));
+    SetReadOnly(true);
+}
+
+// events are dispatched every timerInterval ms, the log and the statistics
+// are updated every flushInterval ms
+static const int timerInterval = 100;
+static const int flushInterval = 500;
+// weight of the newest interval in the smoothed event rate
+static const double rateSmoothing = 0.3;
+
+EventWatcherFrame::EventStatistics::EventStatistics()
+    : total(0), pending(0), rate(0), peakRate(0)
+{
+}
+
 EventWatcherFrame::EventWatcherFrame(wxWindow* parent, DatabasePtr db)
-    : BaseFrame(parent, -1, wxEmptyString), databaseM(db), eventsM(0)
+    : BaseFrame(parent, -1, wxEmptyString), databaseM(db), eventsM(0),
+        lastFlushM(0)
 {
     wxASSERT(db);
     timerM.SetOwner(this, ID_timer);
@@ -104,10 +131,20 @@ void EventWatcherFrame::createControls()
         _("Monitored events"));
     static_text_received = new wxStaticText(panel_controls, wxID_ANY,
         _("Received events"));
+    static_text_statistics = new wxStaticText(panel_controls, wxID_ANY,
+        _("Event statistics"));
     listbox_monitored = new wxListBox(panel_controls, ID_listbox_monitored,
         wxDefaultPosition, wxDefaultSize, 0, 0, wxLB_EXTENDED);
     eventlog_received = new EventLogControl(panel_controls,
         ID_log_received);
+    listctrl_statistics = new wxListCtrl(panel_controls,
+        ID_listctrl_statistics, wxDefaultPosition, wxDefaultSize,
+        wxLC_REPORT | wxLC_VRULES | wxBORDER_THEME);
+    listctrl_statistics->InsertColumn(0, _("Event"));
+    listctrl_statistics->InsertColumn(1, _("Count"), wxLIST_FORMAT_RIGHT);
+    listctrl_statistics->InsertColumn(2, _("Last received"));
+    listctrl_statistics->InsertColumn(3, _("Rate (/s)"), wxLIST_FORMAT_RIGHT);
+    listctrl_statistics->InsertColumn(4, _("Peak (/s)"), wxLIST_FORMAT_RIGHT);
     button_add = new wxButton(panel_controls, ID_button_add, _("&Add Events"));
     button_remove = new wxButton(panel_controls, ID_button_remove,
         _("&Remove Selected"));
@@ -127,7 +164,11 @@ void EventWatcherFrame::layoutControls()
     wxBoxSizer* sizerLog = new wxBoxSizer(wxVERTICAL);
     sizerLog->Add(static_text_received);
     sizerLog->AddSpacer(styleguide().getControlLabelMargin());
-    sizerLog->Add(eventlog_received, 1, wxEXPAND);
+    sizerLog->Add(eventlog_received, 2, wxEXPAND);
+    sizerLog->AddSpacer(styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerLog->Add(static_text_statistics);
+    sizerLog->AddSpacer(styleguide().getControlLabelMargin());
+    sizerLog->Add(listctrl_statistics, 1, wxEXPAND);
 
     wxBoxSizer* sizerTop = new wxBoxSizer(wxHORIZONTAL);
     sizerTop->Add(sizerList, 2, wxEXPAND);
@@ -243,7 +284,7 @@ DatabasePtr EventWatcherFrame::getDatabase() const
 
 bool EventWatcherFrame::setTimerActive(bool active)
 {
-    if (active && !timerM.Start(100))
+    if (active && !timerM.Start(timerInterval))
         wxMessageBox(_("Can not start timer"), _("Error"), wxOK | wxICON_ERROR);
         
     if (!active && timerM.IsRunning())
@@ -258,6 +299,9 @@ void EventWatcherFrame::updateMonitoringActive()
 {
     if (eventsM != 0)
     {
+        statisticsM.clear();
+        lastFlushM = wxGetLocalTimeMillis();
+        updateStatistics();
         setTimerActive(true);
         button_monitor->SetLabel(_("Stop &Monitoring"));
         eventlog_received->logAction(_("Monitoring started"));
@@ -265,6 +309,7 @@ void EventWatcherFrame::updateMonitoringActive()
     else
     {
         timerM.Stop();
+        flushReceivedEvents();
         button_monitor->SetLabel(_("Start &Monitoring"));
         eventlog_received->logAction(_("Monitoring stopped"));
     }
@@ -274,7 +319,74 @@ void EventWatcherFrame::updateMonitoringActive()
 void EventWatcherFrame::ibppEventHandler(IBPP::Events /*events*/,
     const std::string& name, int count)
 {
-    eventlog_received->logEvent(name, count);
+    EventStatistics& stats = statisticsM[name];
+    stats.total += count;
+    stats.pending += count;
+    stats.lastReceived = wxDateTime::Now();
+}
+
+//! logs one line per event received since the last call, updates the rates
+void EventWatcherFrame::flushReceivedEvents()
+{
+    wxLongLong now = wxGetLocalTimeMillis();
+    long elapsed = (now - lastFlushM).ToLong();
+    lastFlushM = now;
+
+    bool changed = false;
+    for (std::map<std::string, EventStatistics>::iterator it =
+        statisticsM.begin(); it != statisticsM.end(); ++it)
+    {
+        EventStatistics& stats = it->second;
+        if (stats.pending == 0 && stats.rate == 0)
+            continue;
+        changed = true;
+        if (stats.pending)
+            eventlog_received->logEvent(it->first, stats.pending);
+
+        double rate = (elapsed > 0) ? stats.pending * 1000.0 / elapsed : 0;
+        if (rate > stats.peakRate)
+            stats.peakRate = rate;
+        stats.rate += (rate - stats.rate) * rateSmoothing;
+        if (stats.pending == 0 && stats.rate < 0.01)
+            stats.rate = 0;
+        stats.pending = 0;
+    }
+
+    if (changed)
+    {
+        eventlog_received->trimLines(
+            config().get("EventMonitorLogLines", 1000));
+        updateStatistics();
+    }
+}
+
+void EventWatcherFrame::updateStatistics()
+{
+    wxWindowUpdateLocker freeze(listctrl_statistics);
+    if (listctrl_statistics->GetItemCount() != int(statisticsM.size()))
+    {
+        listctrl_statistics->DeleteAllItems();
+        long item = 0;
+        for (std::map<std::string, EventStatistics>::iterator it =
+            statisticsM.begin(); it != statisticsM.end(); ++it, ++item)
+        {
+            listctrl_statistics->InsertItem(item, it->first);
+        }
+    }
+
+    long item = 0;
+    for (std::map<std::string, EventStatistics>::iterator it =
+        statisticsM.begin(); it != statisticsM.end(); ++it, ++item)
+    {
+        const EventStatistics& stats = it->second;
+        listctrl_statistics->SetItem(item, 1, stats.total.ToString());
+        listctrl_statistics->SetItem(item, 2,
+            stats.lastReceived.Format("%H:%M:%S"));
+        listctrl_statistics->SetItem(item, 3,
+            wxString::Format("%.1f", stats.rate));
+        listctrl_statistics->SetItem(item, 4,
+            wxString::Format("%.1f", stats.peakRate));
+    }
 }
 
 //! closes window if database is removed (unregistered)
@@ -437,7 +549,11 @@ void EventWatcherFrame::OnListBoxSelected(wxCommandEvent& WXUNUSED(event))
 void EventWatcherFrame::OnTimer(wxTimerEvent& WXUNUSED(event))
 {
     if (eventsM != 0)
+    {
         eventsM->Dispatch();
+        if ((wxGetLocalTimeMillis() - lastFlushM) >= flushInterval)
+            flushReceivedEvents();
+    }
     else // stop timer, update UI
         updateMonitoringActive();
 }
@@ -27,9 +27,12 @@
 
 #include <wx/wx.h>
 #include <wx/button.h>
+#include <wx/datetime.h>
 #include <wx/listbox.h>
+#include <wx/listctrl.h>
 #include <wx/panel.h>
 
+#include <map>
 #include <string>
 
 #include <ibpp.h>
@@ -50,11 +53,27 @@ private:
     wxTimer timerM;
     IBPP::Events eventsM;
 
+    // events are only counted as they arrive, the log and the statistics
+    // are updated together at most every few hundred milliseconds
+    struct EventStatistics
+    {
+        EventStatistics();
+        wxLongLong total;
+        int pending;
+        wxDateTime lastReceived;
+        double rate;
+        double peakRate;
+    };
+    std::map<std::string, EventStatistics> statisticsM;
+    wxLongLong lastFlushM;
+
     wxPanel* panel_controls;
     wxStaticText* static_text_monitored;
     wxStaticText* static_text_received;
+    wxStaticText* static_text_statistics;
     wxListBox* listbox_monitored;
     EventLogControl* eventlog_received;
+    wxListCtrl* listctrl_statistics;
     wxButton *button_add;
     wxButton *button_remove;
     wxButton *button_load;
@@ -71,6 +90,8 @@ private:
     DatabasePtr getDatabase() const;
     bool setTimerActive(bool active);
     void updateMonitoringActive();
+    void flushReceivedEvents();
+    void updateStatistics();
 
     virtual void ibppEventHandler(IBPP::Events events,
         const std::string& name, int count);
@@ -93,6 +114,7 @@ private:
     {
         ID_listbox_monitored = 101,
         ID_log_received,
+        ID_listctrl_statistics,
         ID_button_add,
         ID_button_remove,
         ID_button_load,
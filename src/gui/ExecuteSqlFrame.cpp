@@ -54,6 +54,7 @@
 #include "gui/controls/ControlUtils.h"
 #include "gui/controls/DataGrid.h"
 #include "gui/controls/DataGridTable.h"
+#include "gui/controls/ResultsetExporter.h"
 #include "gui/GUIURIHandlerHelper.h"
 #include "gui/MetadataItemPropertiesFrame.h"
 #include "gui/ProgressDialog.h"
@@ -64,6 +65,7 @@
 #include "gui/InsertDialog.h"
 #include "gui/InsertParametersDialog.h"
 #include "gui/StatementHistoryDialog.h"
+#include "gui/StatementProfilerDialog.h"
 #include "gui/StyleGuide.h"
 #include "gui/FRStyleManager.h"
 #include "gui/UserDialog.h"
@@ -86,6 +88,7 @@
 #include "sql/IncompleteStatement.h"
 #include "sql/MultiStatement.h"
 #include "sql/SelectStatement.h"
+#include "sql/SqlScriptReader.h"
 #include "sql/SqlStatement.h"
 #include "sql/StatementBuilder.h"
 #include "statementHistory.h"
@@ -556,6 +559,8 @@ ExecuteSqlFrame::ExecuteSqlFrame(wxWindow* WXUNUSED(parent), int id,
     loadingM = true;
     updateEditorCaretPosM = true;
     updateFrameTitleM = true;
+    columnsPrefetchedM = false;
+    profileIdM = 0;
     if (db->getIsVolative())
         prepareVolatileDatabase();
 
@@ -767,10 +772,14 @@ void ExecuteSqlFrame::buildMainMenu(CommandManager& cm)
         cm.getMainMenuItemText(_("Show execution &plan"), Cmds::Query_Show_plan));
     statementMenu->AppendCheckItem(Cmds::Query_Show_Statistics,
         cm.getMainMenuItemText(_("Display detailed query statistics"), Cmds::Query_Show_Statistics));
+    statementMenu->Append(Cmds::Query_Show_Profiles,
+        cm.getMainMenuItemText(_("Statement p&rofiles..."), Cmds::Query_Show_Profiles));
     statementMenu->Append(Cmds::Query_Execute_selection,
         cm.getMainMenuItemText(_("Execute &selection"), Cmds::Query_Execute_selection));
     statementMenu->Append(Cmds::Query_Execute_from_cursor,
         cm.getMainMenuItemText(_("Exec&ute from cursor"), Cmds::Query_Execute_from_cursor));
+    statementMenu->Append(Cmds::Query_Execute_file,
+        cm.getMainMenuItemText(_("Execute script &file..."), Cmds::Query_Execute_file));
     statementMenu->AppendSeparator();
 
     wxMenu* stmtPropMenu = new wxMenu();
@@ -817,6 +826,7 @@ void ExecuteSqlFrame::buildMainMenu(CommandManager& cm)
     gridMenu->AppendSeparator();
     gridMenu->Append(Cmds::DataGrid_Save_as_html,    _("Save as &html"));
     gridMenu->Append(Cmds::DataGrid_Save_as_csv,     _("Save as cs&v"));
+    gridMenu->Append(Cmds::DataGrid_Export_all,      _("&Export all records..."));
     gridMenu->AppendSeparator();
     gridMenu->AppendCheckItem(Cmds::DataGrid_Log_changes, _("&Log data changes"));
     menuBarM->Append(gridMenu, _("&Grid"));
@@ -909,6 +919,8 @@ void ExecuteSqlFrame::doBeforeDestroy()
     // prevent editor from updating the invalid dataset
     if (grid_data->IsCellEditControlEnabled())
         grid_data->EnableCellEditControl(false);
+    // the fetch thread must not outlive the statement and transaction
+    grid_data->stopFetching();
     // make sure that further calls to update() will not call Close() again
     if (databaseM->getIsVolative() && databaseM->isConnected())
         databaseM->disconnect();
@@ -939,6 +951,7 @@ BEGIN_EVENT_TABLE(ExecuteSqlFrame, wxFrame)
     EVT_STC_UPDATEUI(ExecuteSqlFrame::ID_stc_sql, ExecuteSqlFrame::OnSqlEditUpdateUI)
     EVT_STC_CHARADDED(ExecuteSqlFrame::ID_stc_sql, ExecuteSqlFrame::OnSqlEditCharAdded)
     EVT_STC_CHANGE(ExecuteSqlFrame::ID_stc_sql, ExecuteSqlFrame::OnSqlEditChanged)
+    EVT_STC_MODIFIED(ExecuteSqlFrame::ID_stc_sql, ExecuteSqlFrame::OnSqlEditModified)
     EVT_STC_START_DRAG(ExecuteSqlFrame::ID_stc_sql, ExecuteSqlFrame::OnSqlEditStartDrag)
     EVT_SPLITTER_UNSPLIT(wxID_ANY, ExecuteSqlFrame::OnSplitterUnsplit)
     EVT_CHAR_HOOK(ExecuteSqlFrame::OnKeyDown)
@@ -989,13 +1002,16 @@ BEGIN_EVENT_TABLE(ExecuteSqlFrame, wxFrame)
     EVT_MENU(Cmds::Query_Execute,             ExecuteSqlFrame::OnMenuExecute)
     EVT_MENU(Cmds::Query_Show_plan,           ExecuteSqlFrame::OnMenuShowPlan)
     EVT_MENU(Cmds::Query_Show_Statistics,     ExecuteSqlFrame::OnMenuShowStatistics)
+    EVT_MENU(Cmds::Query_Show_Profiles,       ExecuteSqlFrame::OnMenuShowProfiles)
     EVT_UPDATE_UI(Cmds::Query_Show_Statistics, ExecuteSqlFrame::OnMenuUpdateShowStatistics)
     EVT_MENU(Cmds::Query_Execute_selection,   ExecuteSqlFrame::OnMenuExecuteSelection)
     EVT_MENU(Cmds::Query_Execute_from_cursor, ExecuteSqlFrame::OnMenuExecuteFromCursor)
+    EVT_MENU(Cmds::Query_Execute_file,        ExecuteSqlFrame::OnMenuExecuteFile)
     EVT_UPDATE_UI(Cmds::Query_Execute,             ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_UPDATE_UI(Cmds::Query_Show_plan,           ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_UPDATE_UI(Cmds::Query_Execute_selection,   ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_UPDATE_UI(Cmds::Query_Execute_from_cursor, ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
+    EVT_UPDATE_UI(Cmds::Query_Execute_file,        ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_MENU(Cmds::Query_Commit,              ExecuteSqlFrame::OnMenuCommit)
     EVT_MENU(Cmds::Query_Rollback,            ExecuteSqlFrame::OnMenuRollback)
     EVT_UPDATE_UI(Cmds::Query_Commit,         ExecuteSqlFrame::OnMenuUpdateWhenInTransaction)
@@ -1020,6 +1036,7 @@ BEGIN_EVENT_TABLE(ExecuteSqlFrame, wxFrame)
     EVT_MENU(Cmds::DataGrid_ExportBlob,      ExecuteSqlFrame::OnMenuGridExportBlob)
     EVT_MENU(Cmds::DataGrid_Save_as_html,    ExecuteSqlFrame::OnMenuGridSaveAsHtml)
     EVT_MENU(Cmds::DataGrid_Save_as_csv,     ExecuteSqlFrame::OnMenuGridSaveAsCsv)
+    EVT_MENU(Cmds::DataGrid_Export_all,      ExecuteSqlFrame::OnMenuGridExportAll)
     EVT_MENU(Cmds::DataGrid_FetchAll,        ExecuteSqlFrame::OnMenuGridFetchAll)
     EVT_MENU(Cmds::DataGrid_CancelFetchAll,  ExecuteSqlFrame::OnMenuGridCancelFetchAll)
 
@@ -1034,6 +1051,7 @@ BEGIN_EVENT_TABLE(ExecuteSqlFrame, wxFrame)
     EVT_UPDATE_UI(Cmds::DataGrid_ExportBlob,     ExecuteSqlFrame::OnMenuUpdateGridCellIsBlob)
     EVT_UPDATE_UI(Cmds::DataGrid_Save_as_html,   ExecuteSqlFrame::OnMenuUpdateGridHasSelection)
     EVT_UPDATE_UI(Cmds::DataGrid_Save_as_csv,    ExecuteSqlFrame::OnMenuUpdateGridHasSelection)
+    EVT_UPDATE_UI(Cmds::DataGrid_Export_all,     ExecuteSqlFrame::OnMenuUpdateGridExportAll)
     EVT_UPDATE_UI(Cmds::DataGrid_FetchAll,       ExecuteSqlFrame::OnMenuUpdateGridFetchAll)
     EVT_UPDATE_UI(Cmds::DataGrid_CancelFetchAll, ExecuteSqlFrame::OnMenuUpdateGridCancelFetchAll)
 
@@ -1215,6 +1233,70 @@ void ExecuteSqlFrame::OnSqlEditChanged(wxStyledTextEvent& WXUNUSED(event))
     updateFrameTitleM = true;
 }
 
+void ExecuteSqlFrame::OnSqlEditModified(wxStyledTextEvent& event)
+{
+    // statements after the changed text have to be split again
+    if (event.GetModificationType()
+        & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT))
+    {
+        statementIndexM.invalidate(event.GetPosition());
+    }
+    event.Skip();
+}
+
+// SqlEditorInputStream: reads the (UTF-8 encoded) text of an editor control
+// from any position, used to split the text with StatementIndex
+class SqlEditorInputStream: public wxInputStream
+{
+private:
+    wxStyledTextCtrl* editorM;
+    wxFileOffset positionM;
+protected:
+    virtual size_t OnSysRead(void* buffer, size_t size)
+    {
+        wxFileOffset length = editorM->GetLength();
+        if (positionM >= length)
+        {
+            m_lasterror = wxSTREAM_EOF;
+            return 0;
+        }
+        int end = int(std::min<wxFileOffset>(length, positionM + size));
+        wxCharBuffer text(editorM->GetTextRangeRaw(int(positionM), end));
+        size = end - positionM;
+        memcpy(buffer, text.data(), size);
+        positionM = end;
+        return size;
+    }
+    virtual wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode)
+    {
+        if (mode == wxFromCurrent)
+            pos += positionM;
+        else if (mode == wxFromEnd)
+            pos += editorM->GetLength();
+        if (pos < 0)
+            return wxInvalidOffset;
+        positionM = pos;
+        return positionM;
+    }
+    virtual wxFileOffset OnSysTell() const
+    {
+        return positionM;
+    }
+public:
+    SqlEditorInputStream(wxStyledTextCtrl* editor)
+        : wxInputStream(), editorM(editor), positionM(0)
+    {
+    }
+    virtual bool IsSeekable() const
+    {
+        return true;
+    }
+    virtual wxFileOffset GetLength() const
+    {
+        return editorM->GetLength();
+    }
+};
+
 void ExecuteSqlFrame::autoCompleteColumns(int pos, int len)
 {
     int start;
@@ -1233,8 +1315,31 @@ void ExecuteSqlFrame::autoCompleteColumns(int pos, int len)
             return;
     }
     wxString table = styled_text_ctrl_sql->GetTextRange(start, pos-1);
-    IncompleteStatement is(databaseM, styled_text_ctrl_sql->GetText());
-    wxString columns = is.getObjectColumns(table, pos, len>0 || config().get("autoCompleteLoadColumnsSort", false));//When the user are typing something, you need to sort de result, else intelisense won't work properly
+    // load the columns of all relations with the first completion, so that
+    // the following ones don't need a database round trip per relation
+    if (!columnsPrefetchedM && databaseM->isConnected()
+        && config().get("AutoCompletePrefetchColumns", true))
+    {
+        columnsPrefetchedM = true;
+        databaseM->prefetchRelationColumns();
+    }
+    // only the statement at the cursor is parsed, the statement boundaries
+    // are kept in the index and don't need to be searched in the whole text
+    SqlEditorInputStream script(styled_text_ctrl_sql);
+    wxFileOffset stmStart, stmEnd;
+    wxString terminator;
+    if (!statementIndexM.getStatementAt(script, pos, stmStart, stmEnd,
+        terminator))
+    {
+        return;
+    }
+    wxString sql(styled_text_ctrl_sql->GetTextRange(int(stmStart),
+        int(stmEnd)));
+    int stmPos = 0;
+    if (pos > stmStart)
+        stmPos = styled_text_ctrl_sql->GetTextRange(int(stmStart), pos).length();
+    IncompleteStatement is(databaseM, sql, terminator);
+    wxString columns = is.getObjectColumns(table, stmPos, len>0 || config().get("autoCompleteLoadColumnsSort", false));//When the user are typing something, you need to sort de result, else intelisense won't work properly
     if (columns.IsEmpty())
         return;
     if (HasWord(styled_text_ctrl_sql->GetTextRange(pos, pos+len), columns))
@@ -1669,6 +1774,12 @@ void ExecuteSqlFrame::OnMenuUpdateShowStatistics(wxUpdateUIEvent& event)
     event.Check(showStatisticsM);
 }
 
+void ExecuteSqlFrame::OnMenuShowProfiles(wxCommandEvent& WXUNUSED(event))
+{
+    StatementProfilerDialog spd(this);
+    spd.ShowModal();
+}
+
 void ExecuteSqlFrame::OnMenuExecuteFromCursor(wxCommandEvent& WXUNUSED(event))
 {
     clearLogBeforeExecution();
@@ -1682,6 +1793,21 @@ void ExecuteSqlFrame::OnMenuExecuteFromCursor(wxCommandEvent& WXUNUSED(event))
     parseStatements(sql, false, false, styled_text_ctrl_sql->GetCurrentPos());
 }
 
+void ExecuteSqlFrame::OnMenuExecuteFile(wxCommandEvent& WXUNUSED(event))
+{
+    wxFileDialog fd(this, _("Execute Script File"), filenameM.GetPath(),
+        wxEmptyString,
+        _("SQL script files (*.sql)|*.sql|All files (*.*)|*.*"),
+        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (wxID_OK != fd.ShowModal())
+        return;
+
+    clearLogBeforeExecution();
+    executeScriptFile(fd.GetPath());
+    if (!inTransactionM)
+        setViewMode(false, vmEditor);
+}
+
 void ExecuteSqlFrame::OnMenuExecuteSelection(wxCommandEvent& WXUNUSED(event))
 {
     clearLogBeforeExecution();
@@ -1993,6 +2119,30 @@ void ExecuteSqlFrame::OnMenuGridSaveAsHtml(wxCommandEvent& WXUNUSED(event))
     grid_data->saveAsHTML();
 }
 
+// reads the delimiters chosen in the settings of the save_as_csv template,
+// the values are indexes of the radio boxes in save_as_csv.confdef
+static bool getCSVDelimiters(Config& csvConfig, wxChar& fieldDelimiter,
+    wxChar& textDelimiter)
+{
+    int i;
+    if (!csvConfig.getValue("CSVFieldDelimiter", i))
+        return false;
+    static const wxChar fieldDelimiters[] = { '\t', ',', ';' };
+    if (i < 0 || i >= sizeof(fieldDelimiters) / sizeof(wxChar))
+        return false;
+    wxChar field(fieldDelimiters[i]);
+
+    if (!csvConfig.getValue("CSVTextDelimiter", i))
+        return false;
+    static const wxChar textDelimiters[] = { '\0', '"', '\'' };
+    if (i < 0 || i >= sizeof(textDelimiters) / sizeof(wxChar))
+        return false;
+
+    fieldDelimiter = field;
+    textDelimiter = textDelimiters[i];
+    return true;
+}
+
 void ExecuteSqlFrame::OnMenuGridSaveAsCsv(wxCommandEvent& WXUNUSED(event))
 {
     CodeTemplateProcessor ctp(0, this);
@@ -2004,22 +2154,74 @@ void ExecuteSqlFrame::OnMenuGridSaveAsCsv(wxCommandEvent& WXUNUSED(event))
     if (!ctp.getConfig().getValue("CSVExportFileName", fileName))
         return;
 
-    int i;
-    if (!ctp.getConfig().getValue("CSVFieldDelimiter", i))
+    wxChar fieldDelimiter, textDelimiter;
+    if (!getCSVDelimiters(ctp.getConfig(), fieldDelimiter, textDelimiter))
         return;
-    static const wxChar fieldDelimiters[] = { '\t', ',', ';' };
-    if (i < 0 || i >= sizeof(fieldDelimiters) / sizeof(wxChar))
+    grid_data->saveAsCSV(fileName, fieldDelimiter, textDelimiter);
+}
+
+void ExecuteSqlFrame::OnMenuGridExportAll(wxCommandEvent& WXUNUSED(event))
+{
+    if (statementM == 0 || !grid_data->getDataGridTable())
         return;
-    wxChar fieldDelimiter(fieldDelimiters[i]);
 
-    if (!ctp.getConfig().getValue("CSVTextDelimiter", i))
+    // CSV files use the delimiters of "Save as CSV", commas and quotes if
+    // that has never been used
+    Config csvConfig;
+    csvConfig.setConfigFileName(TemplateProcessor::getConfigFileName(
+        config().getSysTemplateFileName("save_as_csv")));
+    wxChar fieldDelimiter = ',', textDelimiter = '"';
+    getCSVDelimiters(csvConfig, fieldDelimiter, textDelimiter);
+
+    // executing anything else again would repeat its data changes, so for
+    // RETURNING clauses and procedures only the rows in the grid are saved
+    if (statementM->Type() != IBPP::stSelect)
+    {
+        wxString fileName = ::wxFileSelector(_("Export fetched records"),
+            "", "", "csv", _("CSV files (*.csv)|*.csv|All files (*.*)|*.*"),
+            wxFD_SAVE | wxFD_OVERWRITE_PROMPT, this);
+        if (fileName.IsEmpty())
+            return;
+        grid_data->saveAsCSV(fileName, fieldDelimiter, textDelimiter);
+        log(wxString::Format(
+            _("The statement is not a select, only the fetched rows were exported to %s."),
+            fileName.c_str()));
         return;
-    static const wxChar textDelimiters[] = { '\0', '"', '\'' };
-    if (i < 0 || i >= sizeof(textDelimiters) / sizeof(wxChar))
+    }
+
+    wxString fileName = ::wxFileSelector(_("Export all records"), "", "",
+        "csv", _("CSV files (*.csv)|*.csv|JSON Lines files (*.jsonl)|*.jsonl|Columnar binary files (*.frc)|*.frc|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT, this);
+    if (fileName.IsEmpty())
         return;
-    wxChar textDelimiter(textDelimiters[i]);
 
-    grid_data->saveAsCSV(fileName, fieldDelimiter, textDelimiter);
+    // the background fetch uses the same transaction
+    grid_data->stopFetching();
+
+    // the statement is executed again, rows are written to the file as they
+    // are fetched and never added to the grid
+    ResultsetExporter exporter(databaseM,
+        ResultsetExporter::getFormatForFileName(fileName));
+    exporter.setCSVDelimiters(fieldDelimiter, textDelimiter);
+    wxString sql(statementM->Sql().c_str(), *databaseM->getCharsetConverter());
+    ProgressDialog pd(this, _("Exporting records"));
+    pd.doShow();
+    unsigned rows = exporter.exportSql(sql, transactionM, fileName, &pd);
+    if (exporter.isCanceled())
+    {
+        log(wxString::Format(_("Export canceled, %s has been deleted."),
+            fileName.c_str()));
+        return;
+    }
+    log(wxString::Format(_("%u rows exported to %s."), rows,
+        fileName.c_str()));
+}
+
+void ExecuteSqlFrame::OnMenuUpdateGridExportAll(wxUpdateUIEvent& event)
+{
+    event.Enable(statementM != 0 && grid_data->getDataGridTable()
+        && grid_data->GetNumberCols() && transactionM != 0
+        && transactionM->Started());
 }
 
 
@@ -2187,6 +2389,7 @@ void ExecuteSqlFrame::prepareAndExecute(bool prepareOnly)
     bool hasSelection = styled_text_ctrl_sql->GetSelectionStart()
         != styled_text_ctrl_sql->GetSelectionEnd();
     bool ok;
+    wxStopWatch sw;
     if (hasSelection && config().get("OnlyExecuteSelected", false))
     {
         if (config().get("TreatAsSingleStatement", false))
@@ -2210,7 +2413,9 @@ void ExecuteSqlFrame::prepareAndExecute(bool prepareOnly)
     {
         // add to history
         StatementHistory& sh = StatementHistory::get(databaseM);
-        sh.add(styled_text_ctrl_sql->GetText());
+        sh.add(styled_text_ctrl_sql->GetText(), ok
+            ? StatementHistory::erSucceeded : StatementHistory::erFailed,
+            sw.Time());
         historyPositionM = sh.size();
     }
 
@@ -2222,13 +2427,16 @@ void ExecuteSqlFrame::prepareAndExecute(bool prepareOnly)
 void ExecuteSqlFrame::executeAllStatements(bool closeWhenDone)
 {
     clearLogBeforeExecution();
+    wxStopWatch sw;
     bool ok = parseStatements(styled_text_ctrl_sql->GetText(), closeWhenDone);
     if (config().get("historyStoreGenerated", true) &&
         (ok || config().get("historyStoreUnsuccessful", true)))
     {
         // add buffer to history
         StatementHistory& sh = StatementHistory::get(databaseM);
-        sh.add(styled_text_ctrl_sql->GetText());
+        sh.add(styled_text_ctrl_sql->GetText(), ok
+            ? StatementHistory::erSucceeded : StatementHistory::erFailed,
+            sw.Time());
         historyPositionM = sh.size();
     }
 
@@ -2308,61 +2516,260 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
     return true;
 }
 
+//! Executes the statements of a script file while it is read, the file is
+//! neither loaded into the editor nor are the statements logged one by one,
+//! so scripts of any size can be executed with constant memory use
+bool ExecuteSqlFrame::executeScriptFile(const wxString& fileName)
+{
+    SqlScriptReader reader;
+    if (!reader.open(fileName))
+        return false;
+
+    ScrollAtEnd sae(styled_text_ctrl_stats);
+    log(wxString::Format(_("Executing script file: %s"), fileName.c_str()));
+    // commit every n statements, so that the server doesn't have to keep
+    // the changes of the entire script in one transaction
+    int commitInterval = config().get("ScriptFileCommitInterval", 10000);
+    bool logStatements = menuBarM->IsChecked(Cmds::History_EnableLogging);
+
+    ProgressDialog pd(this, _("Executing Script File"));
+    pd.doShow();
+    // the file size may be larger than the range of the progress bar
+    pd.initProgress(wxEmptyString, 1000);
+
+    grid_data->stopFetching();
+    grid_data->ClearGrid();
+
+    wxStopWatch sw;
+    long lastProgressTime = -1000;
+    unsigned long executed = 0;
+    int uncommitted = 0;
+    bool ok = true;
+    while (ok)
+    {
+        long elapsed = sw.Time();
+        if (elapsed - lastProgressTime >= 250)
+        {
+            lastProgressTime = elapsed;
+            wxFileOffset pos = reader.getPosition();
+            wxFileOffset size = reader.getSize();
+            double secs = (elapsed > 0) ? 0.001 * elapsed : 0.001;
+            pd.setProgressMessage(wxString::Format(
+                _("Line %d, %s of %s, %lu statements (%.0f statements/s, %s/s)"),
+                reader.getLine(),
+                wxFileName::GetHumanReadableSize(wxULongLong(pos)).c_str(),
+                wxFileName::GetHumanReadableSize(wxULongLong(size)).c_str(),
+                executed, executed / secs,
+                wxFileName::GetHumanReadableSize(
+                    wxULongLong(wxULongLong_t(pos / secs))).c_str()));
+            if (size > 0)
+                pd.setProgressPosition(size_t(pos * 1000 / size));
+            if (pd.isCanceled())
+            {
+                log(_("Script execution canceled."), ttError);
+                ok = false;
+                break;
+            }
+        }
+
+        SingleStatement ss;
+        try
+        {
+            ss = reader.getNextStatement();
+        }
+        catch (FRError& e)
+        {
+            log(e.what(), ttError);
+            ok = false;
+            break;
+        }
+        if (!ss.isValid())
+            break;
+
+        wxString newTerminator, autoDDLSetting;
+        if (ss.isCommitStatement())
+        {
+            ok = commitTransaction();
+            uncommitted = 0;
+        }
+        else if (ss.isRollbackStatement())
+        {
+            rollbackTransaction();
+            uncommitted = 0;
+        }
+        else if (ss.isSetTermStatement(newTerminator))
+        {
+            log(_("SET TERM command found without terminator.\nStopping further execution."),
+                ttError);
+            ok = false;
+        }
+        else if (ss.isSetAutoDDLStatement(autoDDLSetting))
+        {
+            if (autoDDLSetting.CmpNoCase("ON") == 0)
+                autoCommitM = true;
+            else if (autoDDLSetting.CmpNoCase("OFF") == 0)
+                autoCommitM = false;
+            else if (autoDDLSetting.empty())
+                autoCommitM = !autoCommitM;
+            else
+            {
+                log(_("SET AUTODDL command found with invalid parameter (has to be \"ON\" or \"OFF\").\nStopping further execution."),
+                    ttError);
+                ok = false;
+            }
+        }
+        else if (!ss.isEmptyStatement())
+        {
+            wxString sql(ss.getSql());
+            SqlStatement stm(sql, databaseM, reader.getTerminator());
+            try
+            {
+                if (stm.getAction() == actCONNECT
+                    || stm.getAction() == actCREATE_DATABASE
+                    || stm.getAction() == actDISCONNECT)
+                {
+                    throw FRError(_("Cannot use 'connect', 'create' or 'disconnect' statements in a script file."));
+                }
+                startTransaction();
+                statementM = IBPP::StatementFactory(
+                    databaseM->getIBPPDatabase(), transactionM);
+                statementM->Prepare(wx2std(sql,
+                    databaseM->getCharsetConverter()));
+                if (statementM->ParametersByName().size() > 0)
+                    throw FRError(_("Statements with parameters can not be executed from a script file."));
+                statementM->Execute();
+                ++executed;
+                ++uncommitted;
+
+                // only keep the statements needed to update the metadata
+                // and to log them after the commit
+                if (stm.isDDL() || logStatements)
+                    executedStatementsM.push_back(stm);
+                if (stm.isDDL() && autoCommitM)
+                {
+                    ok = commitTransaction();
+                    uncommitted = 0;
+                }
+                else if (commitInterval > 0 && uncommitted >= commitInterval)
+                {
+                    ok = commitTransaction();
+                    uncommitted = 0;
+                }
+            }
+            catch (IBPP::Exception& e)
+            {
+                log(wxString(e.what(), *databaseM->getCharsetConverter()),
+                    ttError);
+                ok = false;
+            }
+            catch (std::exception& e)
+            {
+                log(_("Error: ") + e.what(), ttError);
+                ok = false;
+            }
+            if (!ok)
+            {
+                log(wxString::Format(_("Error in statement at line %d:"),
+                    reader.getLine()), ttError);
+                log(sql, ttSql);
+            }
+        }
+    }
+
+    pd.doHide();
+    if (!ok)
+        splitScreen();
+    log(wxString::Format(_("%lu statements executed in %s."), executed,
+        millisToTimeString(sw.Time()).c_str()));
+    if (ok)
+        log(_("Script execution finished."));
+    return ok;
+}
+
 void ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible(wxUpdateUIEvent& event)
 {
     event.Enable(!closeWhenTransactionDoneM);
 }
 
 void ExecuteSqlFrame::compareCounts(IBPP::DatabaseCounts& one,
-    IBPP::DatabaseCounts& two)
+    IBPP::DatabaseCounts& two, std::vector<ProfileTableCounts>& tables,
+    bool logCounts)
 {
     for (IBPP::DatabaseCounts::iterator it = two.begin(); it != two.end();
         ++it)
     {
-        wxString str_log;
         IBPP::DatabaseCounts::iterator i2 = one.find((*it).first);
         IBPP::CountInfo c;
         IBPP::CountInfo& r1 = (*it).second;
         IBPP::CountInfo& r2 = c;
         if (i2 != one.end())
             r2 = (*i2).second;
-        if (r1.inserts > r2.inserts)
-            str_log += wxString::Format(_("%d inserts. "), r1.inserts - r2.inserts);
-        if (r1.updates > r2.updates)
-            str_log += wxString::Format(_("%d updates. "), r1.updates - r2.updates);
-        if (r1.deletes > r2.deletes)
-            str_log += wxString::Format(_("%d deletes. "), r1.deletes - r2.deletes);
-        if (r1.readIndex > r2.readIndex)
-            str_log += wxString::Format(_("%d reads index. "), r1.readIndex - r2.readIndex);
-        if (r1.readSequence > r2.readSequence)
-            str_log += wxString::Format(_("%d reads sequence. "), r1.readSequence - r2.readSequence);
-        if (!str_log.IsEmpty())
+
+        ProfileTableCounts counts;
+        counts.relationId = (*it).first;
+        counts.inserts = std::max(r1.inserts - r2.inserts, 0);
+        counts.updates = std::max(r1.updates - r2.updates, 0);
+        counts.deletes = std::max(r1.deletes - r2.deletes, 0);
+        counts.indexedReads = std::max(r1.readIndex - r2.readIndex, 0);
+        counts.naturalReads = std::max(r1.readSequence - r2.readSequence, 0);
+        if (!counts.inserts && !counts.updates && !counts.deletes
+            && !counts.indexedReads && !counts.naturalReads)
         {
-            wxString relName;
-            try
-            {
-                IBPP::Statement st = IBPP::StatementFactory(
-                    databaseM->getIBPPDatabase(), transactionM);
-                st->Prepare(
-                    "select rdb$relation_name "
-                    "from rdb$relations where rdb$relation_id = ?");
-                st->Set(1, (*it).first);
-                st->Execute();
-                if (st->Fetch())
-                {
-                    std::string s;
-                    st->Get(1, s);
-                    relName = std2wxIdentifier(s, databaseM->getCharsetConverter());
-                }
-            }
-            catch (...)
-            {
-            }
-            if (relName.IsEmpty())
-                relName.Format(_("Relation #%d"), (*it).first);
-            log(relName + ": " + str_log, ttSql);
+            continue;
+        }
+        counts.relationName = getRelationName(counts.relationId);
+        tables.push_back(counts);
+
+        if (!logCounts)
+            continue;
+        wxString str_log;
+        if (counts.inserts)
+            str_log += wxString::Format(_("%d inserts. "), counts.inserts);
+        if (counts.updates)
+            str_log += wxString::Format(_("%d updates. "), counts.updates);
+        if (counts.deletes)
+            str_log += wxString::Format(_("%d deletes. "), counts.deletes);
+        if (counts.indexedReads)
+            str_log += wxString::Format(_("%d reads index. "), counts.indexedReads);
+        if (counts.naturalReads)
+            str_log += wxString::Format(_("%d reads sequence. "), counts.naturalReads);
+        log(counts.relationName + ": " + str_log, ttSql);
+    }
+}
+
+// relation ids are looked up once per editor, the cache is cleared
+// whenever DDL statements are executed
+wxString ExecuteSqlFrame::getRelationName(int relationId)
+{
+    std::map<int, wxString>::iterator it = relationNamesM.find(relationId);
+    if (it != relationNamesM.end())
+        return (*it).second;
+
+    wxString relName;
+    try
+    {
+        IBPP::Statement st = IBPP::StatementFactory(
+            databaseM->getIBPPDatabase(), transactionM);
+        st->Prepare(
+            "select rdb$relation_name "
+            "from rdb$relations where rdb$relation_id = ?");
+        st->Set(1, relationId);
+        st->Execute();
+        if (st->Fetch())
+        {
+            std::string s;
+            st->Get(1, s);
+            relName = std2wxIdentifier(s, databaseM->getCharsetConverter());
         }
     }
+    catch (...)
+    {
+    }
+    if (relName.IsEmpty())
+        relName.Printf(_("Relation #%d"), relationId);
+    else
+        relationNamesM[relationId] = relName;
+    return relName;
 }
 
 wxString millisToTimeString(long millis)
@@ -2451,45 +2858,26 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
     wxStopWatch swTotal;
     bool retval = true;
     long waitForParameterInputTime = 0;
+    bool doProfile = !prepareOnly
+        && config().get("SQLEditorProfileStatements", true);
+    StatementProfile profile;
+    profile.executedAt = wxDateTime::Now();
+    profile.databaseName = databaseM->getName_();
+    profile.sql = sql;
+    profileIdM = 0;
     try
     {
-        if (transactionM == 0 || !transactionM->Started())
-        {
-            log(_("Starting transaction..."));
-
-            // fix the IBPP::LogicException "No Database is attached."
-            // which happens after a database reconnect
-            // (this action detaches the database from all its transactions)
-            if (transactionM != 0 && !transactionM->Started())
-            {
-                try
-                {
-                    transactionM->Start();
-                }
-                catch (IBPP::LogicException&)
-                {
-                    transactionM = 0;
-                }
-            }
-
-            if (transactionM == 0)
-            {
-                transactionM = IBPP::TransactionFactory(
-                    databaseM->getIBPPDatabase(), transactionAccessModeM,
-                    transactionIsolationLevelM, transactionLockResolutionM);
-            }
-            transactionM->Start();
-            inTransaction(true);
-
-            grid_data->EnableEditing(transactionAccessModeM == IBPP::amWrite);
-        }
+        startTransaction();
 
+        // the fetch thread uses the same database connection
+        grid_data->stopFetching();
         int fetch1 = 0, mark1 = 0, read1 = 0, write1 = 0, ins1 = 0, upd1 = 0,
             del1 = 0, ridx1 = 0, rseq1 = 0, mem1 = 0;
         int fetch2, mark2, read2, write2, ins2, upd2, del2, ridx2, rseq2, mem2;
         IBPP::DatabaseCounts counts1, counts2;
         bool doShowStats = showStatisticsM;
-        if (!prepareOnly && doShowStats)
+        bool doCounts = doShowStats || doProfile;
+        if (!prepareOnly && doCounts)
         {
             databaseM->getIBPPDatabase()->
                 Statistics(&fetch1, &mark1, &read1, &write1, &mem1);
@@ -2504,8 +2892,9 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
         {
             wxStopWatch sw;
             statementM->Prepare(wx2std(sql, databaseM->getCharsetConverter()));
+            profile.prepareTime = sw.Time();
             log(wxString::Format(_("Statement prepared (elapsed time: %s)."),
-                millisToTimeString(sw.Time()).c_str()));
+                millisToTimeString(profile.prepareTime).c_str()));
         }
 
         // we don't check IBPP::Select since Firebird 2.0 has a new feature
@@ -2515,6 +2904,9 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
         {
             int cols = statementM->Columns();
             hasColumns = cols > 0;
+            // the fetched size of a row is bounded by its column buffers
+            for (int i = 1; i <= cols; i++)
+                profile.rowSize += statementM->ColumnSize(i);
             if (doShowStats)
             {
                 for (int i = 1; i <= cols; i++)
@@ -2577,34 +2969,42 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
         log(wxEmptyString);
         log(_("Executing statement..."));
         sae.scroll();
-        {
-            wxStopWatch sw;
-            statementM->Execute();
-            log(wxString::Format(_("Statement executed (elapsed time: %s)."),
-                millisToTimeString(sw.Time()).c_str()));
-        }
+        profileStopWatchM.Start();
+        statementM->Execute();
+        profile.executeTime = profileStopWatchM.Time();
+        log(wxString::Format(_("Statement executed (elapsed time: %s)."),
+            millisToTimeString(profile.executeTime).c_str()));
         IBPP::STT type = statementM->Type();
         if (hasColumns)            // for select statements: show data
         {
             grid_data->fetchData(transactionAccessModeM == IBPP::amRead);
+            profile.firstRowsTime = profileStopWatchM.Time();
             setViewMode(vmGrid);
         }
 
-        if (doShowStats)
+        if (doCounts)
         {
             databaseM->getIBPPDatabase()->Statistics(
                 &fetch2, &mark2, &read2, &write2, &mem2);
             databaseM->getIBPPDatabase()->
                 Counts(&ins2, &upd2, &del2, &ridx2, &rseq2);
-            log(wxString::Format(
-                _("%d fetches, %d marks, %d reads, %d writes."),
-                fetch2-fetch1, mark2-mark1, read2-read1, write2-write1));
-            log(wxString::Format(
-                _("%d inserts, %d updates, %d deletes, %d index, %d seq."),
-                ins2-ins1, upd2-upd1, del2-del1, ridx2-ridx1, rseq2-rseq1));
-            log(wxString::Format(_("Delta memory: %d bytes."), mem2-mem1));
+            if (doShowStats)
+            {
+                log(wxString::Format(
+                    _("%d fetches, %d marks, %d reads, %d writes."),
+                    fetch2-fetch1, mark2-mark1, read2-read1, write2-write1));
+                log(wxString::Format(
+                    _("%d inserts, %d updates, %d deletes, %d index, %d seq."),
+                    ins2-ins1, upd2-upd1, del2-del1, ridx2-ridx1, rseq2-rseq1));
+                log(wxString::Format(_("Delta memory: %d bytes."), mem2-mem1));
+            }
             databaseM->getIBPPDatabase()->DetailedCounts(counts2);
-            compareCounts(counts1, counts2);
+            compareCounts(counts1, counts2, profile.tables, doShowStats);
+            profile.hasCounts = true;
+            profile.fetches = fetch2 - fetch1;
+            profile.marks = mark2 - mark1;
+            profile.reads = read2 - read1;
+            profile.writes = write2 - write1;
         }
 
         if (type != IBPP::stSelect) // for other statements: show rows affected
@@ -2622,6 +3022,7 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
                     wxString addon;
                     if (statementM->AffectedRows() % 10 != 1)
                         addon = "s";
+                    profile.rows = statementM->AffectedRows();
                     wxString s = wxString::Format(_("%d row%s affected directly."),
                         statementM->AffectedRows(), addon.c_str());
                     log("" + s);
@@ -2632,7 +3033,10 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
                 }
             }
             if (stm.isDDL())
+            {
                 type = IBPP::stDDL;
+                relationNamesM.clear();
+            }
             executedStatementsM.push_back(stm);
             setViewMode(vmEditor);
             if (type == IBPP::stDDL && autoCommitM)
@@ -2663,11 +3067,66 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
         retval = false;
     }
 
+    if (doProfile)
+    {
+        profile.succeeded = retval;
+        if (profile.firstRowsTime >= 0)
+        {
+            // OnGridRowCountChanged() completes the profile while rows
+            // are fetched, the first batch has been fetched already
+            long rows = grid_data->GetNumberRows();
+            profile.rows = rows;
+            profile.bytes = wxLongLong(rows) * profile.rowSize;
+            if (!grid_data->getDataGridTable()->canFetchMoreRows())
+                profile.fetchTime = profile.firstRowsTime;
+        }
+        unsigned id = StatementProfiler::get().add(profile);
+        if (profile.firstRowsTime >= 0 && profile.fetchTime < 0)
+            profileIdM = id;
+    }
+
     log(wxString::Format(_("Total execution time: %s"),
         millisToTimeString(swTotal.Time() - waitForParameterInputTime).c_str()));
     return retval;
 }
 
+// starts the transaction unless it has been started already, IBPP
+// exceptions are handled by the caller
+void ExecuteSqlFrame::startTransaction()
+{
+    if (transactionM != 0 && transactionM->Started())
+        return;
+
+    log(_("Starting transaction..."));
+
+    // fix the IBPP::LogicException "No Database is attached."
+    // which happens after a database reconnect
+    // (this action detaches the database from all its transactions)
+    if (transactionM != 0 && !transactionM->Started())
+    {
+        try
+        {
+            transactionM->Start();
+        }
+        catch (IBPP::LogicException&)
+        {
+            transactionM = 0;
+        }
+    }
+
+    if (transactionM == 0)
+    {
+        transactionM = IBPP::TransactionFactory(
+            databaseM->getIBPPDatabase(), transactionAccessModeM,
+            transactionIsolationLevelM, transactionLockResolutionM);
+    }
+    if (!transactionM->Started())
+        transactionM->Start();
+    inTransaction(true);
+
+    grid_data->EnableEditing(transactionAccessModeM == IBPP::amWrite);
+}
+
 void ExecuteSqlFrame::splitScreen()
 {
     if (!splitter_window_1->IsSplit()) // split screen if needed
@@ -2769,6 +3228,7 @@ bool ExecuteSqlFrame::commitTransaction()
         sae.scroll();
         {
             wxStopWatch sw;
+            grid_data->stopFetching();
             statementM->Close();
             transactionM->Commit();
             log(wxString::Format(_("Transaction committed (elapsed time: %s)."),
@@ -2780,15 +3240,7 @@ bool ExecuteSqlFrame::commitTransaction()
         SubjectLocker locker(databaseM);
         // log statements, done before parsing in case parsing crashes FR
         if (menuBarM->IsChecked(Cmds::History_EnableLogging))
-        {
-            for (std::vector<SqlStatement>::const_iterator it =
-                executedStatementsM.begin(); it != executedStatementsM.end();
-                ++it)
-            {
-                if (!Logger::logStatement(*it, databaseM))
-                    break;
-            }
-        }
+            Logger::logStatements(executedStatementsM, databaseM);
 
         // parse all successfully executed statements
         for (std::vector<SqlStatement>::const_iterator it =
@@ -2864,6 +3316,7 @@ bool ExecuteSqlFrame::rollbackTransaction()
         sae.scroll();
         {
             wxStopWatch sw;
+            grid_data->stopFetching();
             statementM->Close();
             transactionM->Rollback();
             log(wxString::Format(_("Transaction rolled back (elapsed time: %s)."),
@@ -3038,6 +3491,18 @@ void ExecuteSqlFrame::OnGridRowCountChanged(wxCommandEvent& event)
     s.Printf(_("%ld row(s) fetched"), rowsFetched);
     statusbar_1->SetStatusText(s, 1);
 
+    if (StatementProfile* profile = StatementProfiler::get().find(profileIdM))
+    {
+        profile->rows = rowsFetched;
+        profile->bytes = wxLongLong(rowsFetched) * profile->rowSize;
+        DataGridTable* table = grid_data->getDataGridTable();
+        if (!table || !table->canFetchMoreRows())
+        {
+            profile->fetchTime = profileStopWatchM.Time();
+            profileIdM = 0;
+        }
+    }
+
     // TODO: we could make some bool flag, so that this happens only once per execute()
     //       to fix the problem when user does the select, unsplits the window
     //       and then browses the grid, which fetches more records and unsplits again
@@ -3643,6 +4108,19 @@ bool EditDDLHandler::handleURI(URI& uri)
 
     ProgressDialog pd(w, _("Extracting DDL Definitions"), 2);
     pd.doShow();
+    // extracting the DDL of the whole database needs all columns,
+    // constraints and indices, load them in a few queries up front
+    if (m == db.get())
+    {
+        try
+        {
+            db->prefetchMetadata(&pd);
+        }
+        catch (CancelProgressException&)
+        {
+            return true;
+        }
+    }
     CreateDDLVisitor cdv(&pd);
     m->acceptVisitor(&cdv);
     if (pd.isCanceled())
@@ -3659,6 +4137,81 @@ bool EditDDLHandler::handleURI(URI& uri)
     return true;
 }
 
+class SaveDDLHandler: public URIHandler,
+    private MetadataItemURIHandlerHelper, private GUIURIHandlerHelper
+{
+public:
+    SaveDDLHandler() {}
+    bool handleURI(URI& uri);
+private:
+    static const SaveDDLHandler handlerInstance;
+};
+
+const SaveDDLHandler SaveDDLHandler::handlerInstance;
+
+bool SaveDDLHandler::handleURI(URI& uri)
+{
+    if (uri.action != "save_ddl")
+        return false;
+
+    MetadataItem* m = extractMetadataItemFromURI<MetadataItem>(uri);
+    wxWindow* w = getParentWindow(uri);
+    if (!m || !w)
+        return true;
+
+    wxFileDialog fd(w, _("Save DDL As"), wxEmptyString,
+        m->getName_() + ".sql",
+        _("SQL script files (*.sql)|*.sql|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (wxID_OK != fd.ShowModal())
+        return true;
+
+    DatabasePtr db = m->getDatabase();
+    MetadataLoaderTransaction tr(db->getMetadataLoader());
+
+    ProgressDialog pd(w, _("Extracting DDL Definitions"), 2);
+    pd.doShow();
+    wxStopWatch swTotal;
+    long prefetchMillis = 0;
+    if (m == db.get())
+    {
+        try
+        {
+            db->prefetchMetadata(&pd);
+        }
+        catch (CancelProgressException&)
+        {
+            return true;
+        }
+        prefetchMillis = swTotal.Time();
+    }
+    CreateDDLVisitor cdv(&pd);
+    if (!cdv.writeDDL(*m, fd.GetPath()))
+        return true;
+    long totalMillis = swTotal.Time();
+    pd.doHide();
+
+    wxString details;
+    if (m == db.get())
+    {
+        details << _("Loading metadata") << ": "
+            << millisToTimeString(prefetchMillis) << "\n";
+        const DDLPhaseTimings& timings = cdv.getPhaseTimings();
+        for (DDLPhaseTimings::const_iterator it = timings.begin();
+            it != timings.end(); ++it)
+        {
+            details << (*it).first << ": " << millisToTimeString((*it).second)
+                << "\n";
+        }
+    }
+    details << _("Total") << ": " << millisToTimeString(totalMillis);
+    showInformationDialog(w,
+        wxString::Format(_("The DDL has been saved to \"%s\"."),
+            fd.GetPath().c_str()),
+        details, AdvancedMessageDialogButtonsOk());
+    return true;
+}
+
 class EditProcedureHandler: public URIHandler,
     private MetadataItemURIHandlerHelper, private GUIURIHandlerHelper
 {
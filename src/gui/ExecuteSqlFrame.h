@@ -31,16 +31,19 @@
 #include <wx/notebook.h>
 #include <wx/splitter.h>
 #include <wx/stc/stc.h>
+#include <wx/stopwatch.h>
 
 #include <ibpp.h>
 
 #include "core/Observer.h"
 #include "core/StringUtils.h"
 #include "controls/DataGridTable.h"
+#include "engine/StatementProfiler.h"
 #include "gui/BaseFrame.h"
 #include "gui/EditBlobDialog.h"
 #include "gui/FindDialog.h"
 #include "sql/SqlStatement.h"
+#include "sql/StatementIndex.h"
 #include "statementHistory.h"
 #include "map"
 
@@ -98,6 +101,8 @@ private:
         bool prepareOnly = false, int selectionOffset = 0);
     bool execute(wxString sql, const wxString& terminator,
         bool prepareOnly = false);
+    bool executeScriptFile(const wxString& fileName);
+    void startTransaction();
 
     std::vector<SqlStatement> executedStatementsM;
     std::map<std::string, wxString> parameterSaveList;
@@ -105,7 +110,14 @@ private:
     wxFileName filenameM;
     wxDateTime filenameModificationTimeM;
 
-    void compareCounts(IBPP::DatabaseCounts& one, IBPP::DatabaseCounts& two);
+    void compareCounts(IBPP::DatabaseCounts& one, IBPP::DatabaseCounts& two,
+        std::vector<ProfileTableCounts>& tables, bool logCounts);
+    wxString getRelationName(int relationId);
+    std::map<int, wxString> relationNamesM;
+
+    // profile of the last executed select, updated while rows are fetched
+    unsigned profileIdM;
+    wxStopWatch profileStopWatchM;
 
     void showProperties(wxString objectName);
 
@@ -143,9 +155,12 @@ private:
     void OnTextSelected(wxStyledTextEvent& event);
     void autoComplete(bool force);
     void autoCompleteColumns(int pos, int len = 0);
+    bool columnsPrefetchedM;
+    StatementIndex statementIndexM;     // statement boundaries of the editor
     void OnSqlEditUpdateUI(wxStyledTextEvent& event);
     void OnSqlEditCharAdded(wxStyledTextEvent& event);      // autocomplete stuff
     void OnSqlEditChanged(wxStyledTextEvent& event);        // update title
+    void OnSqlEditModified(wxStyledTextEvent& event);       // update statement index
     void OnSqlEditStartDrag(wxStyledTextEvent& event);      // enable click&remove selection
     wxString keywordsM;     // text used for autocomplete
     void setKeywords();
@@ -226,9 +241,11 @@ private:
     void OnMenuExecute(wxCommandEvent& event);
     void OnMenuShowPlan(wxCommandEvent& event);
     void OnMenuShowStatistics(wxCommandEvent& event);
+    void OnMenuShowProfiles(wxCommandEvent& event);
     void OnMenuUpdateShowStatistics(wxUpdateUIEvent& event);
     void OnMenuExecuteSelection(wxCommandEvent& event);
     void OnMenuExecuteFromCursor(wxCommandEvent& event);
+    void OnMenuExecuteFile(wxCommandEvent& event);
     void OnMenuCommit(wxCommandEvent& event);
     void OnMenuRollback(wxCommandEvent& event);
     void OnMenuUpdateWhenInTransaction(wxUpdateUIEvent& event);
@@ -255,6 +272,8 @@ private:
     void OnMenuGridCopyAsUpdateInsert(wxCommandEvent& event);
     void OnMenuGridSaveAsHtml(wxCommandEvent& event);
     void OnMenuGridSaveAsCsv(wxCommandEvent& event);
+    void OnMenuGridExportAll(wxCommandEvent& event);
+    void OnMenuUpdateGridExportAll(wxUpdateUIEvent& event);
     void OnMenuGridFetchAll(wxCommandEvent& event);
     void OnMenuGridCancelFetchAll(wxCommandEvent& event);
     void OnMenuUpdateGridHasSelection(wxUpdateUIEvent& event);
@@ -41,10 +41,16 @@ class ProcessableObject;
 
 HtmlTemplateProcessor::HtmlTemplateProcessor(ProcessableObject* object,
     wxWindow* window)
-    : TemplateProcessor(object, window)
+    : TemplateProcessor(object, window), deferSectionsM(false)
 {
 }
 
+/*static*/ wxString HtmlTemplateProcessor::getDeferredSectionMarker(
+    size_t index)
+{
+    return wxString::Format("<!--deferred:%d-->", int(index));
+}
+
 void HtmlTemplateProcessor::processCommand(const wxString& cmdName,
     const TemplateCmdParams& cmdParams, ProcessableObject* object,
     wxString& processedText)
@@ -56,6 +62,22 @@ void HtmlTemplateProcessor::processCommand(const wxString& cmdName,
     if (!metadataItem)
         return;
 
+    // {%deferred:<text>%}
+    // Marks an expensive part of a property page. The page is shown
+    // without it first, and <text> is expanded and inserted afterwards.
+    // Only applies to the page object; elsewhere <text> is expanded in place.
+    if (cmdName == "deferred" && !cmdParams.empty())
+    {
+        if (deferSectionsM && object == getObject())
+        {
+            processedText += getDeferredSectionMarker(
+                deferredSectionsM.size());
+            deferredSectionsM.push_back(cmdParams.all());
+        }
+        else
+            internalProcessTemplateText(processedText, cmdParams.all(), object);
+    }
+
     if (cmdName == "header" && !cmdParams.empty())  // include another file
     {
         std::vector<wxString> pages;
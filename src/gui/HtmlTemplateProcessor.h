@@ -25,11 +25,16 @@
 #ifndef FR_HTMLTEMPLATEPROCESSOR_H
 #define FR_HTMLTEMPLATEPROCESSOR_H
 
+#include <vector>
+
 #include "core/TemplateProcessor.h"
 
 
 class HtmlTemplateProcessor: public TemplateProcessor
 {
+private:
+    bool deferSectionsM;
+    std::vector<wxString> deferredSectionsM;
 protected:
     virtual void processCommand(const wxString& cmdName,
         const TemplateCmdParams& cmdParams, ProcessableObject* object,
@@ -38,6 +43,17 @@ public:
     HtmlTemplateProcessor(ProcessableObject* object, wxWindow* window);
     virtual wxString escapeChars(const wxString& input,
         bool processNewlines = true);
+
+    // When enabled, {%deferred:<text>%} commands for the page object
+    // expand to a marker and <text> is collected for later processing
+    // with internalProcessTemplateText().
+    // When disabled (the default) <text> is expanded in place.
+    void setDeferSections(bool defer) { deferSectionsM = defer; }
+    const std::vector<wxString>& getDeferredSections() const
+    {
+        return deferredSectionsM;
+    }
+    static wxString getDeferredSectionMarker(size_t index);
 };
 
 #endif // FR_HTMLTEMPLATEPROCESSOR_H
@@ -38,10 +38,13 @@
 #include <wx/wupdlock.h>
 
 #include <list>
+#include <memory>
+#include <vector>
 
 #include "config/Config.h"
 #include "core/ArtProvider.h"
 #include "core/FRError.h"
+#include "core/StringUtils.h"
 #include "core/URIProcessor.h"
 #include "engine/MetadataLoader.h"
 #include "gui/GUIURIHandlerHelper.h"
@@ -64,11 +67,24 @@ private:
 
     MetadataItem* objectM;
     bool htmlReloadRequestedM;
+    bool idleHandlerConnectedM;
     PrintableHtmlWindow* html_window;
 
+    // the processed page contains markers for its deferred sections, which
+    // are processed one per idle event by the same template processor
+    std::unique_ptr<HtmlTemplateProcessor> templateProcessorM;
+    wxString pageTemplateM;
+    std::vector<wxString> sectionsHtmlM;
+    size_t nextSectionM;
+    wxString pageSourceM;
+
     // load page in idle handler, only request a reload in update()
     void requestLoadPage(bool showLoadingPage);
+    void requestIdle();
     void loadPage();
+    void loadNextSection();
+    void showPage();
+    void resetPage();
 
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
@@ -97,7 +113,8 @@ static MIPPanels mipPanels;
 MetadataItemPropertiesPanel::MetadataItemPropertiesPanel(
         MetadataItemPropertiesFrame* parent, MetadataItem* object)
     : wxPanel(parent, wxID_ANY), pageTypeM(ptSummary), objectM(object),
-        htmlReloadRequestedM(false)
+        htmlReloadRequestedM(false), idleHandlerConnectedM(false),
+        nextSectionM(0)
 {
     wxASSERT(object);
     mipPanels.push_back(this);
@@ -160,11 +177,21 @@ void MetadataItemPropertiesPanel::requestLoadPage(bool showLoadingPage)
 
             html_window->LoadFile(config().getHtmlTemplatesPath()
                 + "ALLloading.html");
+            pageSourceM.clear();
         }
 
+        requestIdle();
+        htmlReloadRequestedM = true;
+    }
+}
+
+void MetadataItemPropertiesPanel::requestIdle()
+{
+    if (!idleHandlerConnectedM)
+    {
         Connect(wxID_ANY, wxEVT_IDLE,
             wxIdleEventHandler(MetadataItemPropertiesPanel::OnIdle));
-        htmlReloadRequestedM = true;
+        idleHandlerConnectedM = true;
     }
 }
 
@@ -208,16 +235,27 @@ void MetadataItemPropertiesPanel::loadPage()
     pd.doShow();
 
     wxString htmlpage;
-    HtmlTemplateProcessor tp(objectM, this);
-    tp.processTemplateFile(htmlpage, fileName, 0, &pd);
+    std::unique_ptr<HtmlTemplateProcessor> tp(
+        new HtmlTemplateProcessor(objectM, this));
+    tp->setDeferSections(true);
+    tp->processTemplateFile(htmlpage, fileName, 0, &pd);
+    tp->setProgressIndicator(0);
+    tp->setDeferSections(false);
+    templateProcessorM = std::move(tp);
+
+    // when the same page is reloaded keep showing the previous contents
+    // of its deferred sections until they have been processed again
+    size_t sections = templateProcessorM->getDeferredSections().size();
+    if (htmlpage != pageTemplateM || sectionsHtmlM.size() != sections)
+    {
+        sectionsHtmlM.assign(sections, "<font color=\"gray\">"
+            + escapeHtmlChars(_("Loading...")) + "</font>");
+    }
+    pageTemplateM = htmlpage;
+    nextSectionM = 0;
 
     pd.SetTitle(_("Rendering page..."));
-
-    wxWindowUpdateLocker freeze(html_window);
-    int x = 0, y = 0;
-    html_window->GetViewStart(&x, &y);         // save scroll position
-    html_window->setPageSource(htmlpage);
-    html_window->Scroll(x, y);                 // restore scroll position
+    showPage();
 
     // set title
     if (MetadataItemPropertiesFrame* pf = getParentFrame())
@@ -227,6 +265,64 @@ void MetadataItemPropertiesPanel::loadPage()
     }
 }
 
+//! process the next deferred section of the page and show the result
+void MetadataItemPropertiesPanel::loadNextSection()
+{
+    if (!objectM || !templateProcessorM
+        || nextSectionM >= templateProcessorM->getDeferredSections().size())
+    {
+        return;
+    }
+
+    wxBusyCursor bc;
+
+    wxString html;
+    {
+        // metadata loaded here notifies the observers when the lock is
+        // released, that must not cause a reload of the whole page
+        htmlReloadRequestedM = true;
+        DatabasePtr db = objectM->getDatabase();
+        MetadataLoaderTransaction tr((db) ? db->getMetadataLoader() : 0);
+        SubjectLocker lock(objectM);
+
+        templateProcessorM->internalProcessTemplateText(html,
+            templateProcessorM->getDeferredSections()[nextSectionM], 0);
+    }
+    htmlReloadRequestedM = false;
+    sectionsHtmlM[nextSectionM] = html;
+    ++nextSectionM;
+    showPage();
+}
+
+//! insert the deferred sections and display the page if it has changed
+void MetadataItemPropertiesPanel::showPage()
+{
+    wxString htmlpage(pageTemplateM);
+    for (size_t i = 0; i < sectionsHtmlM.size(); ++i)
+    {
+        htmlpage.Replace(HtmlTemplateProcessor::getDeferredSectionMarker(i),
+            sectionsHtmlM[i], false);
+    }
+    // updates often don't change anything, and re-rendering a large page
+    // is expensive and makes it flicker
+    if (htmlpage == pageSourceM)
+        return;
+    pageSourceM = htmlpage;
+
+    wxWindowUpdateLocker freeze(html_window);
+    int x = 0, y = 0;
+    html_window->GetViewStart(&x, &y);         // save scroll position
+    html_window->setPageSource(htmlpage);
+    html_window->Scroll(x, y);                 // restore scroll position
+}
+
+//! drop the template processor, it must not outlive the observed object
+void MetadataItemPropertiesPanel::resetPage()
+{
+    templateProcessorM.reset();
+    nextSectionM = 0;
+}
+
 //! closes window if observed object gets removed (disconnecting, dropping, etc)
 void MetadataItemPropertiesPanel::subjectRemoved(Subject* subject)
 {
@@ -234,6 +330,7 @@ void MetadataItemPropertiesPanel::subjectRemoved(Subject* subject)
     if (subject == objectM)
     {
         objectM = 0;
+        resetPage();
         if (MetadataItemPropertiesFrame* f = getParentFrame())
             f->removePanel(this);
     }
@@ -279,6 +376,7 @@ void MetadataItemPropertiesPanel::update()
     if (db && !db->isConnected())
     {
         objectM = 0;
+        resetPage();
         if (MetadataItemPropertiesFrame* f = getParentFrame())
             f->Close();
 
@@ -369,12 +467,29 @@ void MetadataItemPropertiesPanel::OnHtmlCellHover(wxHtmlCellEvent& event)
     }
 }
 
-void MetadataItemPropertiesPanel::OnIdle(wxIdleEvent& WXUNUSED(event))
+void MetadataItemPropertiesPanel::OnIdle(wxIdleEvent& event)
 {
     Disconnect(wxID_ANY, wxEVT_IDLE);
-    wxBusyCursor bc;
-    loadPage();
-    htmlReloadRequestedM = false;
+    idleHandlerConnectedM = false;
+    if (!objectM)
+        return;
+
+    if (htmlReloadRequestedM)
+    {
+        wxBusyCursor bc;
+        loadPage();
+        htmlReloadRequestedM = false;
+    }
+    else
+        loadNextSection();
+
+    // show the page first, then fill in one deferred section per idle event
+    if (templateProcessorM
+        && nextSectionM < templateProcessorM->getDeferredSections().size())
+    {
+        requestIdle();
+        event.RequestMore();
+    }
 }
 
 void MetadataItemPropertiesPanel::OnRefresh(wxCommandEvent& WXUNUSED(event))
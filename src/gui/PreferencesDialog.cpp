@@ -778,6 +778,10 @@ public:
     virtual void handleTemplateCmd(TemplateProcessor *tp,
         const wxString& cmdName, const TemplateCmdParams& cmdParams,
         ProcessableObject* object, wxString& processedText);
+    virtual bool handlesCommand(const wxString& cmdName) const
+    {
+        return cmdName == "edit_conf" || cmdName == "edit_info";
+    }
 };
 
 const PreferencesDialogTemplateCmdHandler PreferencesDialogTemplateCmdHandler::handlerInstance;
@@ -173,8 +173,14 @@ void StatementHistoryDialog::OnListBoxSelect(wxCommandEvent& WXUNUSED(event))
         textctrl_statement->AddText(historyM->get(p) + "\n");
         if (i == 0)
         {
-            dateTimeTextM->SetLabel(historyM->getDateTime(p).Format(
+            wxString info(historyM->getDateTime(p).Format(
                 "%Y-%m-%d %H:%M:%S"));
+            long duration = historyM->getDuration(p);
+            if (duration >= 0)
+                info += wxString::Format(_(", %ld ms"), duration);
+            if (historyM->getResult(p) == StatementHistory::erFailed)
+                info += _(", failed");
+            dateTimeTextM->SetLabel(info);
         }
     }
 
@@ -208,10 +214,14 @@ void StatementHistoryDialog::OnButtonSearchClick(wxCommandEvent&
     listbox_search->Clear();
     wxString searchString = textctrl_search->GetValue().Upper();
     setSearching(true);
-    StatementHistory::Position total = historyM->size();
+    // only the statements containing all the words of the search string
+    // need to be read and checked, newest first
+    std::vector<StatementHistory::Position> items;
+    historyM->findCandidates(searchString, items);
+    size_t total = items.size();
     gauge_progress->SetRange((int)total);
     wxString last = wxEmptyString;
-    for (StatementHistory::Position p = total - 1; (int)p >= 0; --p)
+    for (size_t i = 0; i < total; ++i)
     {
         wxYield();
         if (!isSearchingM)
@@ -220,7 +230,8 @@ void StatementHistoryDialog::OnButtonSearchClick(wxCommandEvent&
             return;
         }
 
-        gauge_progress->SetValue((int)(total - p - 1));
+        gauge_progress->SetValue((int)i);
+        StatementHistory::Position p = items[total - i - 1];
         wxString s(historyM->get(p));
         if (s == last)  // ignore duplicates
             continue;
@@ -0,0 +1,376 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "engine/StatementProfiler.h"
+#include "gui/AdvancedMessageDialog.h"
+#include "gui/StatementProfilerDialog.h"
+#include "gui/StyleGuide.h"
+
+static wxString formatMillis(long millis)
+{
+    if (millis < 0)
+        return "-";
+    return wxString::Format("%ld ms", millis);
+}
+
+// ProfileListCtrl class
+// Virtual list showing the profiles of StatementProfiler in the order
+// given by the sort column, items are formatted only when displayed.
+class ProfileListCtrl: public wxListCtrl
+{
+private:
+    enum { colId, colTime, colPrepare, colExecute, colFirstRows, colFetch,
+        colRows, colRowsPerSecond, colBytes, colIndexedReads,
+        colNaturalReads, colSql, colCount };
+    std::vector<size_t> orderM;
+    int sortColumnM;
+    bool sortAscendingM;
+
+    static double getSortKey(const StatementProfile& p, int column);
+protected:
+    virtual wxString OnGetItemText(long item, long column) const;
+public:
+    ProfileListCtrl(wxWindow* parent, wxWindowID id);
+
+    void refresh();
+    void sortBy(int column);
+    const StatementProfile* getProfile(long item) const;
+};
+
+ProfileListCtrl::ProfileListCtrl(wxWindow* parent, wxWindowID id)
+    : wxListCtrl(parent, id, wxDefaultPosition, wxDefaultSize,
+        wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL),
+      sortColumnM(colId), sortAscendingM(true)
+{
+    InsertColumn(colId, _("#"), wxLIST_FORMAT_RIGHT, 40);
+    InsertColumn(colTime, _("Executed"), wxLIST_FORMAT_LEFT, 70);
+    InsertColumn(colPrepare, _("Prepare"), wxLIST_FORMAT_RIGHT, 70);
+    InsertColumn(colExecute, _("Execute"), wxLIST_FORMAT_RIGHT, 70);
+    InsertColumn(colFirstRows, _("First rows"), wxLIST_FORMAT_RIGHT, 70);
+    InsertColumn(colFetch, _("Fetch all"), wxLIST_FORMAT_RIGHT, 70);
+    InsertColumn(colRows, _("Rows"), wxLIST_FORMAT_RIGHT, 60);
+    InsertColumn(colRowsPerSecond, _("Rows/s"), wxLIST_FORMAT_RIGHT, 70);
+    InsertColumn(colBytes, _("Bytes"), wxLIST_FORMAT_RIGHT, 80);
+    InsertColumn(colIndexedReads, _("Indexed"), wxLIST_FORMAT_RIGHT, 60);
+    InsertColumn(colNaturalReads, _("Natural"), wxLIST_FORMAT_RIGHT, 60);
+    InsertColumn(colSql, _("Statement"), wxLIST_FORMAT_LEFT, 300);
+    refresh();
+}
+
+/*static*/
+double ProfileListCtrl::getSortKey(const StatementProfile& p, int column)
+{
+    switch (column)
+    {
+        case colPrepare: return p.prepareTime;
+        case colExecute: return p.executeTime;
+        case colFirstRows: return p.firstRowsTime;
+        case colFetch: return p.fetchTime;
+        case colRows: return p.rows;
+        case colRowsPerSecond: return p.getRowsPerSecond();
+        case colBytes: return p.bytes.ToDouble();
+        case colIndexedReads: return p.hasCounts ? p.getIndexedReads() : -1;
+        case colNaturalReads: return p.hasCounts ? p.getNaturalReads() : -1;
+        default: return p.id;
+    }
+}
+
+wxString ProfileListCtrl::OnGetItemText(long item, long column) const
+{
+    const StatementProfile* p = getProfile(item);
+    if (!p)
+        return wxEmptyString;
+    switch (column)
+    {
+        case colId:
+            return wxString::Format("%u", p->id);
+        case colTime:
+            return p->executedAt.FormatISOTime();
+        case colPrepare:
+            return formatMillis(p->prepareTime);
+        case colExecute:
+            return formatMillis(p->executeTime);
+        case colFirstRows:
+            return formatMillis(p->firstRowsTime);
+        case colFetch:
+            return formatMillis(p->fetchTime);
+        case colRows:
+            return (p->rows < 0) ? wxString("-")
+                : wxString::Format("%ld", p->rows);
+        case colRowsPerSecond:
+            return (p->rows <= 0) ? wxString("-")
+                : wxString::Format("%.0f", p->getRowsPerSecond());
+        case colBytes:
+            return (p->rows <= 0) ? wxString("-") : p->bytes.ToString();
+        case colIndexedReads:
+            return p->hasCounts
+                ? wxString::Format("%d", p->getIndexedReads()) : "-";
+        case colNaturalReads:
+            return p->hasCounts
+                ? wxString::Format("%d", p->getNaturalReads()) : "-";
+        case colSql:
+        {
+            wxString sql(p->sql.Left(200));
+            sql.Replace("\r", " ");
+            sql.Replace("\n", " ");
+            sql.Replace("\t", " ");
+            return (p->succeeded ? wxString() : _("[failed] ")) + sql;
+        }
+    }
+    return wxEmptyString;
+}
+
+void ProfileListCtrl::refresh()
+{
+    StatementProfiler& profiler = StatementProfiler::get();
+    orderM.resize(profiler.size());
+    for (size_t i = 0; i < orderM.size(); ++i)
+        orderM[i] = i;
+    if (sortColumnM == colSql || sortColumnM == colTime)
+    {
+        // statements are listed in execution order already
+        if (sortColumnM == colSql)
+        {
+            std::stable_sort(orderM.begin(), orderM.end(),
+                [&profiler](size_t a, size_t b) {
+                    return profiler.getProfile(a).sql.CmpNoCase(
+                        profiler.getProfile(b).sql) < 0;
+                });
+        }
+    }
+    else if (sortColumnM != colId)
+    {
+        int column = sortColumnM;
+        std::stable_sort(orderM.begin(), orderM.end(),
+            [&profiler, column](size_t a, size_t b) {
+                return getSortKey(profiler.getProfile(a), column)
+                    < getSortKey(profiler.getProfile(b), column);
+            });
+    }
+    if (!sortAscendingM)
+        std::reverse(orderM.begin(), orderM.end());
+
+    SetItemCount(orderM.size());
+    Refresh();
+}
+
+void ProfileListCtrl::sortBy(int column)
+{
+    if (column == sortColumnM)
+        sortAscendingM = !sortAscendingM;
+    else
+    {
+        sortColumnM = column;
+        // timings and counters are most interesting largest first
+        sortAscendingM = (column == colId || column == colTime
+            || column == colSql);
+    }
+    refresh();
+}
+
+const StatementProfile* ProfileListCtrl::getProfile(long item) const
+{
+    if (item < 0 || size_t(item) >= orderM.size())
+        return 0;
+    return &StatementProfiler::get().getProfile(orderM[item]);
+}
+
+// StatementProfilerDialog class
+StatementProfilerDialog::StatementProfilerDialog(wxWindow* parent)
+    : BaseDialog(parent, wxID_ANY, _("Statement Profiles"))
+{
+    wxBoxSizer* innerSizer = new wxBoxSizer(wxVERTICAL);
+
+    listctrl_profiles = new ProfileListCtrl(getControlsPanel(),
+        ID_listctrl_profiles);
+    innerSizer->Add(listctrl_profiles, 2, wxEXPAND, 0);
+
+    textctrl_details = new wxTextCtrl(getControlsPanel(), wxID_ANY,
+        wxEmptyString, wxDefaultPosition, wxDefaultSize,
+        wxTE_MULTILINE | wxTE_READONLY | wxTE_DONTWRAP);
+    innerSizer->Add(textctrl_details, 1, wxTOP | wxEXPAND,
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+
+    wxBoxSizer* exportSizer = new wxBoxSizer(wxHORIZONTAL);
+    button_export_csv = new wxButton(getControlsPanel(), ID_button_export_csv,
+        _("Export &CSV..."));
+    exportSizer->Add(button_export_csv, 0, wxRIGHT,
+        styleguide().getBetweenButtonsMargin(wxHORIZONTAL));
+    button_export_json = new wxButton(getControlsPanel(),
+        ID_button_export_json, _("Export &JSON..."));
+    exportSizer->Add(button_export_json, 0, wxRIGHT,
+        styleguide().getUnrelatedControlMargin(wxHORIZONTAL));
+    button_clear = new wxButton(getControlsPanel(), ID_button_clear,
+        _("C&lear"));
+    exportSizer->Add(button_clear, 0, 0, 0);
+    innerSizer->Add(exportSizer, 0, wxTOP,
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+
+    button_close = new wxButton(getControlsPanel(), wxID_CANCEL, _("&Close"));
+    wxSizer* sizerButtons = styleguide().createButtonSizer(0, button_close);
+
+    // use method in base class to set everything up
+    layoutSizers(innerSizer, sizerButtons, true);
+
+    updateDetails();
+    SetSize(760, 460);
+    Centre();
+}
+
+const wxString StatementProfilerDialog::getName() const
+{
+    return "StatementProfilerDialog";
+}
+
+void StatementProfilerDialog::updateDetails()
+{
+    bool hasProfiles = StatementProfiler::get().size() > 0;
+    button_export_csv->Enable(hasProfiles);
+    button_export_json->Enable(hasProfiles);
+    button_clear->Enable(hasProfiles);
+
+    long item = listctrl_profiles->GetNextItem(-1, wxLIST_NEXT_ALL,
+        wxLIST_STATE_SELECTED);
+    const StatementProfile* p = listctrl_profiles->getProfile(item);
+    if (!p)
+    {
+        textctrl_details->ChangeValue(wxEmptyString);
+        return;
+    }
+
+    wxString details(p->sql);
+    details += "\n\n";
+    details += wxString::Format(_("Executed at %s on %s, %s."),
+        p->executedAt.Format("%Y-%m-%d %H:%M:%S"), p->databaseName,
+        p->succeeded ? _("succeeded") : _("failed"));
+    details += "\n";
+    if (p->prepareTime >= 0)
+        details += _("Prepare: ") + formatMillis(p->prepareTime) + "\n";
+    if (p->executeTime >= 0)
+        details += _("Execute: ") + formatMillis(p->executeTime) + "\n";
+    if (p->firstRowsTime >= 0)
+    {
+        details += _("First rows: ")
+            + formatMillis(p->firstRowsTime) + "\n";
+    }
+    if (p->fetchTime >= 0)
+        details += _("Fetch all: ") + formatMillis(p->fetchTime) + "\n";
+    if (p->rows >= 0)
+    {
+        details += wxString::Format(
+            _("%ld row(s), about %s bytes (%d bytes per row)."),
+            p->rows, p->bytes.ToString(), p->rowSize) + "\n";
+    }
+    if (p->hasCounts)
+    {
+        details += wxString::Format(
+            _("%d fetches, %d marks, %d reads, %d writes."),
+            p->fetches, p->marks, p->reads, p->writes) + "\n";
+        for (std::vector<ProfileTableCounts>::const_iterator it
+            = p->tables.begin(); it != p->tables.end(); ++it)
+        {
+            const ProfileTableCounts& t = *it;
+            details += wxString::Format(_("%s: %d indexed reads, "
+                "%d natural reads, %d inserts, %d updates, %d deletes."),
+                t.relationName, t.indexedReads, t.naturalReads, t.inserts,
+                t.updates, t.deletes) + "\n";
+        }
+    }
+    textctrl_details->ChangeValue(details);
+}
+
+void StatementProfilerDialog::exportProfiles(bool asJson)
+{
+    wxFileDialog fd(this, _("Export Statement Profiles"), wxEmptyString,
+        asJson ? "profiles.json" : "profiles.csv",
+        asJson ? _("JSON files (*.json)|*.json|All files (*.*)|*.*")
+            : _("CSV files (*.csv)|*.csv|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (fd.ShowModal() != wxID_OK)
+        return;
+
+    StatementProfiler& profiler = StatementProfiler::get();
+    bool ok = asJson ? profiler.exportJson(fd.GetPath())
+        : profiler.exportCsv(fd.GetPath());
+    if (!ok)
+    {
+        showWarningDialog(this, _("Export failed"),
+            wxString::Format(_("The file \"%s\" could not be written."),
+                fd.GetPath()),
+            AdvancedMessageDialogButtonsOk());
+    }
+}
+
+BEGIN_EVENT_TABLE(StatementProfilerDialog, BaseDialog)
+    EVT_LIST_ITEM_SELECTED(StatementProfilerDialog::ID_listctrl_profiles,
+        StatementProfilerDialog::OnListItemSelected)
+    EVT_LIST_COL_CLICK(StatementProfilerDialog::ID_listctrl_profiles,
+        StatementProfilerDialog::OnListColumnClick)
+    EVT_BUTTON(StatementProfilerDialog::ID_button_export_csv,
+        StatementProfilerDialog::OnButtonExportCsvClick)
+    EVT_BUTTON(StatementProfilerDialog::ID_button_export_json,
+        StatementProfilerDialog::OnButtonExportJsonClick)
+    EVT_BUTTON(StatementProfilerDialog::ID_button_clear,
+        StatementProfilerDialog::OnButtonClearClick)
+END_EVENT_TABLE()
+
+void StatementProfilerDialog::OnListItemSelected(wxListEvent& WXUNUSED(event))
+{
+    updateDetails();
+}
+
+void StatementProfilerDialog::OnListColumnClick(wxListEvent& event)
+{
+    listctrl_profiles->SetItemState(-1, 0, wxLIST_STATE_SELECTED);
+    listctrl_profiles->sortBy(event.GetColumn());
+    updateDetails();
+}
+
+void StatementProfilerDialog::OnButtonExportCsvClick(
+    wxCommandEvent& WXUNUSED(event))
+{
+    exportProfiles(false);
+}
+
+void StatementProfilerDialog::OnButtonExportJsonClick(
+    wxCommandEvent& WXUNUSED(event))
+{
+    exportProfiles(true);
+}
+
+void StatementProfilerDialog::OnButtonClearClick(
+    wxCommandEvent& WXUNUSED(event))
+{
+    StatementProfiler::get().clear();
+    listctrl_profiles->refresh();
+    updateDetails();
+}
@@ -0,0 +1,69 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef FR_STATEMENTPROFILERDIALOG_H
+#define FR_STATEMENTPROFILERDIALOG_H
+
+#include <wx/listctrl.h>
+
+#include <vector>
+
+#include "BaseDialog.h"
+
+class ProfileListCtrl;
+
+class StatementProfilerDialog : public BaseDialog
+{
+private:
+    ProfileListCtrl* listctrl_profiles;
+    wxTextCtrl* textctrl_details;
+    wxButton* button_export_csv;
+    wxButton* button_export_json;
+    wxButton* button_clear;
+    wxButton* button_close;
+
+    void updateDetails();
+    void exportProfiles(bool asJson);
+
+    enum    // event handling
+    {
+        ID_listctrl_profiles = 101,
+        ID_button_export_csv,
+        ID_button_export_json,
+        ID_button_clear
+    };
+    void OnListItemSelected(wxListEvent& event);
+    void OnListColumnClick(wxListEvent& event);
+    void OnButtonExportCsvClick(wxCommandEvent& event);
+    void OnButtonExportJsonClick(wxCommandEvent& event);
+    void OnButtonClearClick(wxCommandEvent& event);
+protected:
+    virtual const wxString getName() const;
+public:
+    StatementProfilerDialog(wxWindow* parent);
+
+    DECLARE_EVENT_TABLE()
+};
+
+#endif // FR_STATEMENTPROFILERDIALOG_H
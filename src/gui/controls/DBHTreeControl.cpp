@@ -34,9 +34,12 @@
 #include <wx/dataobj.h>
 #include <wx/dnd.h>
 #include <wx/imaglist.h>
+#include <wx/wupdlock.h>
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "config/Config.h"
@@ -72,6 +75,7 @@ class DBHTreeConfigCache: public ConfigCache, public Subject
 {
 private:
     bool allowDragM;
+    bool deferChildNodesM;
     bool hideDisconnectedDatabasesM;
     bool showColumnParamCountM;
     bool showColumnsM;
@@ -94,6 +98,7 @@ public:
     static DBHTreeConfigCache& get();
 
     bool allowDnD() { return allowDragM; }
+    bool getDeferChildNodes() { return deferChildNodesM; }
     bool getHideDisconnectedDatabases()
         { return hideDisconnectedDatabasesM; }
     bool getShowColumnParamCount() { return showColumnParamCountM; }
@@ -121,6 +126,8 @@ void DBHTreeConfigCache::loadFromConfig()
 
     changes += setValue(allowDragM,
         cfg.get("allowDragAndDrop", false));
+    changes += setValue(deferChildNodesM,
+        cfg.get("DeferTreeChildNodes", false));
     changes += setValue(hideDisconnectedDatabasesM,
         cfg.get("HideDisconnectedDatabases", false));
     changes += setValue(showColumnParamCountM,
@@ -1020,6 +1027,11 @@ class DBHTreeItemData: public wxTreeItemData, public Observer
 private:
     DBHTreeControl* treeM;
     MetadataItem* observedItemM;
+    // child nodes of collapsed nodes are created when the node is expanded
+    // if the "DeferTreeChildNodes" setting is active
+    bool childNodesDeferredM;
+    bool createChildNodesM;
+    size_t updateChildNodes(const std::vector<MetadataItem*>& children);
 protected:
     virtual void update();
 public:
@@ -1028,13 +1040,30 @@ public:
     wxTreeItemId findSubNode(MetadataItem* item);
     MetadataItem* getObservedMetadata();
     void setObservedMetadata(MetadataItem* item);
+    bool hasDeferredChildNodes() const;
+    void createDeferredChildNodes();
 };
 
 DBHTreeItemData::DBHTreeItemData(DBHTreeControl* tree)
-    : Observer(), treeM(tree), observedItemM(0)
+    : Observer(), treeM(tree), observedItemM(0), childNodesDeferredM(false),
+        createChildNodesM(false)
 {
 }
 
+bool DBHTreeItemData::hasDeferredChildNodes() const
+{
+    return childNodesDeferredM;
+}
+
+void DBHTreeItemData::createDeferredChildNodes()
+{
+    if (!childNodesDeferredM)
+        return;
+    createChildNodesM = true;
+    update();
+    createChildNodesM = false;
+}
+
 //! returns tree subnode that points to given metadata object
 wxTreeItemId DBHTreeItemData::findSubNode(MetadataItem* item)
 {
@@ -1139,6 +1168,44 @@ struct MetadataItemSorter
 
 //! parent nodes are responsible for "insert" / "delete"
 //! node is responsible for "update"
+// returns flags for the elements of positions that form the longest
+// increasing subsequence, the tree nodes at these positions are already
+// in the right order and can stay where they are
+static std::vector<bool> getNodesInOrder(const std::vector<size_t>& positions)
+{
+    const size_t none = size_t(-1);
+    // tails[k] is the index of the smallest last element of all increasing
+    // subsequences of length k + 1 found so far
+    std::vector<size_t> tails;
+    std::vector<size_t> predecessors(positions.size(), none);
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        size_t lo = 0, hi = tails.size();
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (positions[tails[mid]] < positions[i])
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo > 0)
+            predecessors[i] = tails[lo - 1];
+        if (lo == tails.size())
+            tails.push_back(i);
+        else
+            tails[lo] = i;
+    }
+
+    std::vector<bool> inOrder(positions.size(), false);
+    if (!tails.empty())
+    {
+        for (size_t i = tails.back(); i != none; i = predecessors[i])
+            inOrder[i] = true;
+    }
+    return inOrder;
+}
+
 void DBHTreeItemData::update()
 {
     wxTreeItemId id = GetId();
@@ -1161,11 +1228,12 @@ void DBHTreeItemData::update()
         treeM->SetItemText(id, tivObject.getNodeText());
     if (treeM->GetItemImage(id) != tivObject.getNodeImage())
         treeM->SetItemImage(id, tivObject.getNodeImage());
-    // track number of visible child nodes for SetItemHasChildren() calls
-    unsigned numVisibleChildren = 0;
+
+    bool canCollapseNode = id != treeM->GetRootItem()
+        || (treeM->GetWindowStyle() & wxTR_HIDE_ROOT) == 0;
+
     // check subitems
     std::vector<MetadataItem*> children;
-    std::vector<MetadataItem*>::iterator itChild;
     if (tivObject.getShowChildren())
     {
         if (object->getChildren(children))
@@ -1176,72 +1244,24 @@ void DBHTreeItemData::update()
                 MetadataItemSorter sorter;
                 std::sort(children.begin(), children.end(), sorter);
             }
-
-            wxTreeItemId prevId;
-            // create or update child nodes
-            for (itChild = children.begin(); itChild != children.end(); ++itChild)
-            {
-                DBHTreeItemVisitor tivChild(treeM);
-                (*itChild)->loadPendingData();
-                (*itChild)->acceptVisitor(&tivChild);
-                if (!tivChild.getNodeVisible())
-                    continue;
-                ++numVisibleChildren;
-
-                wxTreeItemId childId = findSubNode(*itChild);
-                // order of child nodes may have changed
-                // since nodes can't be moved they have to be recreated
-                if (childId.IsOk())
-                {
-                    wxTreeItemId prevChildId = treeM->GetPrevSibling(childId);
-                    if (prevChildId != prevId)
-                    {
-                        treeM->Delete(childId);
-                        childId.Unset();
-                    }
-                }
-
-                if (!childId.IsOk())
-                {
-                    DBHTreeItemData* newItem = new DBHTreeItemData(treeM);
-                    if (prevId.IsOk())
-                    {
-                        childId = treeM->InsertItem(id, prevId,
-                            tivChild.getNodeText(), tivChild.getNodeImage(),
-                            -1, newItem);
-                    }
-                    else // first
-                    {
-                        childId = treeM->PrependItem(id, tivChild.getNodeText(),
-                            tivChild.getNodeImage(), -1, newItem);
-                    }
-                    // setObservedMetadata() calls attachObserver(), which
-                    // calls update() on the newly created child node
-                    // this will correctly populate the tree
-                    newItem->setObservedMetadata(*itChild);
-                    // tree node data objects may optionally observe the settings
-                    // cache object, for example to create / delete column and
-                    // parameter nodes if the "ShowColumnsInTree" setting changes
-                    if (tivChild.isConfigSensitive())
-                        DBHTreeConfigCache::get().attachObserver(newItem, false);
-                }
-                else
-                {
-                    if (treeM->GetItemText(childId) != tivChild.getNodeText())
-                        treeM->SetItemText(childId, tivChild.getNodeText());
-                    if (treeM->GetItemImage(childId) != tivChild.getNodeImage())
-                        treeM->SetItemImage(childId, tivChild.getNodeImage());
-                }
-                prevId = childId;
-            }
         }
     }
 
-    bool canCollapseNode = id != treeM->GetRootItem()
-        || (treeM->GetWindowStyle() & wxTR_HIDE_ROOT) == 0;
+    // don't create child nodes for a collapsed node that has none yet,
+    // the expander is shown and the nodes are created when it is expanded
+    childNodesDeferredM = false;
+    if (!children.empty() && !createChildNodesM && canCollapseNode
+        && DBHTreeConfigCache::get().getDeferChildNodes()
+        && !treeM->IsExpanded(id) && treeM->GetChildrenCount(id, false) == 0)
+    {
+        childNodesDeferredM = true;
+        treeM->SetItemHasChildren(id, true);
+        treeM->SetItemBold(id, true);
+        return;
+    }
 
     // remove all children at once
-    if (numVisibleChildren == 0)
+    if (updateChildNodes(children) == 0)
     {
         if (treeM->ItemHasChildren(id))
         {
@@ -1257,52 +1277,147 @@ void DBHTreeItemData::update()
             //treeM->SetItemTextColour(id, wxSYS_COLOUR_GRAYTEXT);
         else
             treeM->SetItemTextColour(id, wxSystemSettings::GetColour(wxSYS_COLOUR_CAPTIONTEXT));
-        
+        return;
+    }
+    treeM->SetItemHasChildren(id, true);
 
+    treeM->SetItemBold(id, tivObject.getNodeTextBold()
+        || treeM->ItemHasChildren(id));
+    //treeM->SetBackgroundColour(wxYELLOW);
+}
 
+// reconciles the child nodes with the visible items in children, so that
+// the work done is proportional to the number of changed nodes:
+// - nodes for items that are no longer there (or no longer visible) are
+//   deleted
+// - nodes that are in the wrong order need to be recreated as nodes can't
+//   be moved, the longest sequence of nodes already in the right order is
+//   kept, only the others are deleted
+// - missing nodes are inserted at their position
+// returns the number of visible children, if there are none the existing
+// nodes are left for the caller to remove
+size_t DBHTreeItemData::updateChildNodes(
+    const std::vector<MetadataItem*>& children)
+{
+    wxTreeItemId id = GetId();
 
+    struct ChildNode
+    {
+        MetadataItem* item;
+        wxString text;
+        int image;
+        bool configSensitive;
+        wxTreeItemId nodeId;
+    };
+    std::vector<ChildNode> visibleChildren;
+    visibleChildren.reserve(children.size());
+    typedef std::unordered_map<MetadataItem*, size_t> PositionMap;
+    PositionMap positions;
+    for (std::vector<MetadataItem*>::const_iterator itChild = children.begin();
+        itChild != children.end(); ++itChild)
+    {
+        DBHTreeItemVisitor tivChild(treeM);
+        (*itChild)->loadPendingData();
+        (*itChild)->acceptVisitor(&tivChild);
+        if (!tivChild.getNodeVisible())
+            continue;
 
-        return;
+        ChildNode cn;
+        cn.item = *itChild;
+        cn.text = tivChild.getNodeText();
+        cn.image = tivChild.getNodeImage();
+        cn.configSensitive = tivChild.isConfigSensitive();
+        positions[cn.item] = visibleChildren.size();
+        visibleChildren.push_back(cn);
     }
-    treeM->SetItemHasChildren(id, true);
+    if (visibleChildren.empty())
+        return 0;
 
-    // remove delete items - one by one
-    bool itemsDeleted = false;
+    // one pass over the existing child nodes
+    std::vector<wxTreeItemId> obsoleteIds;
+    std::vector<wxTreeItemId> existingIds;
+    std::vector<size_t> existingPositions;
     wxTreeItemIdValue cookie;
-    wxTreeItemId item = treeM->GetFirstChild(id, cookie);
-    while (item.IsOk())
+    for (wxTreeItemId ci = treeM->GetFirstChild(id, cookie); ci.IsOk();
+        ci = treeM->GetNextChild(id, cookie))
     {
-        itChild = find(children.begin(), children.end(),
-            treeM->getMetadataItem(item));
-        // we may need to hide disconnected databases
-        if (DBHTreeConfigCache::get().getHideDisconnectedDatabases()
-            && itChild != children.end())
+        PositionMap::iterator pos = positions.find(treeM->getMetadataItem(ci));
+        if (pos == positions.end()
+            || visibleChildren[pos->second].nodeId.IsOk())
         {
-            Database* db = dynamic_cast<Database*>(*itChild);
-            if (db && !db->isConnected())
-                itChild = children.end();
+            obsoleteIds.push_back(ci);
         }
-        // delete tree node and all children if metadata item not found
-        if (itChild == children.end())
+        else
         {
-            itemsDeleted = true;
-            treeM->DeleteChildren(item);
-            treeM->Delete(item);
-            item = treeM->GetFirstChild(id, cookie);
-            continue;
+            visibleChildren[pos->second].nodeId = ci;
+            existingIds.push_back(ci);
+            existingPositions.push_back(pos->second);
         }
-        item = treeM->GetNextChild(id, cookie);
     }
-    // force-collapse node if all children deleted
-    if (itemsDeleted && 0 == treeM->GetChildrenCount(id, false)
-        && canCollapseNode)
+    std::vector<bool> inOrder(getNodesInOrder(existingPositions));
+    for (size_t i = 0; i < existingIds.size(); ++i)
     {
-        treeM->Collapse(id);
+        if (!inOrder[i])
+        {
+            visibleChildren[existingPositions[i]].nodeId.Unset();
+            obsoleteIds.push_back(existingIds[i]);
+        }
     }
 
-    treeM->SetItemBold(id, tivObject.getNodeTextBold()
-        || treeM->ItemHasChildren(id));
-    //treeM->SetBackgroundColour(wxYELLOW);
+    // avoid repainting for every single node when many nodes change
+    size_t newNodes = std::count_if(visibleChildren.begin(),
+        visibleChildren.end(),
+        [](const ChildNode& cn) { return !cn.nodeId.IsOk(); });
+    std::unique_ptr<wxWindowUpdateLocker> freeze;
+    if (obsoleteIds.size() + newNodes > 100)
+        freeze.reset(new wxWindowUpdateLocker(treeM));
+
+    for (std::vector<wxTreeItemId>::iterator it = obsoleteIds.begin();
+        it != obsoleteIds.end(); ++it)
+    {
+        treeM->DeleteChildren(*it);
+        treeM->Delete(*it);
+    }
+
+    // create or update child nodes
+    wxTreeItemId prevId;
+    for (std::vector<ChildNode>::iterator it = visibleChildren.begin();
+        it != visibleChildren.end(); ++it)
+    {
+        wxTreeItemId childId = it->nodeId;
+        if (!childId.IsOk())
+        {
+            DBHTreeItemData* newItem = new DBHTreeItemData(treeM);
+            if (prevId.IsOk())
+            {
+                childId = treeM->InsertItem(id, prevId, it->text, it->image,
+                    -1, newItem);
+            }
+            else // first
+            {
+                childId = treeM->PrependItem(id, it->text, it->image, -1,
+                    newItem);
+            }
+            // setObservedMetadata() calls attachObserver(), which
+            // calls update() on the newly created child node
+            // this will correctly populate the tree
+            newItem->setObservedMetadata(it->item);
+            // tree node data objects may optionally observe the settings
+            // cache object, for example to create / delete column and
+            // parameter nodes if the "ShowColumnsInTree" setting changes
+            if (it->configSensitive)
+                DBHTreeConfigCache::get().attachObserver(newItem, false);
+        }
+        else
+        {
+            if (treeM->GetItemText(childId) != it->text)
+                treeM->SetItemText(childId, it->text);
+            if (treeM->GetItemImage(childId) != it->image)
+                treeM->SetItemImage(childId, it->image);
+        }
+        prevId = childId;
+    }
+    return visibleChildren.size();
 }
 
 BEGIN_EVENT_TABLE(DBHTreeControl, wxTreeCtrl)
@@ -1386,6 +1501,11 @@ void DBHTreeControl::OnTreeItemExpanding(wxTreeEvent& event)
     MetadataItem* mi = getMetadataItem(event.GetItem());
     if (mi)
         mi->ensureChildrenLoaded();
+    if (event.GetItem().IsOk())
+    {
+        if (DBHTreeItemData* tid = (DBHTreeItemData*)GetItemData(event.GetItem()))
+            tid->createDeferredChildNodes();
+    }
     event.Skip();
 }
 
@@ -1456,6 +1576,26 @@ bool DBHTreeControl::findMetadataItem(MetadataItem *item, wxTreeItemId parent)
         EnsureVisible(parent);
         return true;
     }
+    // create deferred child nodes only if item or one of its parents is
+    // a child of this node, otherwise the whole tree would be created
+    DBHTreeItemData* tid = (DBHTreeItemData*)GetItemData(parent);
+    if (tid && tid->hasDeferredChildNodes())
+    {
+        std::vector<MetadataItem*> children;
+        if (MetadataItem* mi = tid->getObservedMetadata())
+            mi->getChildren(children);
+        for (MetadataItem* m = item; m; m = m->getParent())
+        {
+            if (std::find(children.begin(), children.end(), m)
+                != children.end())
+            {
+                tid->createDeferredChildNodes();
+                break;
+            }
+        }
+        if (tid->hasDeferredChildNodes())
+            return false;
+    }
     for (wxTreeItemId node = GetFirstChild(parent, cookie); node.IsOk();
         node = GetNextChild(parent, cookie))
     {
@@ -199,6 +199,7 @@ void DataGrid::showPopupMenu(wxPoint cursorPos)
     m.Append(Cmds::DataGrid_Copy_as_inList, _("Copy as IN list"));
     m.Append(Cmds::DataGrid_Save_as_html, _("Save as HTML file..."));
     m.Append(Cmds::DataGrid_Save_as_csv, _("Save as CSV file..."));
+    m.Append(Cmds::DataGrid_Export_all, _("Export all records..."));
     m.AppendSeparator();
 
     m.Append(Cmds::DataGrid_EditBlob, _("Edit BLOB..."));
@@ -828,6 +829,13 @@ void DataGrid::cancelFetchAll()
         table->setFetchAllRecords(false);
 }
 
+void DataGrid::stopFetching()
+{
+    DataGridTable* table = getDataGridTable();
+    if (table)
+        table->stopFetching();
+}
+
 std::vector<bool> DataGrid::getColumnsWithSelectedCells()
 {
     // fully selected rows cause all columns to have selected cells
@@ -974,6 +982,7 @@ BEGIN_EVENT_TABLE(DataGrid, wxGrid)
     //  EVT_GRID_EDITOR_HIDDEN( DataGrid::OnEditorHidden )
     EVT_KEY_DOWN(DataGrid::OnKeyDown)
     EVT_TIMER(DataGrid::TIMER_ID, DataGrid::OnTimer)
+    EVT_COMMAND(wxID_ANY, wxEVT_FRDG_ROWS_FETCHED, DataGrid::OnRowsFetched)
 #ifdef __WXGTK__
     EVT_MOUSEWHEEL(DataGrid::OnMouseWheel)
     EVT_SCROLLWIN_THUMBRELEASE(DataGrid::OnThumbRelease)
@@ -1129,15 +1138,27 @@ void DataGrid::OnIdle(wxIdleEvent& event)
     }
     // fetch more rows until row cache is filled or timeslice is spent, and
     // request another wxEVT_IDLE event if row cache has not been filled
+    // (not necessary while the fetch thread is running, it will post
+    // wxEVT_FRDG_ROWS_FETCHED events)
     if (table->needsMoreRowsFetched())
     {
         table->fetch();
-        if (table->needsMoreRowsFetched())
+        if (!table->isFetching() && table->needsMoreRowsFetched())
             event.RequestMore();
         AdjustScrollbars();
     }
 }
 
+void DataGrid::OnRowsFetched(wxCommandEvent& event)
+{
+    DataGridTable* table = getDataGridTable();
+    if (table)
+    {
+        table->notifyRowsFetched(event.GetInt());
+        AdjustScrollbars();
+    }
+}
+
 void DataGrid::OnKeyDown(wxKeyEvent& event)
 {
     if (event.GetKeyCode() == WXK_SPACE)
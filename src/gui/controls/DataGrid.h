@@ -62,6 +62,7 @@ private:
     void OnGridLabelRightClick(wxGridEvent& event);
     void OnGridRangeSelected(wxGridRangeSelectEvent& event);
     void OnIdle(wxIdleEvent& event);
+    void OnRowsFetched(wxCommandEvent& event);
     void OnKeyDown(wxKeyEvent& event);
     void OnMouseWheel(wxMouseEvent& event);
     void OnThumbRelease(wxScrollWinEvent& event);
@@ -83,6 +84,9 @@ public:
 
     void cancelFetchAll();
     void fetchAll();
+    // waits for the background fetch of rows to end, needs to be called
+    // before the statement or its transaction is closed
+    void stopFetching();
     void setupStyles();
 
     std::vector<bool> getColumnsWithSelectedCells();
@@ -30,6 +30,9 @@
     #include "wx/wx.h"
 #endif
 
+#include <algorithm>
+#include <cstring>
+
 #include "gui/controls/DataGridRowBuffer.h"
 
 // Time + timestamp internal struct
@@ -70,6 +73,38 @@ DataGridRowBuffer::DataGridRowBuffer(const DataGridRowBuffer* other)
     isDeletableM = other->isDeletableM;
 }
 
+void DataGridRowBuffer::reset()
+{
+    DataGridRowBufferFieldAttr initValue;
+    initValue.isStringLoaded = false;
+    initValue.isNull = true;
+    std::fill(fieldAttrM.begin(), fieldAttrM.end(), initValue);
+    std::fill(dataM.begin(), dataM.end(), 0);
+    stringsM.clear();
+    blobsM.clear();
+
+    isModifiedM = 0;
+    isDeletedM = 0;
+    invalidateIsDeletable();
+}
+
+bool DataGridRowBuffer::getData(unsigned offset, void* dest, unsigned size)
+{
+    if (offset + size > dataM.size())
+        return false;
+    memcpy(dest, &dataM[offset], size);
+    return true;
+}
+
+void DataGridRowBuffer::setData(unsigned offset, const void* src,
+    unsigned size)
+{
+    if (offset + size > dataM.size())
+        dataM.resize(offset + size, 0);
+    memcpy(&dataM[offset], src, size);
+    invalidateIsDeletable();
+}
+
 wxString DataGridRowBuffer::getString(unsigned index)
 {
     if (index >= stringsM.size())
@@ -62,6 +62,12 @@ public:
     DataGridRowBuffer(const DataGridRowBuffer* other);
     virtual ~DataGridRowBuffer() {}
 
+    // resets all fields to NULL, keeps the allocated memory for reuse
+    void reset();
+    // raw access to the fixed size data, used by DataGridRowStore
+    bool getData(unsigned offset, void* dest, unsigned size);
+    void setData(unsigned offset, const void* src, unsigned size);
+
     wxString getString(unsigned index);
     IBPP::Blob *getBlob(unsigned index);
     bool getValue(unsigned offset, double& value);
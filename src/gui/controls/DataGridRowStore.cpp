@@ -0,0 +1,293 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <limits>
+
+#include "core/FRError.h"
+#include "gui/controls/DataGridRowBuffer.h"
+#include "gui/controls/DataGridRowStore.h"
+
+DataGridRowStore::DataGridRowStore()
+    : stringCountM(0), blobCountM(0), rowCountM(0)
+{
+}
+
+DataGridRowStore::~DataGridRowStore()
+{
+    clear();
+}
+
+void DataGridRowStore::clear()
+{
+    wxCriticalSectionLocker locker(critSectM);
+    for (std::vector<Chunk*>::iterator it = chunksM.begin();
+        it != chunksM.end(); ++it)
+    {
+        delete (*it);
+    }
+    chunksM.clear();
+    columnsM.clear();
+    stringCountM = 0;
+    blobCountM = 0;
+    rowCountM = 0;
+}
+
+void DataGridRowStore::addColumn(unsigned offset, unsigned size)
+{
+    wxASSERT(rowCountM == 0);
+    ColumnLayout layout;
+    layout.offset = offset;
+    layout.size = size;
+    columnsM.push_back(layout);
+}
+
+void DataGridRowStore::setSlotCounts(unsigned stringCount, unsigned blobCount)
+{
+    wxASSERT(rowCountM == 0);
+    stringCountM = stringCount;
+    blobCountM = blobCount;
+}
+
+unsigned DataGridRowStore::getRowCount() const
+{
+    wxCriticalSectionLocker locker(critSectM);
+    return rowCountM;
+}
+
+bool DataGridRowStore::getBit(const std::vector<uint64_t>& bits, unsigned pos)
+{
+    return (bits[pos / 64] & (uint64_t(1) << (pos % 64))) != 0;
+}
+
+void DataGridRowStore::setBit(std::vector<uint64_t>& bits, unsigned pos,
+    bool value)
+{
+    if (value)
+        bits[pos / 64] |= uint64_t(1) << (pos % 64);
+    else
+        bits[pos / 64] &= ~(uint64_t(1) << (pos % 64));
+}
+
+DataGridRowStore::Chunk* DataGridRowStore::addChunk()
+{
+    // the previous chunk is complete now, so release its spare memory
+    if (!chunksM.empty())
+        compactChunk(chunksM.back());
+
+    const unsigned bitmapWords = (chunkRowsM + 63) / 64;
+    Chunk* chunk = new Chunk();
+    chunk->fixedM.resize(columnsM.size());
+    // all fields are NULL until they are set
+    chunk->nullsM.resize(columnsM.size(),
+        std::vector<uint64_t>(bitmapWords, ~uint64_t(0)));
+    for (unsigned i = 0; i < columnsM.size(); ++i)
+    {
+        if (columnsM[i].size)
+            chunk->fixedM[i].resize(chunkRowsM * columnsM[i].size, 0);
+    }
+    StringRef empty = { 0, 0 };
+    chunk->arenasM.resize(stringCountM);
+    chunk->stringRefsM.resize(stringCountM,
+        std::vector<StringRef>(chunkRowsM, empty));
+    chunk->stringsLoadedM.resize(stringCountM,
+        std::vector<uint64_t>(bitmapWords, 0));
+    chunk->blobsM.resize(blobCountM, std::vector<IBPP::Blob>(chunkRowsM));
+    chunksM.push_back(chunk);
+    return chunk;
+}
+
+DataGridRowStore::Chunk* DataGridRowStore::getChunk(unsigned row) const
+{
+    wxASSERT(row < rowCountM);
+    return chunksM[row / chunkRowsM];
+}
+
+void DataGridRowStore::compactChunk(Chunk* chunk)
+{
+    for (std::vector<std::vector<char> >::iterator it =
+        chunk->arenasM.begin(); it != chunk->arenasM.end(); ++it)
+    {
+        (*it).shrink_to_fit();
+    }
+}
+
+bool DataGridRowStore::storeString(Chunk* chunk, unsigned index, unsigned pos,
+    const char* data, size_t length)
+{
+    std::vector<char>& arena = chunk->arenasM[index];
+    if (arena.size() + length > std::numeric_limits<uint32_t>::max())
+        return false;
+    StringRef& ref = chunk->stringRefsM[index][pos];
+    ref.offset = uint32_t(arena.size());
+    ref.length = uint32_t(length);
+    arena.insert(arena.end(), data, data + length);
+    setBit(chunk->stringsLoadedM[index], pos, true);
+    return true;
+}
+
+void DataGridRowStore::appendNullRow()
+{
+    wxCriticalSectionLocker locker(critSectM);
+    if (rowCountM % chunkRowsM == 0)
+        addChunk();
+    ++rowCountM;
+}
+
+void DataGridRowStore::appendRow(DataGridRowBuffer* buffer)
+{
+    wxASSERT(buffer);
+    wxCriticalSectionLocker locker(critSectM);
+    Chunk* chunk = (rowCountM % chunkRowsM == 0) ? addChunk()
+        : chunksM.back();
+    unsigned pos = rowCountM % chunkRowsM;
+
+    for (unsigned col = 0; col < columnsM.size(); ++col)
+    {
+        bool isNull = buffer->isFieldNull(col);
+        setBit(chunk->nullsM[col], pos, isNull);
+        unsigned size = columnsM[col].size;
+        if (!isNull && size)
+        {
+            buffer->getData(columnsM[col].offset,
+                &chunk->fixedM[col][pos * size], size);
+        }
+    }
+    for (unsigned index = 0; index < stringCountM; ++index)
+    {
+        if (!buffer->isStringLoaded(index))
+            continue;
+        const wxScopedCharBuffer utf8(buffer->getString(index).utf8_str());
+        if (!storeString(chunk, index, pos, utf8.data(), utf8.length()))
+            throw FRError(_("Result set data exceeds the available storage."));
+    }
+    for (unsigned index = 0; index < blobCountM; ++index)
+    {
+        IBPP::Blob* blob = buffer->getBlob(index);
+        if (blob)
+            chunk->blobsM[index][pos] = *blob;
+    }
+    ++rowCountM;
+}
+
+void DataGridRowStore::loadRow(unsigned row, DataGridRowBuffer* buffer) const
+{
+    wxASSERT(buffer);
+    wxCriticalSectionLocker locker(critSectM);
+    Chunk* chunk = getChunk(row);
+    unsigned pos = row % chunkRowsM;
+
+    buffer->reset();
+    for (unsigned col = 0; col < columnsM.size(); ++col)
+    {
+        bool isNull = getBit(chunk->nullsM[col], pos);
+        buffer->setFieldNull(col, isNull);
+        unsigned size = columnsM[col].size;
+        if (!isNull && size)
+        {
+            buffer->setData(columnsM[col].offset,
+                &chunk->fixedM[col][pos * size], size);
+        }
+    }
+    for (unsigned index = 0; index < stringCountM; ++index)
+    {
+        if (!getBit(chunk->stringsLoadedM[index], pos))
+            continue;
+        const StringRef& ref = chunk->stringRefsM[index][pos];
+        const char* data = chunk->arenasM[index].data() + ref.offset;
+        buffer->setString(index, wxString::FromUTF8(data, ref.length));
+    }
+    for (unsigned index = 0; index < blobCountM; ++index)
+    {
+        const IBPP::Blob& blob = chunk->blobsM[index][pos];
+        if (blob != 0)
+            buffer->setBlob(index, blob);
+    }
+}
+
+void DataGridRowStore::storeLoadedStrings(unsigned row,
+    DataGridRowBuffer* buffer)
+{
+    wxASSERT(buffer);
+    wxCriticalSectionLocker locker(critSectM);
+    Chunk* chunk = getChunk(row);
+    unsigned pos = row % chunkRowsM;
+    for (unsigned index = 0; index < stringCountM; ++index)
+    {
+        if (getBit(chunk->stringsLoadedM[index], pos)
+            || !buffer->isStringLoaded(index))
+        {
+            continue;
+        }
+        // this is only a cache, so silently skip it when the arena is full
+        const wxScopedCharBuffer utf8(buffer->getString(index).utf8_str());
+        storeString(chunk, index, pos, utf8.data(), utf8.length());
+    }
+}
+
+bool DataGridRowStore::isFieldNull(unsigned row, unsigned col) const
+{
+    wxCriticalSectionLocker locker(critSectM);
+    if (row >= rowCountM || col >= columnsM.size())
+        return false;
+    return getBit(getChunk(row)->nullsM[col], row % chunkRowsM);
+}
+
+IBPP::Blob* DataGridRowStore::getBlob(unsigned row, unsigned index)
+{
+    wxCriticalSectionLocker locker(critSectM);
+    if (row >= rowCountM || index >= blobCountM)
+        return 0;
+    IBPP::Blob* blob = &(getChunk(row)->blobsM[index][row % chunkRowsM]);
+    if (*blob == 0)
+        return 0;
+    return blob;
+}
+
+size_t DataGridRowStore::getMemoryUsage() const
+{
+    wxCriticalSectionLocker locker(critSectM);
+    size_t total = 0;
+    for (std::vector<Chunk*>::const_iterator it = chunksM.begin();
+        it != chunksM.end(); ++it)
+    {
+        const Chunk* chunk = *it;
+        for (size_t i = 0; i < chunk->fixedM.size(); ++i)
+            total += chunk->fixedM[i].capacity();
+        total += chunk->nullsM.size() * (chunkRowsM / 8);
+        for (size_t i = 0; i < chunk->arenasM.size(); ++i)
+            total += chunk->arenasM[i].capacity();
+        total += chunk->stringRefsM.size() * chunkRowsM * sizeof(StringRef);
+        total += chunk->stringsLoadedM.size() * (chunkRowsM / 8);
+        total += chunk->blobsM.size() * chunkRowsM * sizeof(IBPP::Blob);
+    }
+    return total;
+}
@@ -0,0 +1,105 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DATAGRIDROWSTORE_H
+#define FR_DATAGRIDROWSTORE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <wx/thread.h>
+
+#include <ibpp.h>
+
+class DataGridRowBuffer;
+
+// DataGridRowStore class
+// Columnar storage for the rows fetched from a result set.  Rows are kept in
+// chunks of a fixed number of rows, every chunk holding one fixed-width array
+// per column, one packed UTF-8 string arena per string slot and null bitmaps,
+// so that no memory is allocated per row.  The layout (buffer offsets, string
+// and blob indices) is the one used by ResultsetColumnDef and
+// DataGridRowBuffer, rows are moved in and out via DataGridRowBuffer objects.
+class DataGridRowStore
+{
+private:
+    enum { chunkRowsM = 1024 };
+
+    struct ColumnLayout
+    {
+        unsigned offset;
+        unsigned size;
+    };
+    struct StringRef
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+    struct Chunk
+    {
+        std::vector<std::vector<uint8_t> > fixedM;
+        std::vector<std::vector<uint64_t> > nullsM;
+        std::vector<std::vector<char> > arenasM;
+        std::vector<std::vector<StringRef> > stringRefsM;
+        std::vector<std::vector<uint64_t> > stringsLoadedM;
+        std::vector<std::vector<IBPP::Blob> > blobsM;
+    };
+
+    std::vector<ColumnLayout> columnsM;
+    unsigned stringCountM;
+    unsigned blobCountM;
+    std::vector<Chunk*> chunksM;
+    unsigned rowCountM;
+    mutable wxCriticalSection critSectM;
+
+    Chunk* addChunk();
+    Chunk* getChunk(unsigned row) const;
+    void compactChunk(Chunk* chunk);
+    static bool getBit(const std::vector<uint64_t>& bits, unsigned pos);
+    static void setBit(std::vector<uint64_t>& bits, unsigned pos, bool value);
+    static bool storeString(Chunk* chunk, unsigned index, unsigned pos,
+        const char* data, size_t length);
+public:
+    DataGridRowStore();
+    ~DataGridRowStore();
+
+    void clear();
+    // column layout, has to be set up before the first row is added
+    void addColumn(unsigned offset, unsigned size);
+    void setSlotCounts(unsigned stringCount, unsigned blobCount);
+
+    unsigned getRowCount() const;
+    void appendRow(DataGridRowBuffer* buffer);
+    void appendNullRow();
+    void loadRow(unsigned row, DataGridRowBuffer* buffer) const;
+    // keeps strings that have been loaded on demand (BLOB data) in the
+    // store, so they don't need to be fetched again for the same row
+    void storeLoadedStrings(unsigned row, DataGridRowBuffer* buffer);
+
+    bool isFieldNull(unsigned row, unsigned col) const;
+    IBPP::Blob* getBlob(unsigned row, unsigned index);
+    size_t getMemoryUsage() const;
+};
+
+#endif
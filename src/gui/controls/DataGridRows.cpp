@@ -1614,14 +1614,15 @@ unsigned BlobColumnDef::getBufferSize()
 }
 
 void BlobColumnDef::setValue(DataGridRowBuffer* buffer, unsigned col,
-    const IBPP::Statement& statement, wxMBConv*, Database* db)
+    const IBPP::Statement& statement, wxMBConv*, Database*)
 {
     wxASSERT(buffer);
+    // converterM has been set by the constructor already, it must not be
+    // changed here as this may run in the fetch thread
     IBPP::Blob b = IBPP::BlobFactory(statement->DatabasePtr(),
         statement->TransactionPtr());
     statement->Get(col, b);
     buffer->setBlob(indexM, b);
-    converterM = db->getCharsetConverter(); // store for later when we fetch the data
 }
 
 // StringColumnDef class
@@ -1740,7 +1741,8 @@ void BooleanColumnDef::setValue(DataGridRowBuffer* buffer, unsigned col,
 
 // DataGridRows class
 DataGridRows::DataGridRows(Database* db)
-    : bufferSizeM(0), databaseM(db), readOnlyM(false)
+    : bufferSizeM(0), databaseM(db), readOnlyM(false), fetchBufferM(0),
+        readBufferM(0), readBufferRowM(0)
 {
 }
 
@@ -1754,55 +1756,94 @@ ResultsetColumnDef* DataGridRows::getColumnDef(unsigned col)
     return columnDefsM[col];
 }
 
+// returns the buffer of an inserted or modified row, or 0 for rows that are
+// only kept in the store
+DataGridRowBuffer* DataGridRows::findRowBuffer(unsigned row)
+{
+    if (rowBuffersM.empty())
+        return 0;
+    std::map<unsigned, DataGridRowBuffer*>::iterator it =
+        rowBuffersM.find(row);
+    if (it == rowBuffersM.end())
+        return 0;
+    return (*it).second;
+}
+
+// returns a buffer for reading the row data, for rows from the store it is
+// only valid until the next call
+DataGridRowBuffer* DataGridRows::getRowBuffer(unsigned row)
+{
+    if (DataGridRowBuffer* buffer = findRowBuffer(row))
+        return buffer;
+    if (!readBufferM)
+        readBufferM = new DataGridRowBuffer(columnDefsM.size());
+    else if (readBufferRowM == row)
+        return readBufferM;
+    storeM.loadRow(row, readBufferM);
+    readBufferRowM = row;
+    return readBufferM;
+}
+
+// returns a buffer owned by the row, so changes to it are kept
+DataGridRowBuffer* DataGridRows::getRowBufferForUpdate(unsigned row)
+{
+    if (DataGridRowBuffer* buffer = findRowBuffer(row))
+        return buffer;
+    DataGridRowBuffer* buffer = new DataGridRowBuffer(columnDefsM.size());
+    storeM.loadRow(row, buffer);
+    rowBuffersM[row] = buffer;
+    return buffer;
+}
+
 void DataGridRows::addRow(DataGridRowBuffer* buffer)
 {
-    if (buffersM.size() == buffersM.capacity())
-        buffersM.reserve(buffersM.capacity() + 1024);
-    buffersM.push_back(buffer);
+    // reserve the row in the store, the buffer holds the actual data
+    rowBuffersM[storeM.getRowCount()] = buffer;
+    storeM.appendNullRow();
 }
 
 void DataGridRows::addRow(const IBPP::Statement& statement)
 {
-    DataGridRowBuffer* buffer = new DataGridRowBuffer(columnDefsM.size());
-    // if anything fails, make sure we release the memory
-    try
+    if (!fetchBufferM)
+        fetchBufferM = new DataGridRowBuffer(columnDefsM.size());
+    else
+        fetchBufferM->reset();
+
+    // starts with last column -> with highest buffer offset and
+    // string array index to allocate all needed memory at once
+    unsigned col = columnDefsM.size();
+    do
     {
-        // starts with last column -> with highest buffer offset and
-        // string array index to allocate all needed memory at once
-        unsigned col = columnDefsM.size();
-        do
+        // IBPP column counts are 1-based, not 0-based...
+        unsigned colIBPP = col--;
+        bool isNull = statement->IsNull(colIBPP);
+        fetchBufferM->setFieldNull(col, isNull);
+        if (!isNull)
         {
-            // IBPP column counts are 1-based, not 0-based...
-            unsigned colIBPP = col--;
-            bool isNull = statement->IsNull(colIBPP);
-            buffer->setFieldNull(col, isNull);
-            if (!isNull)
-            {
-                columnDefsM[col]->setValue(buffer, colIBPP, statement,
-                    databaseM->getCharsetConverter(), databaseM);
-            }
+            columnDefsM[col]->setValue(fetchBufferM, colIBPP, statement,
+                databaseM->getCharsetConverter(), databaseM);
         }
-        while (col > 0);
     }
-    catch(...)
-    {
-        delete buffer;
-        throw;
-    }
-    addRow(buffer);
+    while (col > 0);
+    storeM.appendRow(fetchBufferM);
 }
 
-    void freeBuffer(DataGridRowBuffer* buffer) { delete buffer; }
-
     void freeColumnDef(ResultsetColumnDef* columnDef) { delete columnDef; }
 
 void DataGridRows::clear()
 {
-    if (buffersM.size())
+    for (std::map<unsigned, DataGridRowBuffer*>::iterator it =
+        rowBuffersM.begin(); it != rowBuffersM.end(); ++it)
     {
-        for_each(buffersM.begin(), buffersM.end(), freeBuffer);
-        buffersM.clear();
+        delete (*it).second;
     }
+    rowBuffersM.clear();
+    storeM.clear();
+    delete fetchBufferM;
+    fetchBufferM = 0;
+    delete readBufferM;
+    readBufferM = 0;
+    readBufferRowM = 0;
     if (columnDefsM.size())
     {
         for_each(columnDefsM.begin(), columnDefsM.end(), freeColumnDef);
@@ -1816,12 +1857,13 @@ void DataGridRows::clear()
 
 bool DataGridRows::canRemoveRow(size_t row)
 {
-    if (row >= buffersM.size())
+    if (row >= storeM.getRowCount())
         return false;
     // check that it is safe to call statementM->Columns()
     if (statementM->Type() == IBPP::stUnknown)
         return false;
-    if (!buffersM[row]->isDeletableIsSet())
+    DataGridRowBuffer* buffer = getRowBuffer(row);
+    if (!buffer->isDeletableIsSet())
     {
         // find table with valid constraint
         bool tableok = false;
@@ -1844,7 +1886,7 @@ bool DataGridRows::canRemoveRow(size_t row)
                         continue;
                     wxString tn(std2wxIdentifier(statementM->ColumnTable(c2),
                         databaseM->getCharsetConverter()));
-                    if (tn == (*it).first && buffersM[row]->isFieldNA(c2-1))
+                    if (tn == (*it).first && buffer->isFieldNA(c2-1))
                     {
                         tableok = false;
                         break;
@@ -1852,9 +1894,9 @@ bool DataGridRows::canRemoveRow(size_t row)
                 }
             }
         }
-        buffersM[row]->setIsDeletable(tableok);
+        buffer->setIsDeletable(tableok);
     }
-    return buffersM[row]->isDeletable();
+    return buffer->isDeletable();
 }
 
 bool DataGridRows::removeRows(size_t from, size_t count, wxString& stm)
@@ -1886,6 +1928,8 @@ bool DataGridRows::removeRows(size_t from, size_t count, wxString& stm)
         deleteFromM = statementTablesM.find(tab);
     }
 
+    if (from + count > storeM.getRowCount())     // should never happen
+        return false;
     for (size_t pos = 0; pos < count; ++pos)
     {
         if (pos > 0)
@@ -1893,31 +1937,24 @@ bool DataGridRows::removeRows(size_t from, size_t count, wxString& stm)
         wxString s = "DELETE FROM "
             + Identifier((*deleteFromM).first).getQuoted() + " WHERE ";
         IBPP::Statement st = addWhere((*deleteFromM).second, s,
-            (*deleteFromM).first, buffersM[from+pos]);
+            (*deleteFromM).first, getRowBuffer(from+pos));
         st->Execute();
         stm += s + ";";
     }
 
-    std::vector<DataGridRowBuffer*>::iterator i2, it = buffersM.begin();
-    from += count - 1;
-    while (from--)
-    {
-        if (++it == buffersM.end())     // should never happen
-            return false;
-    }
-    while (count--)
-    {
-        i2 = it;
-        if (it != buffersM.begin ())//Prevents it from going before the first one
-          it--;
-        (*i2)->setIsDeleted(true);
-    }
+    for (size_t pos = 0; pos < count; ++pos)
+        getRowBufferForUpdate(from+pos)->setIsDeleted(true);
     return true;
 }
 
 unsigned DataGridRows::getRowCount()
 {
-    return buffersM.size();
+    return storeM.getRowCount();
+}
+
+size_t DataGridRows::getMemoryUsage()
+{
+    return storeM.getMemoryUsage() + rowBuffersM.size() * bufferSizeM;
 }
 
 unsigned DataGridRows::getRowFieldCount()
@@ -2161,9 +2198,11 @@ bool DataGridRows::initialize(const IBPP::Statement& statement)
             }
         }
         wxASSERT(columnDef);
+        storeM.addColumn(bufferSizeM, columnDef->getBufferSize());
         bufferSizeM += columnDef->getBufferSize();
         columnDefsM.push_back(columnDef);
     }
+    storeM.setSlotCounts(stringIndex, blobIndex);
     return true;
 }
 
@@ -2191,16 +2230,19 @@ bool DataGridRows::isColumnReadonly(unsigned col)
 bool DataGridRows::getFieldInfo(unsigned row, unsigned col,
     DataGridFieldInfo& info)
 {
-    if (col >= columnDefsM.size() || row >= buffersM.size())
+    if (col >= columnDefsM.size() || row >= storeM.getRowCount())
         return false;
-    info.rowInserted = buffersM[row]->isInserted();
-    info.rowDeleted = buffersM[row]->isDeleted();
+    // rows that only live in the store are neither inserted nor modified
+    DataGridRowBuffer* buffer = findRowBuffer(row);
+    info.rowInserted = buffer && buffer->isInserted();
+    info.rowDeleted = buffer && buffer->isDeleted();
     info.fieldReadOnly = readOnlyM || info.rowDeleted
         || isColumnReadonly(col) || isFieldReadonly(row, col);
-    info.fieldModified = !info.rowDeleted
-        && buffersM[row]->isFieldModified(col);
-    info.fieldNull = buffersM[row]->isFieldNull(col);
-    info.fieldNA = buffersM[row]->isFieldNA(col);
+    info.fieldModified = !info.rowDeleted && buffer
+        && buffer->isFieldModified(col);
+    info.fieldNull = buffer ? buffer->isFieldNull(col)
+        : storeM.isFieldNull(row, col);
+    info.fieldNA = buffer && buffer->isFieldNA(col);
     info.fieldNumeric = isColumnNumeric(col);
     info.fieldBlob = isBlobColumn(col);
     return true;
@@ -2208,14 +2250,15 @@ bool DataGridRows::getFieldInfo(unsigned row, unsigned col,
 
 bool DataGridRows::isFieldReadonly(unsigned row, unsigned col)
 {
-    if (col >= columnDefsM.size() || row >= buffersM.size())
+    if (col >= columnDefsM.size() || row >= storeM.getRowCount())
         return false;
     if (columnDefsM[col]->isReadOnly())
         return true;
 
     // if row is loaded from the database and not inserted by user, we don't
     // need to check anything else
-    if (!buffersM[row]->isInserted())
+    DataGridRowBuffer* buffer = findRowBuffer(row);
+    if (!buffer || !buffer->isInserted())
         return false;
 
     // TODO: this needs to be cached too
@@ -2239,7 +2282,7 @@ bool DataGridRows::isFieldReadonly(unsigned row, unsigned col)
                 continue;
             wxString tn(std2wxIdentifier(statementM->ColumnTable(c2),
                 databaseM->getCharsetConverter()));
-            if (tn == table && buffersM[row]->isFieldNA(c2-1))
+            if (tn == table && buffer->isFieldNA(c2-1))
                 return true;
         }
     }
@@ -2248,23 +2291,34 @@ bool DataGridRows::isFieldReadonly(unsigned row, unsigned col)
 
 wxString DataGridRows::getFieldValue(unsigned row, unsigned col)
 {
-    if (row >= buffersM.size() || col >= columnDefsM.size())
+    if (row >= storeM.getRowCount() || col >= columnDefsM.size())
         return wxEmptyString;
-    return columnDefsM[col]->getAsString(buffersM[row], databaseM);
+    if (DataGridRowBuffer* buffer = findRowBuffer(row))
+        return columnDefsM[col]->getAsString(buffer, databaseM);
+
+    DataGridRowBuffer* buffer = getRowBuffer(row);
+    wxString value(columnDefsM[col]->getAsString(buffer, databaseM));
+    // BLOB data is loaded on demand, keep it for the next call
+    if (isBlobColumn(col))
+        storeM.storeLoadedStrings(row, buffer);
+    return value;
 }
 
 bool DataGridRows::isFieldNull(unsigned row, unsigned col)
 {
-    if (row >= buffersM.size())
+    if (row >= storeM.getRowCount())
         return false;
-    return buffersM[row]->isFieldNull(col);
+    if (DataGridRowBuffer* buffer = findRowBuffer(row))
+        return buffer->isFieldNull(col);
+    return storeM.isFieldNull(row, col);
 }
 
 bool DataGridRows::isFieldNA(unsigned row, unsigned col)
 {
-    if (row >= buffersM.size())
+    if (row >= storeM.getRowCount())
         return false;
-    return buffersM[row]->isFieldNA(col);
+    DataGridRowBuffer* buffer = findRowBuffer(row);
+    return buffer && buffer->isFieldNA(col);
 }
 
 IBPP::Statement DataGridRows::addWhere(UniqueConstraint* uq, wxString& stm,
@@ -2343,11 +2397,16 @@ bool DataGridRows::isBlobColumn(unsigned col, bool* pIsTextual)
 
 IBPP::Blob* DataGridRows::getBlob(unsigned row, unsigned col, bool validateBlob)
 {
-    if (row >= buffersM.size())
+    if (row >= storeM.getRowCount())
       throw FRError(_("Invalid row index."));
     if (col >= columnDefsM.size())
       throw FRError(_("Invalid col index."));
-    IBPP::Blob* b0 = buffersM[row]->getBlob(columnDefsM[col]->getIndex());
+    unsigned index = columnDefsM[col]->getIndex();
+    IBPP::Blob* b0;
+    if (DataGridRowBuffer* buffer = findRowBuffer(row))
+        b0 = buffer->getBlob(index);
+    else
+        b0 = storeM.getBlob(row, index);
     if ((validateBlob) && (!b0))
         throw FRError(_("BLOB data not valid"));
     return b0;
@@ -2376,7 +2435,7 @@ DataGridRowsBlob DataGridRows::setBlobPrepare(unsigned row, unsigned col)
     DataGridRowsBlob b;
     b.row = row;
     b.col = col;
-    b.st = addWhere((*it).second, stm, tn, buffersM[row]);
+    b.st = addWhere((*it).second, stm, tn, getRowBuffer(row));
     b.blob = IBPP::BlobFactory(b.st->DatabasePtr(), b.st->TransactionPtr());
     return b;
 }
@@ -2389,13 +2448,14 @@ void DataGridRows::setBlob(DataGridRowsBlob &b)
         b.st->Execute();  // we execute before updating internal storage
     }
     
-    buffersM[b.row]->setBlob(columnDefsM[b.col]->getIndex(), b.blob);
-    buffersM[b.row]->setFieldNull(b.col, (b.blob == 0));
-    buffersM[b.row]->setFieldNA(b.col, false);
+    DataGridRowBuffer* buffer = getRowBufferForUpdate(b.row);
+    buffer->setBlob(columnDefsM[b.col]->getIndex(), b.blob);
+    buffer->setFieldNull(b.col, (b.blob == 0));
+    buffer->setFieldNA(b.col, false);
     BlobColumnDef *bcd = dynamic_cast<BlobColumnDef *>(columnDefsM[b.col]);
     if (!bcd)
         throw FRError(_("Not a BLOB column."));
-    bcd->reset(buffersM[b.row]);  // reset cached blob data
+    bcd->reset(buffer);  // reset cached blob data
 }
 
 void DataGridRows::exportBlobFile(const wxString& filename, unsigned row,
@@ -2493,23 +2553,24 @@ wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
     // to ensure atomicity, we create a temporary buffer, try to store value
     // in it and also in database. if anything fails, we revert to the values
     // from temp buffer
+    DataGridRowBuffer *buffer = getRowBufferForUpdate(row);
     DataGridRowBuffer *oldRecord;
     // we create a copy of appropriate type
     InsertedGridRowBuffer *test =
-        dynamic_cast<InsertedGridRowBuffer *>(buffersM[row]);
+        dynamic_cast<InsertedGridRowBuffer *>(buffer);
     if (test)
         oldRecord = new InsertedGridRowBuffer(test);
     else
-        oldRecord = new DataGridRowBuffer(buffersM[row]);
+        oldRecord = new DataGridRowBuffer(buffer);
     try
     {
-        buffersM[row]->setFieldNA(col, false);
+        buffer->setFieldNA(col, false);
         if (newIsNull)
-            buffersM[row]->setFieldNull(col, true);
+            buffer->setFieldNull(col, true);
         else
         {
-            columnDefsM[col]->setFromString(buffersM[row], localValue);
-            buffersM[row]->setFieldNull(col, false);
+            columnDefsM[col]->setFromString(buffer, localValue);
+            buffer->setFieldNull(col, false);
         }
 
         // run the UPDATE statement
@@ -2531,7 +2592,7 @@ wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
                 stm += " = x'";
             else
                 stm += " = '";
-            wxString lval = columnDefsM[col]->getAsFirebirdString(buffersM[row]);
+            wxString lval = columnDefsM[col]->getAsFirebirdString(buffer);
             if (IBPP::isRationalNumber(statementM->ColumnType(col + 1))) //Fix locale problem for "," as decimal separator
                 lval.Replace(",", ".");
             stm += lval
@@ -2555,8 +2616,8 @@ wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
     }
     catch(...)
     {
-        delete buffersM[row];       // delete the new record as it is invalid
-        buffersM[row] = oldRecord;
+        delete buffer;      // delete the new record as it is invalid
+        rowBuffersM[row] = oldRecord;
         throw;
     }
 }
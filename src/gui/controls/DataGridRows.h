@@ -32,6 +32,7 @@
 
 #include "metadata/constraints.h"
 #include "config/Config.h"
+#include "gui/controls/DataGridRowStore.h"
 
 class Database;
 class DataGridRowBuffer;
@@ -140,7 +141,14 @@ private:
     const bool readOnlyM;
     IBPP::Statement statementM;
     std::vector<ResultsetColumnDef*> columnDefsM;
-    std::vector<DataGridRowBuffer*> buffersM;
+    // fetched rows are kept in the columnar store, only rows that are
+    // inserted or changed by the user get a buffer of their own
+    DataGridRowStore storeM;
+    std::map<unsigned, DataGridRowBuffer*> rowBuffersM;
+    // reused buffers for fetching and for reading rows from the store
+    DataGridRowBuffer* fetchBufferM;
+    DataGridRowBuffer* readBufferM;
+    unsigned readBufferRowM;
     std::map<wxString, UniqueConstraint *> statementTablesM;
     std::map<wxString, UniqueConstraint *>::iterator deleteFromM;
     std::list<UniqueConstraint> dbKeysM;
@@ -148,6 +156,9 @@ private:
 
     void getColumnInfo(Database* db, unsigned col, bool& readOnly,
         bool& nullable);
+    DataGridRowBuffer* findRowBuffer(unsigned row);
+    DataGridRowBuffer* getRowBuffer(unsigned row);
+    DataGridRowBuffer* getRowBufferForUpdate(unsigned row);
     IBPP::Statement addWhere(UniqueConstraint* uq, wxString& stm,
         const wxString& table, DataGridRowBuffer *buffer);
 public:
@@ -157,6 +168,8 @@ public:
     void addRow(const IBPP::Statement& statement);
     void clear();
     unsigned getRowCount();
+    // approximate number of bytes used to keep the rows in memory
+    size_t getMemoryUsage();
     unsigned getRowFieldCount();
     wxString getRowFieldName(unsigned col);
     bool initialize(const IBPP::Statement& statement);
@@ -46,9 +46,49 @@
 #include "metadata/database.h"
 #include "metadata/table.h"
 
+// DataGridFetchThread class
+class DataGridFetchThread: public wxThread
+{
+private:
+    DataGridTable* tableM;
+    wxEvtHandler* handlerM;
+    int idM;
+public:
+    DataGridFetchThread(DataGridTable* table, wxEvtHandler* handler, int id);
+
+    virtual ExitCode Entry();
+};
+
+DataGridFetchThread::DataGridFetchThread(DataGridTable* table,
+        wxEvtHandler* handler, int id)
+    : wxThread(wxTHREAD_JOINABLE), tableM(table), handlerM(handler), idM(id)
+{
+}
+
+wxThread::ExitCode DataGridFetchThread::Entry()
+{
+    // tell the grid about new rows at most every 100 ms
+    wxLongLong lastNotifyms = ::wxGetLocalTimeMillis();
+    while (!TestDestroy() && tableM->fetchNextRow())
+    {
+        wxLongLong nowms = ::wxGetLocalTimeMillis();
+        if (nowms - lastNotifyms > 100)
+        {
+            lastNotifyms = nowms;
+            wxQueueEvent(handlerM, new wxCommandEvent(wxEVT_FRDG_ROWS_FETCHED));
+        }
+    }
+    wxCommandEvent* evt = new wxCommandEvent(wxEVT_FRDG_ROWS_FETCHED);
+    evt->SetInt(idM);
+    wxQueueEvent(handlerM, evt);
+    return 0;
+}
+
+// DataGridTable class
 DataGridTable::DataGridTable(IBPP::Statement& s, Database* db)
     : wxGridTableBase(), statementM(s), databaseM(db), nullFlagM(false),
-        rowsM(db)
+        rowsM(db), fetchThreadM(0), fetchThreadIdM(0), notifiedRowCountM(0),
+        fetchEndOfDataM(false), fetchBatchRowsM(0)
 {
     allRowsFetchedM = false;
     fetchAllRowsM = false;
@@ -80,6 +120,7 @@ bool DataGridTable::canFetchMoreRows()
 
 void DataGridTable::Clear()
 {
+    stopFetching();
     nullFlagM = false;
 
     allRowsFetchedM = true;
@@ -88,8 +129,9 @@ void DataGridTable::Clear()
     config().getValue("GridFetchAllRecords", fetchAllRowsM);
 
     unsigned oldCols = rowsM.getRowFieldCount();
-    unsigned oldRows = rowsM.getRowCount();
+    unsigned oldRows = notifiedRowCountM;
     rowsM.clear();
+    notifiedRowCountM = 0;
 
     if (GetView() && oldRows > 0)
     {
@@ -109,26 +151,23 @@ void DataGridTable::fetchOne()
 {
     rowsM.addRow(statementM);
     allRowsFetchedM = true;
-
-    if (GetView())   // notify the grid
-    {
-        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, 1);
-        GetView()->ProcessTableMessage(msg);
-        // used in frame to update status bar
-        wxCommandEvent evt(wxEVT_FRDG_ROWCOUNT_CHANGED, GetView()->GetId());
-        evt.SetExtraLong(1);
-        wxPostEvent(GetView(), evt);
-    }
+    notifyRowsFetched();
 }
 
 void DataGridTable::fetch()
 {
-    if (!canFetchMoreRows())
+    if (!canFetchMoreRows() || fetchThreadM)
         return;
 
-    // fetch the first 100 rows no matter how long it takes
+    // fetch the first 100 rows no matter how long it takes, they are needed
+    // to size the grid columns - then continue in the fetch thread
     unsigned oldRows = rowsM.getRowCount();
     bool initial = oldRows == 0;
+    if (!initial && GetView() && canFetchInThread())
+    {
+        startFetching();
+        return;
+    }
     // fetch more rows until maxRowToFetchM reached or 100 ms elapsed
     wxLongLong startms = ::wxGetLocalTimeMillis();
     do
@@ -159,30 +198,142 @@ void DataGridTable::fetch()
     }
     while ((fetchAllRowsM && !initial) || rowsM.getRowCount() < maxRowToFetchM);
 
-    if (rowsM.getRowCount() > oldRows && GetView())   // notify the grid
+    notifyRowsFetched();
+}
+
+// BLOB columns create IBPP objects for every row, which is not safe to do
+// while other threads use the same database connection
+bool DataGridTable::canFetchInThread()
+{
+    for (unsigned col = 0; col < rowsM.getRowFieldCount(); ++col)
+    {
+        if (rowsM.isBlobColumn(col))
+            return false;
+    }
+    return true;
+}
+
+void DataGridTable::startFetching()
+{
+    wxASSERT(!fetchThreadM);
+    fetchEndOfDataM = false;
+    fetchBatchRowsM = 0;
+    fetchErrorM.clear();
+    fetchErrorTitleM.clear();
+
+    DataGridFetchThread* thread = new DataGridFetchThread(this, GetView(),
+        ++fetchThreadIdM);
+    if (thread->Create() != wxTHREAD_NO_ERROR
+        || thread->Run() != wxTHREAD_NO_ERROR)
+    {
+        delete thread;
+        allRowsFetchedM = true;
+        ::wxMessageBox(_("Error starting thread!"), _("Error"),
+            wxOK | wxICON_ERROR);
+        return;
+    }
+    fetchThreadM = thread;
+}
+
+// runs in the fetch thread
+bool DataGridTable::fetchNextRow()
+{
+    {
+        wxCriticalSectionLocker locker(fetchCritSectM);
+        if (!fetchAllRowsM && rowsM.getRowCount() >= maxRowToFetchM)
+            return false;
+    }
+    try
+    {
+        // rows are fetched from the server in batches, Fetch() then makes
+        // them current one after the other
+        if (fetchBatchRowsM == 0)
+            fetchBatchRowsM = statementM->FetchBatch(256);
+        if (fetchBatchRowsM > 0 && statementM->Fetch())
+        {
+            --fetchBatchRowsM;
+            rowsM.addRow(statementM);
+            return true;
+        }
+    }
+    catch (IBPP::Exception& e)
+    {
+        fetchErrorTitleM = _("An IBPP error occurred.");
+        fetchErrorM = e.what();
+    }
+    catch (...)
+    {
+        fetchErrorTitleM = _("Error");
+        fetchErrorM = _("A system error occurred!");
+    }
+    fetchEndOfDataM = true;
+    return false;
+}
+
+bool DataGridTable::isFetching()
+{
+    return fetchThreadM != 0;
+}
+
+// waits for the fetch thread to finish, fetched rows the grid has not been
+// notified about yet stay pending until the next notifyRowsFetched() call
+void DataGridTable::stopFetching()
+{
+    if (!fetchThreadM)
+        return;
+    // makes TestDestroy() return true and waits for the joinable thread
+    fetchThreadM->Delete();
+    finishFetching();
+}
+
+void DataGridTable::finishFetching()
+{
+    wxASSERT(fetchThreadM);
+    delete fetchThreadM;
+    fetchThreadM = 0;
+
+    if (fetchEndOfDataM)
+        allRowsFetchedM = true;
+    if (!fetchErrorM.empty())
+    {
+        ::wxMessageBox(fetchErrorM, fetchErrorTitleM, wxOK | wxICON_ERROR);
+        fetchErrorM.clear();
+    }
+}
+
+void DataGridTable::notifyRowsFetched(int finishedThreadId)
+{
+    if (fetchThreadM && finishedThreadId == fetchThreadIdM)
+    {
+        fetchThreadM->Wait();
+        finishFetching();
+    }
+
+    unsigned rowCount = rowsM.getRowCount();
+    if (rowCount <= notifiedRowCountM)
+        return;
+    unsigned newRows = rowCount - notifiedRowCountM;
+    notifiedRowCountM = rowCount;
+    if (GetView())   // notify the grid
     {
         wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED,
-            rowsM.getRowCount() - oldRows);
+            newRows);
         GetView()->ProcessTableMessage(msg);
         // used in frame to update status bar
         wxCommandEvent evt(wxEVT_FRDG_ROWCOUNT_CHANGED, GetView()->GetId());
-        evt.SetExtraLong(rowsM.getRowCount());
+        evt.SetExtraLong(rowCount);
         wxPostEvent(GetView(), evt);
     }
 }
 
 void DataGridTable::addRow(DataGridRowBuffer *buffer, const wxString& sql)
 {
+    // the new row has to go after all rows fetched so far
+    stopFetching();
     rowsM.addRow(buffer);
-    if (GetView())  // notify the grid
+    notifyRowsFetched();
+    if (GetView())
     {
-        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, 1);
-        GetView()->ProcessTableMessage(msg);
-        // used in frame to update status bar
-        wxCommandEvent evt(wxEVT_FRDG_ROWCOUNT_CHANGED, GetView()->GetId());
-        evt.SetExtraLong(rowsM.getRowCount());
-        wxPostEvent(GetView(), evt);
-
         // used in frame to show executed statements
         wxCommandEvent evt2(wxEVT_FRDG_STATEMENT, GetView()->GetId());
         evt2.SetString(sql);
@@ -310,7 +461,7 @@ int DataGridTable::GetNumberCols()
 
 int DataGridTable::GetNumberRows()
 {
-    return rowsM.getRowCount();
+    return notifiedRowCountM;
 }
 
 int DataGridTable::getStatementColCount()
@@ -431,7 +582,10 @@ wxString DataGridTable::GetValue(int row, int col)
     // (but make the count of fetched rows a multiple of 50)
     unsigned maxRowToFetch = 50 * (row / 50 + 5);
     if (maxRowToFetchM < maxRowToFetch)
+    {
+        wxCriticalSectionLocker locker(fetchCritSectM);
         maxRowToFetchM = maxRowToFetch;
+    }
 
     if (rowsM.isFieldNA(row, col))
         return "N/A";
@@ -509,7 +663,7 @@ bool DataGridTable::isReadonlyColumn(int col)
 
 bool DataGridTable::isValidCellPos(int row, int col)
 {
-    return (row >= 0 && col >= 0 && row < (int)rowsM.getRowCount()
+    return (row >= 0 && col >= 0 && row < (int)notifiedRowCountM
         && col < (int)rowsM.getRowFieldCount());
 }
 
@@ -541,6 +695,7 @@ bool DataGridTable::needsMoreRowsFetched()
 
 void DataGridTable::setFetchAllRecords(bool fetchall)
 {
+    wxCriticalSectionLocker locker(fetchCritSectM);
     fetchAllRowsM = fetchall;
 }
 
@@ -551,17 +706,20 @@ IBPP::Blob* DataGridTable::getBlob(unsigned row, unsigned col, bool validateBlob
 
 DataGridRowsBlob DataGridTable::setBlobPrepare(unsigned row, unsigned col)
 {
+    stopFetching();
     return rowsM.setBlobPrepare(row, col);
 }
 
 void DataGridTable::setBlob(DataGridRowsBlob &b)
 {
+    stopFetching();
     rowsM.setBlob(b);
 }
 
 void DataGridTable::importBlobFile(const wxString& filename, int row, int col,
     ProgressIndicator *pi)
 {
+    stopFetching();
     rowsM.importBlobFile(filename, row, col, pi);
 
     // tell the grid it's done
@@ -594,6 +752,8 @@ void DataGridTable::SetValue(int row, int col, const wxString& value)
     // UPDATE statement. See bug report #1882666 at sf.net.
     try
     {
+        // user edits run statements on the same connection
+        stopFetching();
         wxString statement = rowsM.setFieldValue(row, col, value,
             nullFlagM);
         nullFlagM = false;  // reset
@@ -642,7 +802,7 @@ void DataGridTable::setValueToNull(int row, int col)
         b.col  = col;
         b.row  = row;
         b.st   = statementM;
-        rowsM.setBlob(b);
+        setBlob(b);
     }
 }
 
@@ -652,6 +812,7 @@ bool DataGridTable::DeleteRows(size_t pos, size_t numRows)
     try
     {
         // remove rows from internal storage
+        stopFetching();
         wxString statement;
         if (!rowsM.removeRows(pos, numRows, statement))
             return false;
@@ -684,4 +845,5 @@ bool DataGridTable::DeleteRows(size_t pos, size_t numRows)
 DEFINE_EVENT_TYPE(wxEVT_FRDG_ROWCOUNT_CHANGED)
 DEFINE_EVENT_TYPE(wxEVT_FRDG_STATEMENT)
 DEFINE_EVENT_TYPE(wxEVT_FRDG_INVALIDATEATTR)
+DEFINE_EVENT_TYPE(wxEVT_FRDG_ROWS_FETCHED)
 
@@ -26,6 +26,7 @@
 
 #include <wx/wx.h>
 #include <wx/grid.h>
+#include <wx/thread.h>
 
 #include <ibpp.h>
 
@@ -37,6 +38,7 @@ class Database;
 class DataGridCell;
 class ResultsetColumnDef;
 class DataGridRowBuffer;
+class DataGridFetchThread;
 class ProgressIndicator;
 
 BEGIN_DECLARE_EVENT_TYPES()
@@ -47,6 +49,9 @@ BEGIN_DECLARE_EVENT_TYPES()
     // this event is sent to cause the attribute cache to be invalidated
     // after a field value has changed
     DECLARE_LOCAL_EVENT_TYPE(wxEVT_FRDG_INVALIDATEATTR, 44)
+    // this event is sent by the fetch thread after rows have been added,
+    // and with the id of the thread in the int field when it has finished
+    DECLARE_LOCAL_EVENT_TYPE(wxEVT_FRDG_ROWS_FETCHED, 45)
 END_DECLARE_EVENT_TYPES()
 
 class DataGridTable: public wxGridTableBase
@@ -68,8 +73,25 @@ private:
     IBPP::Statement& statementM;
     wxMBConv* charsetConverterM;
 
+    // rows are fetched in a separate thread, the grid is told about them
+    // in batches, so it may know about fewer rows than have been fetched
+    DataGridFetchThread* fetchThreadM;
+    int fetchThreadIdM;
+    unsigned notifiedRowCountM;
+    // protects the fetch limits, which are read by the fetch thread
+    wxCriticalSection fetchCritSectM;
+    // fetch thread results, only read after the thread has been joined
+    bool fetchEndOfDataM;
+    // rows left in the statement's batch buffer, only used by the thread
+    int fetchBatchRowsM;
+    wxString fetchErrorM;
+    wxString fetchErrorTitleM;
+
     int getStatementColCount();
     bool isValidCellPos(int row, int col);
+    bool canFetchInThread();
+    void startFetching();
+    void finishFetching();
 public:
     DataGridTable(IBPP::Statement& s, Database* db);
     ~DataGridTable();
@@ -77,6 +99,12 @@ public:
     bool canFetchMoreRows();
     void fetch();
     void fetchOne();
+    bool isFetching();
+    void stopFetching();
+    // called for wxEVT_FRDG_ROWS_FETCHED events
+    void notifyRowsFetched(int finishedThreadId = 0);
+    // called by the fetch thread, returns false when it should stop
+    bool fetchNextRow();
     void addRow(DataGridRowBuffer *buffer, const wxString& sql);
     wxString getCellValue(int row, int col);
     wxString getCellValueForInsert(int row, int col);
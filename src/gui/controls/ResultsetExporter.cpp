@@ -0,0 +1,601 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/textfile.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/FRError.h"
+#include "core/ProgressIndicator.h"
+#include "core/StringUtils.h"
+#include "gui/controls/DataGridRowBuffer.h"
+#include "gui/controls/DataGridRows.h"
+#include "gui/controls/ResultsetExporter.h"
+#include "metadata/database.h"
+
+// ResultsetExportWriter class
+// Base class for the export formats, collects the output in a buffer that
+// is written to the file whenever it is full.
+class ResultsetExportWriter
+{
+private:
+    wxFFile& fileM;
+    std::string bufferM;
+protected:
+    enum { bufferSizeM = 256 * 1024 };
+
+    void write(const char* data, size_t length);
+    void write(const std::string& s) { write(s.data(), s.size()); }
+    void write(char c);
+    void writeUInt32(uint32_t value);
+    void writeUInt64(uint64_t value);
+public:
+    ResultsetExportWriter(wxFFile& file);
+    virtual ~ResultsetExportWriter();
+
+    virtual void begin(const std::vector<std::string>& names,
+        const std::vector<bool>& numeric) = 0;
+    // values[i] is only valid when nulls[i] is false
+    virtual void writeRow(const std::vector<std::string>& values,
+        const std::vector<bool>& nulls) = 0;
+    virtual void end();
+    void flush();
+};
+
+ResultsetExportWriter::ResultsetExportWriter(wxFFile& file)
+    : fileM(file)
+{
+    bufferM.reserve(bufferSizeM);
+}
+
+ResultsetExportWriter::~ResultsetExportWriter()
+{
+}
+
+void ResultsetExportWriter::flush()
+{
+    if (bufferM.empty())
+        return;
+    if (fileM.Write(bufferM.data(), bufferM.size()) != bufferM.size())
+        throw FRError(_("Cannot write to destination file."));
+    bufferM.clear();
+}
+
+void ResultsetExportWriter::write(const char* data, size_t length)
+{
+    if (bufferM.size() + length > bufferSizeM)
+    {
+        flush();
+        // large values are written directly
+        if (length > bufferSizeM)
+        {
+            if (fileM.Write(data, length) != length)
+                throw FRError(_("Cannot write to destination file."));
+            return;
+        }
+    }
+    bufferM.append(data, length);
+}
+
+void ResultsetExportWriter::write(char c)
+{
+    if (bufferM.size() >= bufferSizeM)
+        flush();
+    bufferM += c;
+}
+
+void ResultsetExportWriter::writeUInt32(uint32_t value)
+{
+    char data[4];
+    for (int i = 0; i < 4; ++i, value >>= 8)
+        data[i] = char(value & 0xFF);
+    write(data, 4);
+}
+
+void ResultsetExportWriter::writeUInt64(uint64_t value)
+{
+    char data[8];
+    for (int i = 0; i < 8; ++i, value >>= 8)
+        data[i] = char(value & 0xFF);
+    write(data, 8);
+}
+
+void ResultsetExportWriter::end()
+{
+    flush();
+}
+
+// CSVExportWriter class
+// Writes the same output as DataGrid::saveAsCSV(), but escapes each value
+// in a single pass over its UTF-8 representation.
+class CSVExportWriter: public ResultsetExportWriter
+{
+private:
+    char fieldDelimiterM;
+    char textDelimiterM;
+    std::string eolM;
+    std::vector<bool> numericM;
+
+    void writeText(const std::string& s);
+public:
+    CSVExportWriter(wxFFile& file, char fieldDelimiter, char textDelimiter);
+
+    virtual void begin(const std::vector<std::string>& names,
+        const std::vector<bool>& numeric);
+    virtual void writeRow(const std::vector<std::string>& values,
+        const std::vector<bool>& nulls);
+};
+
+CSVExportWriter::CSVExportWriter(wxFFile& file, char fieldDelimiter,
+        char textDelimiter)
+    : ResultsetExportWriter(file), fieldDelimiterM(fieldDelimiter),
+      textDelimiterM(textDelimiter), eolM(wx2std(wxTextFile::GetEOL()))
+{
+}
+
+void CSVExportWriter::writeText(const std::string& s)
+{
+    if (textDelimiterM)
+        write(textDelimiterM);
+    const char* p = s.data();
+    const char* end = p + s.size();
+    const char* start = p;
+    for (; p != end; ++p)
+    {
+        // line breaks are written as the native EOL sequence,
+        // embedded text delimiters are doubled
+        if (*p == '\r' && p + 1 != end && p[1] == '\n')
+        {
+            write(start, p - start);
+            start = p + 1;
+        }
+        else if (*p == '\n')
+        {
+            write(start, p - start);
+            write(eolM);
+            start = p + 1;
+        }
+        else if (textDelimiterM && *p == textDelimiterM)
+        {
+            write(start, p + 1 - start);
+            start = p;
+        }
+    }
+    write(start, end - start);
+    if (textDelimiterM)
+        write(textDelimiterM);
+}
+
+void CSVExportWriter::begin(const std::vector<std::string>& names,
+    const std::vector<bool>& numeric)
+{
+    numericM = numeric;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (i)
+            write(fieldDelimiterM);
+        writeText(names[i]);
+    }
+    if (!names.empty())
+        write(eolM);
+}
+
+void CSVExportWriter::writeRow(const std::vector<std::string>& values,
+    const std::vector<bool>& nulls)
+{
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i)
+            write(fieldDelimiterM);
+        if (nulls[i])
+        {
+            if (textDelimiterM)
+                write(textDelimiterM);
+            write("NULL", 4);
+            if (textDelimiterM)
+                write(textDelimiterM);
+        }
+        else if (numericM[i])
+            write(values[i]);
+        else
+            writeText(values[i]);
+    }
+    write(eolM);
+}
+
+// JSONLinesExportWriter class
+// Writes one JSON object per line, with the column names as keys.
+class JSONLinesExportWriter: public ResultsetExportWriter
+{
+private:
+    std::vector<std::string> keysM;
+    std::vector<bool> numericM;
+
+    void writeString(const std::string& s);
+    static bool isJSONNumber(const std::string& s);
+public:
+    JSONLinesExportWriter(wxFFile& file);
+
+    virtual void begin(const std::vector<std::string>& names,
+        const std::vector<bool>& numeric);
+    virtual void writeRow(const std::vector<std::string>& values,
+        const std::vector<bool>& nulls);
+};
+
+JSONLinesExportWriter::JSONLinesExportWriter(wxFFile& file)
+    : ResultsetExportWriter(file)
+{
+}
+
+void JSONLinesExportWriter::writeString(const std::string& s)
+{
+    write('"');
+    const char* p = s.data();
+    const char* end = p + s.size();
+    const char* start = p;
+    for (; p != end; ++p)
+    {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        write(start, p - start);
+        start = p + 1;
+        switch (c)
+        {
+            case '"': write("\\\"", 2); break;
+            case '\\': write("\\\\", 2); break;
+            case '\n': write("\\n", 2); break;
+            case '\r': write("\\r", 2); break;
+            case '\t': write("\\t", 2); break;
+            default:
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                write(buf, 6);
+            }
+        }
+    }
+    write(start, end - start);
+    write('"');
+}
+
+bool JSONLinesExportWriter::isJSONNumber(const std::string& s)
+{
+    // numeric values are formatted according to the grid settings, which
+    // may use a locale specific decimal separator, write them as strings
+    // then so the output is always valid JSON
+    if (s.empty())
+        return false;
+    size_t i = (s[0] == '-') ? 1 : 0;
+    if (i == s.size() || s[i] < '0' || s[i] > '9')
+        return false;
+    for (; i < s.size(); ++i)
+    {
+        char c = s[i];
+        if ((c < '0' || c > '9') && c != '.' && c != 'e' && c != 'E'
+            && c != '+' && c != '-')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void JSONLinesExportWriter::begin(const std::vector<std::string>& names,
+    const std::vector<bool>& numeric)
+{
+    numericM = numeric;
+    keysM.clear();
+    // the quoted keys are the same for every row, build them once
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        std::string key;
+        key.reserve(names[i].size() + 3);
+        key += (i ? ',' : '{');
+        key += '"';
+        for (size_t j = 0; j < names[i].size(); ++j)
+        {
+            char c = names[i][j];
+            if (c == '"' || c == '\\')
+                key += '\\';
+            key += c;
+        }
+        key += "\":";
+        keysM.push_back(key);
+    }
+}
+
+void JSONLinesExportWriter::writeRow(const std::vector<std::string>& values,
+    const std::vector<bool>& nulls)
+{
+    if (values.empty())
+        write('{');
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        write(keysM[i]);
+        if (nulls[i])
+            write("null", 4);
+        else if (numericM[i] && isJSONNumber(values[i]))
+            write(values[i]);
+        else
+            writeString(values[i]);
+    }
+    write("}\n", 2);
+}
+
+// ColumnarExportWriter class
+// Collects groupRowsM rows per column before writing them, see the format
+// description in ResultsetExporter.h.
+class ColumnarExportWriter: public ResultsetExportWriter
+{
+private:
+    enum { groupRowsM = 8192 };
+
+    struct ColumnChunk
+    {
+        std::vector<uint8_t> nulls;
+        std::string data;
+    };
+    std::vector<ColumnChunk> chunksM;
+    unsigned groupRowCountM;
+    uint64_t rowCountM;
+
+    void writeGroup();
+public:
+    ColumnarExportWriter(wxFFile& file);
+
+    virtual void begin(const std::vector<std::string>& names,
+        const std::vector<bool>& numeric);
+    virtual void writeRow(const std::vector<std::string>& values,
+        const std::vector<bool>& nulls);
+    virtual void end();
+};
+
+ColumnarExportWriter::ColumnarExportWriter(wxFFile& file)
+    : ResultsetExportWriter(file), groupRowCountM(0), rowCountM(0)
+{
+}
+
+void ColumnarExportWriter::begin(const std::vector<std::string>& names,
+    const std::vector<bool>& numeric)
+{
+    write("FRCOLS01", 8);
+    writeUInt32(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        writeUInt32(names[i].size());
+        write(names[i]);
+        write(char(numeric[i] ? 1 : 0));
+    }
+    chunksM.resize(names.size());
+    for (size_t i = 0; i < chunksM.size(); ++i)
+        chunksM[i].nulls.reserve(groupRowsM / 8);
+}
+
+void ColumnarExportWriter::writeRow(const std::vector<std::string>& values,
+    const std::vector<bool>& nulls)
+{
+    unsigned bit = groupRowCountM % 8;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        ColumnChunk& chunk = chunksM[i];
+        if (bit == 0)
+            chunk.nulls.push_back(0);
+        if (nulls[i])
+        {
+            chunk.nulls.back() |= uint8_t(1 << bit);
+            continue;
+        }
+        uint32_t length = values[i].size();
+        for (int j = 0; j < 4; ++j, length >>= 8)
+            chunk.data += char(length & 0xFF);
+        chunk.data += values[i];
+    }
+    ++rowCountM;
+    if (++groupRowCountM == groupRowsM)
+        writeGroup();
+}
+
+void ColumnarExportWriter::writeGroup()
+{
+    if (groupRowCountM == 0)
+        return;
+    writeUInt32(groupRowCountM);
+    for (size_t i = 0; i < chunksM.size(); ++i)
+    {
+        ColumnChunk& chunk = chunksM[i];
+        writeUInt32(chunk.nulls.size() + chunk.data.size());
+        write((const char*)&chunk.nulls[0], chunk.nulls.size());
+        write(chunk.data);
+        // keep the allocated memory for the next group
+        chunk.nulls.clear();
+        chunk.data.clear();
+    }
+    groupRowCountM = 0;
+}
+
+void ColumnarExportWriter::end()
+{
+    writeGroup();
+    writeUInt32(0);
+    writeUInt64(rowCountM);
+    ResultsetExportWriter::end();
+}
+
+// ResultsetExporter class
+ResultsetExporter::ResultsetExporter(Database* db, Format format)
+    : databaseM(db), formatM(format), fieldDelimiterM(','),
+      textDelimiterM('"'), canceledM(false)
+{
+}
+
+void ResultsetExporter::setCSVDelimiters(wxChar fieldDelimiter,
+    wxChar textDelimiter)
+{
+    fieldDelimiterM = fieldDelimiter;
+    textDelimiterM = textDelimiter;
+}
+
+/*static*/
+ResultsetExporter::Format ResultsetExporter::getFormatForFileName(
+    const wxString& fileName)
+{
+    wxString ext(wxFileName(fileName).GetExt().Lower());
+    if (ext == "json" || ext == "jsonl" || ext == "ndjson")
+        return efJSONLines;
+    if (ext == "frc")
+        return efColumnar;
+    return efCSV;
+}
+
+ResultsetExportWriter* ResultsetExporter::createWriter(wxFFile& file)
+{
+    switch (formatM)
+    {
+        case efJSONLines:
+            return new JSONLinesExportWriter(file);
+        case efColumnar:
+            return new ColumnarExportWriter(file);
+        default:
+            return new CSVExportWriter(file, char(fieldDelimiterM),
+                char(textDelimiterM));
+    }
+}
+
+unsigned ResultsetExporter::exportSql(const wxString& sql,
+    IBPP::Transaction& transaction, const wxString& fileName,
+    ProgressIndicator* pi)
+{
+    IBPP::Statement st = IBPP::StatementFactory(
+        databaseM->getIBPPDatabase(), transaction);
+    st->Prepare(wx2std(sql, databaseM->getCharsetConverter()));
+    if (st->Columns() == 0)
+        throw FRError(_("The statement does not return a result set."));
+    // anything but a select would change data a second time
+    if (st->Type() != IBPP::stSelect)
+        throw FRError(_("Only select statements can be executed again for exporting."));
+    if (st->Parameters() > 0)
+        throw FRError(_("Statements with parameters can not be exported."));
+    st->Execute();
+    unsigned count = exportStatement(st, fileName, pi);
+    st->Close();
+    return count;
+}
+
+unsigned ResultsetExporter::exportStatement(IBPP::Statement& statement,
+    const wxString& fileName, ProgressIndicator* pi)
+{
+    canceledM = false;
+    // the column definitions of the grid are used for formatting only,
+    // no row is ever added to the DataGridRows object
+    DataGridRows rows(databaseM);
+    rows.initialize(statement);
+    unsigned colCount = rows.getRowFieldCount();
+
+    std::vector<std::string> names(colCount);
+    std::vector<bool> numeric(colCount);
+    for (unsigned col = 0; col < colCount; ++col)
+    {
+        const wxScopedCharBuffer name(rows.getRowFieldName(col).utf8_str());
+        names[col].assign(name.data(), name.length());
+        numeric[col] = rows.isColumnNumeric(col);
+    }
+
+    wxFFile file(fileName, "wb");
+    if (!file.IsOpened())
+        throw FRError(_("Cannot open destination file."));
+    std::unique_ptr<ResultsetExportWriter> writer(createWriter(file));
+    writer->begin(names, numeric);
+
+    if (pi)
+        pi->initProgressIndeterminate(_("Exporting rows..."));
+
+    wxMBConv* converter = databaseM->getCharsetConverter();
+    DataGridRowBuffer buffer(colCount);
+    std::vector<std::string> values(colCount);
+    std::vector<bool> nulls(colCount);
+    unsigned rowCount = 0;
+    int batchRows = 0;
+    while (colCount)
+    {
+        // rows are fetched from the server in batches, Fetch() then makes
+        // them current one after the other
+        if (batchRows == 0)
+            batchRows = statement->FetchBatch(256);
+        if (batchRows == 0 || !statement->Fetch())
+            break;
+        --batchRows;
+
+        buffer.reset();
+        // starts with last column, see DataGridRows::addRow()
+        unsigned col = colCount;
+        do
+        {
+            // IBPP column counts are 1-based, not 0-based...
+            unsigned colIBPP = col--;
+            nulls[col] = statement->IsNull(colIBPP);
+            if (nulls[col])
+                continue;
+            ResultsetColumnDef* columnDef = rows.getColumnDef(col);
+            buffer.setFieldNull(col, false);
+            columnDef->setValue(&buffer, colIBPP, statement, converter,
+                databaseM);
+            const wxScopedCharBuffer value(
+                columnDef->getAsString(&buffer, databaseM).utf8_str());
+            values[col].assign(value.data(), value.length());
+        }
+        while (col > 0);
+        writer->writeRow(values, nulls);
+
+        if (++rowCount % 1000 == 0 && pi)
+        {
+            pi->setProgressMessage(wxString::Format(
+                _("%u rows exported..."), rowCount));
+            if (pi->isCanceled())
+            {
+                canceledM = true;
+                break;
+            }
+        }
+    }
+    writer->end();
+    file.Close();
+    // a partial file would look like a complete export
+    if (canceledM)
+        wxRemoveFile(fileName);
+    return rowCount;
+}
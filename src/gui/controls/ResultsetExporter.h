@@ -0,0 +1,84 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_RESULTSETEXPORTER_H
+#define FR_RESULTSETEXPORTER_H
+
+#include <wx/string.h>
+
+#include <ibpp.h>
+
+class Database;
+class ProgressIndicator;
+class ResultsetExportWriter;
+class wxFFile;
+
+// ResultsetExporter class
+// Streams all rows of a result set from the cursor into a file, without
+// keeping them in a DataGridRows object.  Values are formatted by the same
+// column definitions the data grid uses, one reused row buffer holds the
+// current row and the output goes through a fixed size write buffer, so
+// memory usage does not depend on the number of exported rows.
+//
+// Supported formats are CSV, JSON Lines (one object per row) and a simple
+// columnar binary format:
+//   file   := "FRCOLS01" u32:columnCount column* group* u32:0 u64:rowCount
+//   column := u32:nameLength name u8:flags (1 = numeric)
+//   group  := u32:rowCount chunk*  (one chunk per column)
+//   chunk  := u32:chunkLength nullBitmap[(rowCount + 7) / 8]
+//             (u32:valueLength value)*  (for every non-null value)
+// All integers are little-endian, names and values are UTF-8 text.
+class ResultsetExporter
+{
+public:
+    enum Format { efCSV, efJSONLines, efColumnar };
+private:
+    Database* databaseM;
+    Format formatM;
+    wxChar fieldDelimiterM;
+    wxChar textDelimiterM;
+    bool canceledM;
+
+    ResultsetExportWriter* createWriter(wxFFile& file);
+public:
+    ResultsetExporter(Database* db, Format format);
+
+    // only used for efCSV, textDelimiter may be '\0' for unquoted text
+    void setCSVDelimiters(wxChar fieldDelimiter, wxChar textDelimiter);
+
+    // prepares and executes sql in the given transaction and exports the
+    // result set, returns the number of exported rows
+    // only select statements are accepted, since sql is executed again
+    unsigned exportSql(const wxString& sql, IBPP::Transaction& transaction,
+        const wxString& fileName, ProgressIndicator* pi = 0);
+    // exports all remaining rows of an executed statement
+    // when the export is canceled through pi the file is deleted
+    unsigned exportStatement(IBPP::Statement& statement,
+        const wxString& fileName, ProgressIndicator* pi = 0);
+    // whether the last export has been canceled
+    bool isCanceled() const { return canceledM; }
+
+    static Format getFormatForFileName(const wxString& fileName);
+};
+
+#endif
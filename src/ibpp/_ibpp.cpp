@@ -356,6 +356,8 @@ FBCLIENT* FBCLIENT::Call()
 		IB_ENTRYPOINT(service_query);
 
 		FB_ENTRYPOINT_NOTHROW(get_master_interface);
+		FB_ENTRYPOINT_NOTHROW(get_statement_interface);
+		FB_ENTRYPOINT_NOTHROW(get_transaction_interface);
 
 		mReady = true;
 	}
@@ -446,6 +448,12 @@ namespace IBPP
 		return new EventsImpl(dynamic_cast<DatabaseImpl*>(db.intf()));
 	}
 
+	Batch BatchFactory(Statement st)
+	{
+        (void)gds.Call();			// Triggers the initialization, if needed
+		return new BatchImpl(dynamic_cast<StatementImpl*>(st.intf()));
+	}
+
     bool isIntegerNumber(SDT type)
     {
         switch (type) {
@@ -115,6 +115,7 @@ class StatementImpl;
 class BlobImpl;
 class ArrayImpl;
 class EventsImpl;
+class BatchImpl;
 
 //  Native data types
 typedef enum {ivArray, ivBlob, ivDate, ivTime, ivTimestamp, ivString,
@@ -391,6 +392,17 @@ typedef void        ISC_EXPORT proto_encode_timestamp (void *,
 //
 typedef Firebird::IMaster* ISC_EXPORT proto_get_master_interface();
 
+//
+//  FB3+ / OO API interfaces of legacy handles
+//
+typedef ISC_STATUS ISC_EXPORT proto_get_statement_interface (ISC_STATUS *,
+                    void *,
+                    isc_stmt_handle *);
+
+typedef ISC_STATUS ISC_EXPORT proto_get_transaction_interface (ISC_STATUS *,
+                    void *,
+                    isc_tr_handle *);
+
 //
 //  Internal binding structure to the FBCLIENT DLL
 //
@@ -474,6 +486,8 @@ struct FBCLIENT
     //proto_encode_timestamp*           m_encode_timestamp;
 
     proto_get_master_interface*     m_get_master_interface;
+    proto_get_statement_interface*  m_get_statement_interface;
+    proto_get_transaction_interface*    m_get_transaction_interface;
 
     // Constructor (No need for a specific destructor)
     FBCLIENT()
@@ -604,6 +618,7 @@ class IBS
 {
     mutable ISC_STATUS mVector[20];
     mutable std::string mMessage;
+    std::string mStrings[10];   // String arguments copied by Assign()
 
 public:
     ISC_STATUS* Self() { return mVector; }
@@ -612,12 +627,17 @@ public:
     int SqlCode() const;
     int EngineCode() const { return (mVector[0] == 1) ? (int)mVector[1] : 0; }
     void Reset();
+    void Assign(const ISC_STATUS* vector);  // From a Firebird::IStatus
 
     IBS();
     IBS(IBS&);  // Copy Constructor
     ~IBS();
 };
 
+// Throws the error of a failed OO API call, after disposing of its status
+void ThrowStatusError(Firebird::CheckStatusWrapper& status,
+    const std::string& context, const char* message);
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Implementation of the "hidden" classes associated with their public
@@ -993,6 +1013,8 @@ private:
     std::vector<char> mBools;       // Temporary storage for Bools
     std::vector<std::string> mStrings;  // Temporary storage for Strings
     std::vector<bool> mUpdated;     // Which columns where updated (Set()) ?
+    std::vector<char*> mOwnData;    // Own sqldata while attached to a message
+    std::vector<short*> mOwnInd;    // Own sqlind while attached to a message
 
     int mDialect;                   // Related database dialect
     DatabaseImpl* mDatabase;        // Related Database (important for Blobs, ...)
@@ -1009,6 +1031,19 @@ public:
     bool MissingValues();       // Returns wether one of the mMissing[] is true
     XSQLDA* Self() { return mDescrArea; }
 
+    // Firebird OO API message buffers (see StatementImpl::FetchBatch)
+    static int MessageDataLength(const XSQLVAR* var);
+    unsigned MessageLayout(std::vector<unsigned>& offsets,
+        std::vector<unsigned>& nullOffsets);
+    void CopyFromMessage(const char* message,
+        const std::vector<unsigned>& offsets,
+        const std::vector<unsigned>& nullOffsets);
+    void CopyToMessage(char* message, const std::vector<unsigned>& offsets,
+        const std::vector<unsigned>& nullOffsets);
+    void AttachMessage(char* message, const std::vector<unsigned>& offsets,
+        const std::vector<unsigned>& nullOffsets);
+    void DetachMessage();
+
     RowImpl& operator=(const RowImpl& copied);
     RowImpl(const RowImpl& copied);
     RowImpl(int dialect, int size, DatabaseImpl* db, TransactionImpl* tr);
@@ -1103,6 +1138,7 @@ class StatementImpl : public IBPP::IStatement
 
 private:
     friend class TransactionImpl;
+    friend class BatchImpl;
 
     int mRefCount;              // Reference counter
     isc_stmt_handle mHandle;    // Statement Handle
@@ -1118,8 +1154,33 @@ private:
     std::string mSql;           // Last SQL statement prepared or executed
     std::string mSqlWithParams; // Last SQL statement with parameters replaced by '?'
 
+    // Result set opened through the FB3+ OO API, its rows are fetched as
+    // messages into mBatchBuffer and read in place through mOutRow
+    Firebird::IResultSet* mResultSet;
+    std::vector<char> mBatchBuffer;     // Contiguous output messages
+    std::vector<unsigned> mBatchOffsets;        // Column offsets in a message
+    std::vector<unsigned> mBatchNullOffsets;    // Null indicator offsets
+    unsigned mBatchMessageLength;       // Message length, aligned
+    int mBatchRows;             // Messages in mBatchBuffer
+    int mBatchPos;              // Next message to be returned by Fetch()
+    bool mBatchEnd;             // End of result set fetched into mBatchBuffer
+
     // Internal Methods
     void CursorFree();
+    void CursorClosed();
+    Firebird::IStatement* StatementInterface();
+    Firebird::ITransaction* TransactionInterface();
+    Firebird::IMessageMetadata* InputMetadata(Firebird::IStatement* statement,
+        Firebird::CheckStatusWrapper* status);
+    static void MessageOffsets(Firebird::IMessageMetadata* meta,
+        Firebird::CheckStatusWrapper* status, std::vector<unsigned>& offsets,
+        std::vector<unsigned>& nullOffsets);
+    bool ResultSetOpen();
+    void ResultSetFree();
+    void BatchReset();
+    void BatchLayout();
+    bool BatchFetching()
+        { return mResultSet != 0 || mBatchPos < mBatchRows || mBatchEnd; }
 
 public:
     // Properties and Attributes Access Methods
@@ -1146,6 +1207,7 @@ public:
     inline void CursorExecute(const std::string& cursor)    { CursorExecute(cursor, std::string()); }
     bool Fetch();
     bool Fetch(IBPP::Row&);
+    int FetchBatch(int count);
     int AffectedRows();
     void Close();   // Free resources, attachments maintained
     std::string& Sql() { return mSql; }
@@ -1464,6 +1526,58 @@ public:
     void Release();
 };
 
+class BatchImpl : public IBPP::IBatch
+{
+    //  (((((((( OBJECT INTERNALS ))))))))
+
+private:
+    int mRefCount;                  // Reference counter
+
+    IBPP::Statement mStatementPtr;  // Keeps the statement alive
+    StatementImpl* mStatement;
+    isc_stmt_handle mHandle;        // Statement handle the batch was made for
+    Firebird::IBatch* mBatch;       // 0 when rows are executed one by one
+    bool mInitialized;
+
+    std::vector<unsigned> mOffsets;     // Parameter offsets in a message
+    std::vector<unsigned> mNullOffsets; // Null indicator offsets
+    unsigned mMessageLength;
+    std::vector<char> mMessages;    // Queued rows (only the last one with mBatch)
+    int mRows;                      // Number of queued rows
+    int mCapacity;                  // Rows fitting in the buffer of mBatch
+
+    std::vector<int> mStates;       // Results of the last Execute()
+    std::vector<std::string> mErrors;
+
+    void Init();
+    int ExecuteBatch();
+    int ExecuteRows();
+
+    BatchImpl& operator=(const BatchImpl&);
+    BatchImpl(const BatchImpl&);
+
+public:
+    BatchImpl(StatementImpl* statement);
+    ~BatchImpl();
+
+    //  (((((((( OBJECT INTERFACE ))))))))
+
+public:
+    void Add();
+    int Execute();
+    void Cancel();
+    int Rows() { return mRows; }
+    bool Full() { return mBatch != 0 && mRows >= mCapacity; }
+
+    int RowState(int row);
+    const std::string& RowError(int row);
+
+    IBPP::Statement StatementPtr() const;
+
+    IBPP::IBatch* AddRef();
+    void Release();
+};
+
 void encodeDate(ISC_DATE& isc_dt, const IBPP::Date& dt);
 void decodeDate(IBPP::Date& dt, const ISC_DATE& isc_dt);
 
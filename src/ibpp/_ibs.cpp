@@ -83,6 +83,47 @@ void IBS::Reset()
 	mMessage.erase();
 }
 
+// Copies an error vector of the OO API, which may be longer than ours.
+// The strings it points to belong to the Firebird::IStatus and are freed
+// with it, so they are copied too.
+void IBS::Assign(const ISC_STATUS* vector)
+{
+	Reset();
+	int i = 0;
+	int strings = 0;
+	while (vector[i] != isc_arg_end)
+	{
+		// Arguments are pairs, except for isc_arg_cstring which has 3 items
+		ISC_STATUS type = vector[i];
+		int items = (type == isc_arg_cstring) ? 3 : 2;
+		if (i + items >= 20) break;
+		for (int j = 0; j < items; j++, i++)
+			mVector[i] = vector[i];
+
+		const char* text = (const char*)mVector[i - 1];
+		if (text == 0)
+			continue;
+		if (type == isc_arg_cstring)
+			mStrings[strings].assign(text, (size_t)mVector[i - 2]);
+		else if (type == isc_arg_string || type == isc_arg_interpreted
+			|| type == isc_arg_sql_state)
+			mStrings[strings].assign(text);
+		else
+			continue;
+		mVector[i - 1] = (ISC_STATUS)mStrings[strings++].c_str();
+	}
+	mVector[i] = isc_arg_end;
+}
+
+void ibpp_internals::ThrowStatusError(Firebird::CheckStatusWrapper& status,
+	const std::string& context, const char* message)
+{
+	IBS ibs;
+	ibs.Assign(status.getErrors());
+	status.dispose();
+	throw SQLExceptionImpl(ibs, context, "%s", message);
+}
+
 IBS::IBS()
 {
 	Reset();
@@ -97,5 +138,5 @@ IBS::~IBS()
 
 IBS::IBS(IBS& copied)
 {
-	memcpy(mVector, copied.mVector, sizeof(mVector));
+	Assign(copied.mVector);
 }
@@ -0,0 +1,283 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+using namespace ibpp_internals;
+
+// Size of the buffer holding the messages of an IBatch on the server
+static const unsigned BatchBufferSize = 16 * 1024 * 1024;
+
+//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
+
+void BatchImpl::Add()
+{
+	if (mStatement->mHandle == 0 || mStatement->mHandle != mHandle)
+		throw LogicExceptionImpl("Batch::Add",
+			_("The statement has not been prepared or has been prepared again."));
+	if (mStatement->mInRow == 0)
+		throw LogicExceptionImpl("Batch::Add",
+			_("The statement has no parameters."));
+	if (mStatement->mInRow->MissingValues())
+		throw LogicExceptionImpl("Batch::Add",
+			_("All parameters must be specified."));
+
+	if (! mInitialized)
+		Init();
+
+	if (Full())
+		throw LogicExceptionImpl("Batch::Add",
+			_("The batch buffer is full, Execute() must be called first."));
+
+	if (mBatch != 0)
+	{
+		// The client library queues the message itself
+		mStatement->mInRow->CopyToMessage(&mMessages[0], mOffsets, mNullOffsets);
+		Firebird::IMaster* master = fbIntfClass::getInstance()->mMaster;
+		Firebird::CheckStatusWrapper status(master->getStatus());
+		mBatch->add(&status, 1, &mMessages[0]);
+		if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+			ThrowStatusError(status, "Batch::Add", _("IBatch::add failed."));
+		status.dispose();
+	}
+	else
+	{
+		mMessages.resize((mRows + 1) * mMessageLength);
+		mStatement->mInRow->CopyToMessage(&mMessages[mRows * mMessageLength],
+			mOffsets, mNullOffsets);
+	}
+	++mRows;
+}
+
+int BatchImpl::Execute()
+{
+	mStates.clear();
+	mErrors.clear();
+	if (mRows == 0)
+		return 0;
+	if (mStatement->mHandle == 0 || mStatement->mHandle != mHandle)
+		throw LogicExceptionImpl("Batch::Execute",
+			_("The statement has not been prepared or has been prepared again."));
+
+	int failed = (mBatch != 0) ? ExecuteBatch() : ExecuteRows();
+	mRows = 0;
+	return failed;
+}
+
+void BatchImpl::Cancel()
+{
+	if (mBatch != 0 && mRows > 0)
+	{
+		Firebird::IMaster* master = fbIntfClass::getInstance()->mMaster;
+		Firebird::CheckStatusWrapper status(master->getStatus());
+		mBatch->cancel(&status);
+		status.dispose();
+	}
+	if (mBatch == 0)
+		mMessages.clear();
+	mRows = 0;
+}
+
+int BatchImpl::RowState(int row)
+{
+	if (row < 0 || row >= (int)mStates.size())
+		throw LogicExceptionImpl("Batch::RowState", _("Row index out of range."));
+	return mStates[row];
+}
+
+const std::string& BatchImpl::RowError(int row)
+{
+	if (row < 0 || row >= (int)mErrors.size())
+		throw LogicExceptionImpl("Batch::RowError", _("Row index out of range."));
+	return mErrors[row];
+}
+
+IBPP::Statement BatchImpl::StatementPtr() const
+{
+	return mStatementPtr;
+}
+
+IBPP::IBatch* BatchImpl::AddRef()
+{
+	ASSERTION(mRefCount >= 0);
+	++mRefCount;
+	return this;
+}
+
+void BatchImpl::Release()
+{
+	// Release cannot throw, except in DEBUG builds on assertion
+	ASSERTION(mRefCount >= 0);
+	--mRefCount;
+	try { if (mRefCount <= 0) delete this; }
+		catch (...) { }
+}
+
+//	(((((((( OBJECT INTERNAL METHODS ))))))))
+
+// Creates the Firebird IBatch for the statement. Statements with BLOB or
+// ARRAY parameters, old client libraries and servers before Firebird 4
+// have the rows executed one by one instead.
+void BatchImpl::Init()
+{
+	mInitialized = true;
+	RowImpl* inRow = mStatement->mInRow;
+	bool useBatch = true;
+	for (int i = 0; i < inRow->Self()->sqld; i++)
+	{
+		int type = inRow->Self()->sqlvar[i].sqltype & ~1;
+		if (type == SQL_BLOB || type == SQL_ARRAY)
+			useBatch = false;
+	}
+
+	Firebird::IStatement* statement = 0;
+	if (useBatch)
+		statement = mStatement->StatementInterface();
+	if (statement != 0)
+	{
+		fbIntfClass* fbIntf = fbIntfClass::getInstance();
+		Firebird::CheckStatusWrapper status(fbIntf->mMaster->getStatus());
+		Firebird::IMessageMetadata* meta = mStatement->InputMetadata(statement, &status);
+		Firebird::IXpbBuilder* par = 0;
+		if (meta != 0)
+			par = fbIntf->mUtil->getXpbBuilder(&status, Firebird::IXpbBuilder::BATCH, 0, 0);
+		if (par != 0)
+		{
+			// Execute all rows and report the result of each of them
+			par->insertInt(&status, Firebird::IBatch::TAG_MULTIERROR, 1);
+			par->insertInt(&status, Firebird::IBatch::TAG_RECORD_COUNTS, 1);
+			par->insertInt(&status, Firebird::IBatch::TAG_BUFFER_BYTES_SIZE,
+				BatchBufferSize);
+			if (! (status.getState() & Firebird::IStatus::STATE_ERRORS))
+			{
+				mBatch = statement->createBatch(&status, meta,
+					par->getBufferLength(&status), par->getBuffer(&status));
+			}
+			par->dispose();
+		}
+		if (mBatch != 0 && ! (status.getState() & Firebird::IStatus::STATE_ERRORS))
+		{
+			StatementImpl::MessageOffsets(meta, &status, mOffsets, mNullOffsets);
+			mMessageLength = meta->getMessageLength(&status);
+			mMessages.resize(mMessageLength);
+			// The server stores the messages aligned
+			unsigned alignedLength = meta->getAlignedLength(&status);
+			if (alignedLength > 0)
+				mCapacity = BatchBufferSize / alignedLength;
+		}
+		if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+		{
+			if (mBatch != 0) mBatch->release();
+			mBatch = 0;
+		}
+		if (meta != 0) meta->release();
+		statement->release();
+		status.dispose();
+	}
+
+	if (mBatch == 0)
+		mMessageLength = inRow->MessageLayout(mOffsets, mNullOffsets);
+}
+
+int BatchImpl::ExecuteBatch()
+{
+	Firebird::ITransaction* transaction = mStatement->TransactionInterface();
+	if (transaction == 0)
+		throw LogicExceptionImpl("Batch::Execute",
+			_("The transaction interface is not available."));
+
+	Firebird::IMaster* master = fbIntfClass::getInstance()->mMaster;
+	Firebird::CheckStatusWrapper status(master->getStatus());
+	Firebird::IBatchCompletionState* cs = mBatch->execute(&status, transaction);
+	transaction->release();
+	if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+		ThrowStatusError(status, "Batch::Execute", _("IBatch::execute failed."));
+
+	int failed = 0;
+	unsigned size = cs->getSize(&status);
+	mStates.resize(size);
+	mErrors.resize(size);
+	for (unsigned i = 0; i < size; i++)
+	{
+		mStates[i] = cs->getState(&status, i);
+		if (mStates[i] == Firebird::IBatchCompletionState::EXECUTE_FAILED)
+			++failed;
+	}
+	unsigned pos = cs->findError(&status, 0);
+	while (pos != Firebird::IBatchCompletionState::NO_MORE_ERRORS && pos < size)
+	{
+		Firebird::IStatus* error = master->getStatus();
+		cs->getStatus(&status, error, pos);
+		IBS ibs;
+		ibs.Assign(error->getErrors());
+		mErrors[pos] = ibs.ErrorMessage();
+		error->dispose();
+		pos = cs->findError(&status, pos + 1);
+	}
+	cs->dispose();
+	status.dispose();
+	return failed;
+}
+
+// Without IBatch the queued parameters are copied back to the statement
+int BatchImpl::ExecuteRows()
+{
+	int failed = 0;
+	mStates.resize(mRows);
+	mErrors.resize(mRows);
+	for (int i = 0; i < mRows; i++)
+	{
+		mStatement->mInRow->CopyFromMessage(&mMessages[i * mMessageLength],
+			mOffsets, mNullOffsets);
+		try
+		{
+			mStatement->Execute();
+			mStates[i] = IBPP::brSucceeded;
+		}
+		catch (IBPP::SQLException& e)
+		{
+			mStates[i] = IBPP::brFailed;
+			mErrors[i] = e.what();
+			++failed;
+		}
+	}
+	mMessages.clear();
+	return failed;
+}
+
+BatchImpl::BatchImpl(StatementImpl* statement)
+	: mRefCount(0), mStatementPtr(statement), mStatement(statement),
+	mHandle(statement->GetHandle()), mBatch(0), mInitialized(false),
+	mMessageLength(0), mRows(0), mCapacity(0)
+{
+}
+
+BatchImpl::~BatchImpl()
+{
+	try { if (mBatch != 0) mBatch->release(); }
+		catch (...) { }
+}
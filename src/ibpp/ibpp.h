@@ -557,6 +557,7 @@ public:
     class IStatement;       typedef Ptr<IStatement> Statement;
     class IEvents;          typedef Ptr<IEvents> Events;
     class IRow;             typedef Ptr<IRow> Row;
+    class IBatch;           typedef Ptr<IBatch> Batch;
 
     /* IBlob is the interface to the blob capabilities of IBPP. Blob is the
      * object class you actually use in your programming. In Firebird, at the
@@ -860,6 +861,11 @@ public:
         virtual void CursorExecute(const std::string& cursor, const std::string&) = 0;
         virtual bool Fetch() = 0;
         virtual bool Fetch(Row&) = 0;
+        // Fetches up to count rows in one call into a contiguous buffer and
+        // returns the number of buffered rows, 0 at the end of the result
+        // set. Fetch() makes the buffered rows current one after the other
+        // without calling the server again, their values are read in place.
+        virtual int FetchBatch(int count) = 0;
         virtual int AffectedRows() = 0;
         virtual void Close() = 0;
         virtual std::string& Sql() = 0;
@@ -1000,6 +1006,38 @@ public:
         virtual ~IEvents() { }
     };
 
+    /* IBatch queues many sets of parameters for a prepared statement and
+     * executes them at once. It uses the IBatch interface of Firebird 4 when
+     * the client library and the server support it, and executes the rows
+     * one by one otherwise. Set the parameters on the statement as usual, then
+     * call Add() to queue them. Full() tells when the buffer of the IBatch
+     * can't take another row, Execute() has to be called before the next
+     * Add(). Execute() returns the number of failed rows,
+     * RowState() the number of affected records for each row of the last
+     * Execute(), or one of the BatchRowState values. */
+
+    enum BatchRowState {brFailed = -1, brSucceeded = -2};
+
+    class IBatch
+    {
+    public:
+        virtual void Add() = 0;
+        virtual int Execute() = 0;
+        virtual void Cancel() = 0;      // Drops the queued rows
+        virtual int Rows() = 0;         // Number of queued rows
+        virtual bool Full() = 0;        // No more rows can be queued
+
+        virtual int RowState(int row) = 0;
+        virtual const std::string& RowError(int row) = 0;
+
+        virtual Statement StatementPtr() const = 0;
+
+        virtual IBatch* AddRef() = 0;
+        virtual void Release() = 0;
+
+        virtual ~IBatch() { }
+    };
+
     /* Class EventInterface is merely a pure interface.
      * It is _not_ implemented by IBPP. It is only a base class definition from
      * which your own event interface classes have to derive from.
@@ -1060,6 +1098,8 @@ public:
 
     Events EventsFactory(Database db);
 
+    Batch BatchFactory(Statement st);
+
     /* IBPP uses a self initialization system. Each time an object that may
      * require the usage of the Interbase client C-API library is used, the
      * library internal handling details are automatically initialized, if not
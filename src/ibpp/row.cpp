@@ -1490,8 +1490,115 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 	return value;
 }
 
+// Size of the value of a column in an OO API message, which uses the same
+// layout for the values as the XSQLVAR sqldata buffers
+int RowImpl::MessageDataLength(const XSQLVAR* var)
+{
+	if ((var->sqltype & ~1) == SQL_VARYING)
+		return var->sqllen + 2;
+	return var->sqllen;
+}
+
+// Lays out a message for the descriptor, in the way the OO API aligns the
+// values, and returns its length rounded up to keep consecutive messages
+// aligned as well
+unsigned RowImpl::MessageLayout(std::vector<unsigned>& offsets,
+	std::vector<unsigned>& nullOffsets)
+{
+	offsets.resize(mDescrArea->sqld);
+	nullOffsets.resize(mDescrArea->sqld);
+	unsigned length = 0;
+	for (int i = 0; i < mDescrArea->sqld; i++)
+	{
+		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+		unsigned align;
+		switch (var->sqltype & ~1)
+		{
+			case SQL_TEXT :
+			case SQL_BOOLEAN :	align = 1; break;
+			case SQL_VARYING :	align = 2; break;
+			default :			align = var->sqllen < 8 ? var->sqllen : 8;
+		}
+		length = (length + align - 1) & ~(align - 1);
+		offsets[i] = length;
+		length += MessageDataLength(var);
+		length = (length + 1) & ~1u;
+		nullOffsets[i] = length;
+		length += sizeof(short);
+	}
+	return (length + 7) & ~7u;
+}
+
+void RowImpl::CopyToMessage(char* message, const std::vector<unsigned>& offsets,
+	const std::vector<unsigned>& nullOffsets)
+{
+	for (int i = 0; i < mDescrArea->sqld; i++)
+	{
+		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+		bool isNull = (var->sqltype & 1) && *(var->sqlind) != 0;
+		*(short*)(message + nullOffsets[i]) = isNull ? -1 : 0;
+		if (! isNull)
+			memcpy(message + offsets[i], var->sqldata, MessageDataLength(var));
+	}
+}
+
+void RowImpl::CopyFromMessage(const char* message,
+	const std::vector<unsigned>& offsets, const std::vector<unsigned>& nullOffsets)
+{
+	for (int i = 0; i < mDescrArea->sqld; i++)
+	{
+		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+		bool isNull = *(const short*)(message + nullOffsets[i]) != 0;
+		if (var->sqltype & 1)
+			*(var->sqlind) = isNull ? -1 : 0;
+		if (! isNull)
+			memcpy(var->sqldata, message + offsets[i], MessageDataLength(var));
+		mUpdated[i] = true;
+	}
+}
+
+// Points the variables of the descriptor into the message, so that the
+// values can be read without copying them. The own variables are kept
+// and restored by DetachMessage().
+void RowImpl::AttachMessage(char* message, const std::vector<unsigned>& offsets,
+	const std::vector<unsigned>& nullOffsets)
+{
+	const int n = mDescrArea->sqld;
+	if (mOwnData.empty())
+	{
+		mOwnData.resize(n);
+		mOwnInd.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			mOwnData[i] = mDescrArea->sqlvar[i].sqldata;
+			mOwnInd[i] = mDescrArea->sqlvar[i].sqlind;
+		}
+	}
+	for (int i = 0; i < n; i++)
+	{
+		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+		var->sqldata = message + offsets[i];
+		if (var->sqltype & 1)
+			var->sqlind = (short*)(message + nullOffsets[i]);
+	}
+}
+
+void RowImpl::DetachMessage()
+{
+	if (mOwnData.empty())
+		return;
+	for (size_t i = 0; i < mOwnData.size(); i++)
+	{
+		mDescrArea->sqlvar[i].sqldata = mOwnData[i];
+		mDescrArea->sqlvar[i].sqlind = mOwnInd[i];
+	}
+	mOwnData.clear();
+	mOwnInd.clear();
+}
+
 void RowImpl::Free()
 {
+	DetachMessage();
 	if (mDescrArea != 0)
 	{
 		for (int i = 0; i < mDescrArea->sqln; i++)
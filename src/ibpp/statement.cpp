@@ -271,9 +271,14 @@ void StatementImpl::Execute(const std::string& sql)
 			_("All parameters must be specified."));
 
 	CursorFree();	// Free a previous 'cursor' if any
+	BatchReset();
 
 	IBS status;
-	if (mType == IBPP::stSelect)
+	if (mType == IBPP::stSelect && ResultSetOpen())
+	{
+		mResultSetAvailable = true;
+	}
+	else if (mType == IBPP::stSelect)
 	{
 		// Could return a result set (none, single or multi rows)
 		(*getGDS().Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
@@ -325,6 +330,7 @@ void StatementImpl::CursorExecute(const std::string& cursor, const std::string&
 			_("All parameters must be specified."));
 
 	CursorFree();	// Free a previous 'cursor' if any
+	BatchReset();
 
 	IBS status;
 	(*getGDS().Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
@@ -418,6 +424,18 @@ bool StatementImpl::Fetch()
 		throw LogicExceptionImpl("Statement::Fetch",
 			_("No statement has been executed or no result set available."));
 
+	if (BatchFetching())
+	{
+		// Rows are read in place from the message buffer
+		if (mBatchPos >= mBatchRows && FetchBatch(1) == 0)
+			return false;
+		mOutRow->AttachMessage(&mBatchBuffer[mBatchPos * mBatchMessageLength],
+			mBatchOffsets, mBatchNullOffsets);
+		++mBatchPos;
+		return true;
+	}
+
+	mOutRow->DetachMessage();
 	IBS status;
 	ISC_STATUS code = (*getGDS().Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
 	if (code == 100)	// This special code means "no more rows"
@@ -448,6 +466,18 @@ bool StatementImpl::Fetch(IBPP::Row& row)
 		throw LogicExceptionImpl("Statement::Fetch(row)",
 			_("No statement has been executed or no result set available."));
 
+	if (BatchFetching())
+	{
+		if (! Fetch())
+		{
+			row.clear();
+			return false;
+		}
+		row = new RowImpl(*mOutRow);
+		return true;
+	}
+
+	mOutRow->DetachMessage();
 	RowImpl* rowimpl = new RowImpl(*mOutRow);
 	row = rowimpl;
 
@@ -475,11 +505,103 @@ bool StatementImpl::Fetch(IBPP::Row& row)
 	return true;
 }
 
+int StatementImpl::FetchBatch(int count)
+{
+	if (! mResultSetAvailable)
+		throw LogicExceptionImpl("Statement::FetchBatch",
+			_("No statement has been executed or no result set available."));
+	if (count < 1)
+		throw LogicExceptionImpl("Statement::FetchBatch",
+			_("Count must be > 0."));
+
+	// The messages are moved around, so the current row has to go
+	mOutRow->DetachMessage();
+	if (mBatchOffsets.empty())
+		BatchLayout();
+	if (mBatchEnd && mBatchPos >= mBatchRows)
+	{
+		mResultSetAvailable = false;
+		return 0;
+	}
+
+	// Keep the rows not yet returned by Fetch() at the start of the buffer
+	int buffered = mBatchRows - mBatchPos;
+	if (buffered > 0 && mBatchPos > 0)
+	{
+		memmove(&mBatchBuffer[0], &mBatchBuffer[mBatchPos * mBatchMessageLength],
+			buffered * mBatchMessageLength);
+	}
+	mBatchRows = buffered;
+	mBatchPos = 0;
+	if (mBatchRows >= count || mBatchEnd)
+		return mBatchRows;
+	if (mBatchBuffer.size() < count * mBatchMessageLength)
+		mBatchBuffer.resize(count * mBatchMessageLength);
+
+	if (mResultSet != 0)
+	{
+		Firebird::IMaster* master = fbIntfClass::getInstance()->mMaster;
+		Firebird::CheckStatusWrapper status(master->getStatus());
+		while (mBatchRows < count)
+		{
+			int code = mResultSet->fetchNext(&status,
+				&mBatchBuffer[mBatchRows * mBatchMessageLength]);
+			if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+			{
+				Close();
+				ThrowStatusError(status, "Statement::FetchBatch",
+					_("IResultSet::fetchNext failed."));
+			}
+			if (code != Firebird::IStatus::RESULT_OK)
+			{
+				ResultSetFree();
+				mBatchEnd = true;
+				break;
+			}
+			++mBatchRows;
+		}
+		status.dispose();
+	}
+	else
+	{
+		// No OO API, the rows are copied from the descriptor
+		while (mBatchRows < count)
+		{
+			IBS status;
+			ISC_STATUS code = (*getGDS().Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
+			if (code == 100)	// This special code means "no more rows"
+			{
+				mCursorOpened = true;
+				CursorFree();	// Free the explicit or implicit cursor/result-set
+				mBatchEnd = true;
+				break;
+			}
+			if (status.Errors())
+			{
+				Close();
+				throw SQLExceptionImpl(status, "Statement::FetchBatch",
+					_("isc_dsql_fetch failed."));
+			}
+			mCursorOpened = true;
+			mOutRow->CopyToMessage(&mBatchBuffer[mBatchRows * mBatchMessageLength],
+				mBatchOffsets, mBatchNullOffsets);
+			++mBatchRows;
+		}
+	}
+
+	if (mBatchRows == 0)
+		mResultSetAvailable = false;
+	return mBatchRows;
+}
+
 void StatementImpl::Close()
 {
 	// Free all statement resources.
 	// Used before preparing a new statement or from destructor.
 
+	BatchReset();
+	mBatchOffsets.clear();
+	mBatchNullOffsets.clear();
 	if (mInRow != 0) { mInRow->Release(); mInRow = 0; }
 	if (mOutRow != 0) { mOutRow->Release(); mOutRow = 0; }
 
@@ -1728,6 +1850,191 @@ void StatementImpl::DetachTransactionImpl()
 	mTransaction = 0;
 }
 
+// The OO API interfaces of the legacy handles, 0 if the client library
+// doesn't provide them. The caller has to release() them.
+Firebird::IStatement* StatementImpl::StatementInterface()
+{
+	if (getGDS().Call()->m_get_master_interface == 0
+		|| getGDS().Call()->m_get_statement_interface == 0
+		|| getGDS().Call()->m_get_transaction_interface == 0)
+	{
+		return 0;
+	}
+	IBS status;
+	Firebird::IStatement* statement = 0;
+	(*getGDS().Call()->m_get_statement_interface)(status.Self(), &statement, &mHandle);
+	return status.Errors() ? 0 : statement;
+}
+
+Firebird::ITransaction* StatementImpl::TransactionInterface()
+{
+	IBS status;
+	Firebird::ITransaction* transaction = 0;
+	(*getGDS().Call()->m_get_transaction_interface)(status.Self(), &transaction,
+		mTransaction->GetHandlePtr());
+	return status.Errors() ? 0 : transaction;
+}
+
+// Metadata of the input message, built from the descriptor with all
+// parameters made nullable just like Prepare() does
+Firebird::IMessageMetadata* StatementImpl::InputMetadata(
+	Firebird::IStatement* statement, Firebird::CheckStatusWrapper* status)
+{
+	Firebird::IMessageMetadata* described = statement->getInputMetadata(status);
+	if (status->getState() & Firebird::IStatus::STATE_ERRORS)
+		return 0;
+	Firebird::IMetadataBuilder* builder = described->getBuilder(status);
+	described->release();
+	if (status->getState() & Firebird::IStatus::STATE_ERRORS)
+		return 0;
+	XSQLDA* in = mInRow->Self();
+	for (int i = 0; i < in->sqld; i++)
+	{
+		XSQLVAR* var = &(in->sqlvar[i]);
+		builder->setType(status, i, var->sqltype | 1);
+		builder->setLength(status, i, var->sqllen);
+	}
+	Firebird::IMessageMetadata* meta = builder->getMetadata(status);
+	builder->release();
+	if (status->getState() & Firebird::IStatus::STATE_ERRORS)
+		return 0;
+	return meta;
+}
+
+// Offsets of the values and null indicators in a message
+void StatementImpl::MessageOffsets(Firebird::IMessageMetadata* meta,
+	Firebird::CheckStatusWrapper* status, std::vector<unsigned>& offsets,
+	std::vector<unsigned>& nullOffsets)
+{
+	unsigned count = meta->getCount(status);
+	offsets.resize(count);
+	nullOffsets.resize(count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		offsets[i] = meta->getOffset(status, i);
+		nullOffsets[i] = meta->getNullOffset(status, i);
+	}
+}
+
+// Opens the result set through the OO API, so that FetchBatch() can fetch
+// the rows as messages. Returns false if the client library or the column
+// types don't allow it, the statement is then executed the legacy way.
+bool StatementImpl::ResultSetOpen()
+{
+	if (mOutRow == 0)
+		return false;
+	Firebird::IStatement* statement = StatementInterface();
+	if (statement == 0)
+		return false;
+	Firebird::ITransaction* transaction = TransactionInterface();
+	if (transaction == 0)
+	{
+		statement->release();
+		return false;
+	}
+
+	Firebird::IMaster* master = fbIntfClass::getInstance()->mMaster;
+	Firebird::CheckStatusWrapper status(master->getStatus());
+	Firebird::IMessageMetadata* outMeta = 0;
+	Firebird::IMessageMetadata* inMeta = 0;
+	std::vector<char> inMessage;
+	bool usable = false;
+	do
+	{
+		// The output message has to match the descriptor
+		outMeta = statement->getOutputMetadata(&status);
+		if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+			break;
+		XSQLDA* out = mOutRow->Self();
+		if ((int)outMeta->getCount(&status) != out->sqld)
+			break;
+		int i;
+		for (i = 0; i < out->sqld; i++)
+		{
+			XSQLVAR* var = &(out->sqlvar[i]);
+			if ((outMeta->getType(&status, i) & ~1) != (unsigned)(var->sqltype & ~1)
+				|| (int)outMeta->getLength(&status, i) != var->sqllen)
+			{
+				break;
+			}
+		}
+		if (i < out->sqld)
+			break;
+		MessageOffsets(outMeta, &status, mBatchOffsets, mBatchNullOffsets);
+		// Consecutive messages in the buffer need to stay aligned
+		mBatchMessageLength = (outMeta->getMessageLength(&status) + 7) & ~7u;
+		if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+			break;
+
+		if (mInRow != 0)
+		{
+			inMeta = InputMetadata(statement, &status);
+			if (inMeta == 0)
+				break;
+			std::vector<unsigned> offsets, nullOffsets;
+			MessageOffsets(inMeta, &status, offsets, nullOffsets);
+			inMessage.resize(inMeta->getMessageLength(&status));
+			if (status.getState() & Firebird::IStatus::STATE_ERRORS)
+				break;
+			mInRow->CopyToMessage(&inMessage[0], offsets, nullOffsets);
+		}
+		usable = true;
+	}
+	while (false);
+
+	if (usable)
+	{
+		mResultSet = statement->openCursor(&status, transaction, inMeta,
+			inMessage.empty() ? 0 : &inMessage[0], outMeta, 0);
+	}
+	if (inMeta != 0) inMeta->release();
+	if (outMeta != 0) outMeta->release();
+	transaction->release();
+	statement->release();
+
+	if (usable && (status.getState() & Firebird::IStatus::STATE_ERRORS))
+	{
+		mResultSet = 0;
+		std::string context = "Statement::Execute( ";
+		context.append(mSql).append(" )");
+		ThrowStatusError(status, context, _("IStatement::openCursor failed"));
+	}
+	status.dispose();
+	if (! usable)
+	{
+		mBatchOffsets.clear();
+		mBatchNullOffsets.clear();
+	}
+	return usable;
+}
+
+void StatementImpl::ResultSetFree()
+{
+	if (mResultSet != 0)
+	{
+		// Releasing the last reference closes the cursor as well
+		mResultSet->release();
+		mResultSet = 0;
+	}
+}
+
+// Drops the buffered rows and the result set they were fetched from
+void StatementImpl::BatchReset()
+{
+	ResultSetFree();
+	mBatchRows = 0;
+	mBatchPos = 0;
+	mBatchEnd = false;
+	if (mOutRow != 0) mOutRow->DetachMessage();
+}
+
+// Layout of the messages for rows copied from the descriptor, when the
+// result set was not opened through the OO API
+void StatementImpl::BatchLayout()
+{
+	mBatchMessageLength = mOutRow->MessageLayout(mBatchOffsets, mBatchNullOffsets);
+}
+
 void StatementImpl::CursorFree()
 {
 	if (mCursorOpened)
@@ -1744,10 +2051,19 @@ void StatementImpl::CursorFree()
 	}
 }
 
+// Called when the transaction ended, which closed the cursor on the server
+// already: a DSQL_close would fail with "Attempt to reclose a closed cursor"
+void StatementImpl::CursorClosed()
+{
+	mCursorOpened = false;
+}
+
 StatementImpl::StatementImpl(DatabaseImpl* database, TransactionImpl* transaction)
 	: mRefCount(0), mHandle(0), mDatabase(0), mTransaction(0),
 	mInRow(0), mOutRow(0),
-	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown)
+	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown),
+	mResultSet(0), mBatchMessageLength(0), mBatchRows(0), mBatchPos(0),
+	mBatchEnd(false)
 {
 	AttachDatabaseImpl(database);
 	if (transaction != 0) AttachTransactionImpl(transaction);
@@ -153,11 +153,11 @@ void TransactionImpl::Commit()
         throw SQLExceptionImpl(status, "Transaction::Commit");
     mHandle = 0;    // Should be, better be sure
 
-    /*
+    // The server closed all cursors of the transaction. Statements must
+    // not try to close them again when they are executed the next time.
     size_t i;
     for (i = mStatements.size(); i != 0; i--)
-        mStatements[i-1]->CursorFree();
-    */
+        mStatements[i-1]->CursorClosed();
 }
 
 void TransactionImpl::CommitRetain()
@@ -183,11 +183,11 @@ void TransactionImpl::Rollback()
         throw SQLExceptionImpl(status, "Transaction::Rollback");
     mHandle = 0;    // Should be, better be sure
 
-    /*
+    // The server closed all cursors of the transaction. Statements must
+    // not try to close them again when they are executed the next time.
     size_t i;
     for (i = mStatements.size(); i != 0; i--)
-        mStatements[i-1]->CursorFree();
-    */
+        mStatements[i-1]->CursorClosed();
 }
 
 void TransactionImpl::RollbackRetain()
@@ -32,6 +32,12 @@
 #include <wx/datetime.h>
 #include <wx/file.h>
 #include <wx/filename.h>
+#include <wx/thread.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
 
 #include "config/DatabaseConfig.h"
 #include "core/StringUtils.h"
@@ -41,94 +47,431 @@
 #include "sql/SqlStatement.h"
 #include "metadata/database.h"
 
-bool Logger::log2database(Config *cfg, const SqlStatement& stm, Database* db)
+// LogWriter: appends the log output to the log files and inserts the log
+// entries into the FLAMEROBIN$LOG tables in a background thread, so that
+// logging doesn't delay the execution of statements.
+// Texts queued for the same file while it's busy are written together.
+// The log tables are written on attachments of the thread, with statements
+// prepared only once, and committed whenever the queue has been emptied.
+class LogWriter: public wxThread
 {
-    wxMBConv* conv = db->getCharsetConverter();
+public:
+    struct DatabaseEntry
+    {
+        std::string objectType;     // empty for DML statements
+        std::string objectName;
+        std::string statement;
+    };
+private:
+    struct Job
+    {
+        wxString fileName;          // empty for log table entries
+        wxString text;
+        wxString databaseKey;
+        IBPP::Database database;    // not connected, only used once
+        std::string idSql;
+        std::vector<DatabaseEntry> entries;
+    };
+    std::deque<Job> jobsM;
+    bool stopM;
+    wxMutex mutexM;
+    wxCondition queuedM;
+    wxCondition writtenM;
 
-    IBPP::Transaction tr = IBPP::TransactionFactory(db->getIBPPDatabase());
-    try
+    // attachment of the thread, with its statements prepared
+    struct LogDatabase
+    {
+        IBPP::Database database;
+        IBPP::Transaction transaction;
+        IBPP::Statement statementId;
+        IBPP::Statement statementInsert;
+        int uncommitted;
+    };
+    typedef std::map<wxString, LogDatabase> LogDatabases;
+    LogDatabases databasesM;    // only used by the thread
+
+    void queue(Job& job);
+    void writeJobs(const std::deque<Job>& jobs);
+    void writeDatabaseJob(const Job& job);
+    void commitDatabases();
+    void closeDatabases();
+protected:
+    virtual ExitCode Entry();
+public:
+    LogWriter();
+
+    void write(const wxString& fileName, const wxString& text);
+    // databaseKey identifies the attachment the entries are inserted with,
+    // database is a clone of the database that is used to create it, it's
+    // handed over to the thread and cleared
+    void write(const wxString& databaseKey, IBPP::Database& database,
+        const std::string& idSql, const std::vector<DatabaseEntry>& entries);
+    // writes all queued texts and entries and ends the thread
+    void stop();
+};
+
+// the queue is only full if writing blocks, otherwise it's emptied
+// with every batch of statements logged
+static const size_t maxQueuedLogJobs = 256;
+// the log tables are committed every so many entries when a large number
+// of statements is logged at once
+static const int logCommitInterval = 1000;
+// attachments are closed when nothing has been logged for a while
+static const long logDatabaseIdleMs = 10000;
+
+static void showLogDatabaseWarning(const wxString& message)
+{
+    wxTheApp->CallAfter([message]()
+    {
+        showWarningDialog(0, _("Logging to database failed"), message,
+            AdvancedMessageDialogButtonsOk());
+    });
+}
+
+LogWriter::LogWriter()
+    : wxThread(wxTHREAD_JOINABLE), stopM(false), queuedM(mutexM),
+        writtenM(mutexM)
+{
+}
+
+void LogWriter::queue(Job& job)
+{
+    wxMutexLocker lock(mutexM);
+    while (jobsM.size() >= maxQueuedLogJobs)
+        writtenM.Wait();
+    jobsM.push_back(job);
+    // the reference count of IBPP objects isn't thread-safe, the queued
+    // job must hold the only reference
+    job.database.clear();
+    queuedM.Signal();
+}
+
+void LogWriter::write(const wxString& fileName, const wxString& text)
+{
+    Job job;
+    job.fileName = fileName;
+    job.text = text;
+    queue(job);
+}
+
+void LogWriter::write(const wxString& databaseKey, IBPP::Database& database,
+    const std::string& idSql, const std::vector<DatabaseEntry>& entries)
+{
+    Job job;
+    job.databaseKey = databaseKey;
+    job.database = database;
+    database.clear();
+    job.idSql = idSql;
+    job.entries = entries;
+    queue(job);
+}
+
+void LogWriter::stop()
+{
     {
-        tr->Start();
-        IBPP::Statement st = IBPP::StatementFactory(db->getIBPPDatabase(), tr);
+        wxMutexLocker lock(mutexM);
+        stopM = true;
+        queuedM.Signal();
+    }
+    Wait();
+}
 
-        // find next id
-        wxString sql = "SELECT gen_id(FLAMEROBIN$LOG_GEN, 1) FROM rdb$database";
-        if (cfg->get("LoggingUsesCustomSelect", false))
+wxThread::ExitCode LogWriter::Entry()
+{
+    while (true)
+    {
+        std::deque<Job> jobs;
         {
-            sql = cfg->get("LoggingCustomSelect",
-                wxString("SELECT 1+MAX(ID) FROM FLAMEROBIN$LOG"));
+            wxMutexLocker lock(mutexM);
+            bool idle = false;
+            while (jobsM.empty() && !stopM && !idle)
+            {
+                if (databasesM.empty())
+                    queuedM.Wait();
+                else
+                {
+                    idle = (queuedM.WaitTimeout(logDatabaseIdleMs)
+                        == wxCOND_TIMEOUT);
+                }
+            }
+            // remaining jobs are written before the thread ends
+            if (jobsM.empty() && stopM)
+                break;
+            jobs.swap(jobsM);
+            writtenM.Broadcast();
         }
-        st->Prepare(wx2std(sql, conv));
-        st->Execute();
-        int cnt = 1;
-        if (st->Fetch() && !st->IsNull(1))
-            st->Get(1, cnt);
-
-        st->Prepare("INSERT INTO FLAMEROBIN$LOG (id, object_type, \
-            object_name, sql_statement) values (?,?,?,?)");
-        st->Set(1, cnt);
-        if (stm.isDDL())
+        if (jobs.empty())
+            closeDatabases();
+        else
         {
-            st->Set(2, wx2std(getNameOfType(stm.getObjectType()), conv));
-            st->Set(3, wx2std(stm.getName(), conv));
+            writeJobs(jobs);
+            commitDatabases();
         }
-        else
+    }
+    closeDatabases();
+    return 0;
+}
+
+void LogWriter::writeJobs(const std::deque<Job>& jobs)
+{
+    std::deque<Job>::const_iterator it = jobs.begin();
+    while (it != jobs.end())
+    {
+        if ((*it).fileName.empty())
         {
-            st->SetNull(2);
-            st->SetNull(3);
+            writeDatabaseJob(*it);
+            ++it;
+            continue;
+        }
+
+        // open each file only once for consecutive texts
+        wxString fileName((*it).fileName);
+        wxString text;
+        for (; it != jobs.end() && (*it).fileName == fileName; ++it)
+            text += (*it).text;
+
+        wxFile f;
+        if (!f.Open(fileName, wxFile::write_append) || !f.Write(text))
+        {
+            wxTheApp->CallAfter([fileName]()
+            {
+                showWarningDialog(0, _("Logging to file failed"),
+                    wxString::Format(_("Cannot write to log file %s."),
+                        fileName.c_str()),
+                    AdvancedMessageDialogButtonsOk());
+            });
         }
-        IBPP::Blob bl = IBPP::BlobFactory(st->DatabasePtr(), tr);
-        bl->Save(wx2std(stm.getStatement(), conv));
-        st->Set(4, bl);
-        st->Execute();
-        tr->Commit();
-        return true;
     }
-    catch (IBPP::Exception &e)
+}
+
+void LogWriter::writeDatabaseJob(const Job& job)
+{
+    try
     {
-        showWarningDialog(0, _("Logging to database failed"),
-            wxString(e.what(), *conv), AdvancedMessageDialogButtonsOk());
+        LogDatabases::iterator it = databasesM.find(job.databaseKey);
+        if (it == databasesM.end())
+        {
+            LogDatabase ld;
+            ld.database = job.database;
+            ld.database->Connect();
+            ld.transaction = IBPP::TransactionFactory(ld.database);
+            ld.transaction->Start();
+            ld.statementId = IBPP::StatementFactory(ld.database,
+                ld.transaction);
+            ld.statementId->Prepare(job.idSql);
+            ld.statementInsert = IBPP::StatementFactory(ld.database,
+                ld.transaction);
+            ld.statementInsert->Prepare("INSERT INTO FLAMEROBIN$LOG (id, \
+                object_type, object_name, sql_statement) values (?,?,?,?)");
+            ld.uncommitted = 0;
+            it = databasesM.insert(std::make_pair(job.databaseKey, ld)).first;
+        }
+
+        LogDatabase& ld = (*it).second;
+        if (!ld.transaction->Started())
+            ld.transaction->Start();
+        for (std::vector<DatabaseEntry>::const_iterator e =
+            job.entries.begin(); e != job.entries.end(); ++e)
+        {
+            // find next id
+            ld.statementId->Execute();
+            int id = 1;
+            if (ld.statementId->Fetch() && !ld.statementId->IsNull(1))
+                ld.statementId->Get(1, id);
+
+            IBPP::Statement& st = ld.statementInsert;
+            st->Set(1, id);
+            if ((*e).objectType.empty())
+            {
+                st->SetNull(2);
+                st->SetNull(3);
+            }
+            else
+            {
+                st->Set(2, (*e).objectType);
+                st->Set(3, (*e).objectName);
+            }
+            IBPP::Blob bl = IBPP::BlobFactory(ld.database, ld.transaction);
+            bl->Save((*e).statement);
+            st->Set(4, bl);
+            st->Execute();
+            if (++ld.uncommitted >= logCommitInterval)
+            {
+                ld.transaction->Commit();
+                ld.transaction->Start();
+                ld.uncommitted = 0;
+            }
+        }
+    }
+    catch (IBPP::Exception& e)
+    {
+        // the next entries are logged with a new attachment
+        databasesM.erase(job.databaseKey);
+        showLogDatabaseWarning(e.what());
     }
     catch (...)
     {
-        showWarningDialog(0, _("Logging to database failed"),
-            _("Unexpected C++ exception"), AdvancedMessageDialogButtonsOk());
+        databasesM.erase(job.databaseKey);
+        showLogDatabaseWarning(_("Unexpected C++ exception"));
     }
-    return false;
 }
 
-bool Logger::log2file(Config *cfg, const SqlStatement& st,
-    Database *db, const wxString& filename)
+void LogWriter::commitDatabases()
+{
+    LogDatabases::iterator it = databasesM.begin();
+    while (it != databasesM.end())
+    {
+        try
+        {
+            if ((*it).second.transaction->Started())
+                (*it).second.transaction->Commit();
+            (*it).second.uncommitted = 0;
+            ++it;
+        }
+        catch (IBPP::Exception& e)
+        {
+            it = databasesM.erase(it);
+            showLogDatabaseWarning(e.what());
+        }
+    }
+}
+
+void LogWriter::closeDatabases()
+{
+    commitDatabases();
+    for (LogDatabases::iterator it = databasesM.begin();
+        it != databasesM.end(); ++it)
+    {
+        try
+        {
+            (*it).second.database->Disconnect();
+        }
+        catch (IBPP::Exception&)
+        {
+        }
+    }
+    databasesM.clear();
+}
+
+static LogWriter* logWriter = 0;
+
+static LogWriter& getLogWriter()
+{
+    if (!logWriter)
+    {
+        logWriter = new LogWriter();
+        logWriter->Run();
+    }
+    return *logWriter;
+}
+
+bool Logger::log2database(Config *cfg,
+    const std::vector<const SqlStatement*>& statements, Database* db)
+{
+    // the texts are converted here, the charset converter of the database
+    // must not be used by the writer thread
+    wxMBConv* conv = db->getCharsetConverter();
+    wxString sql = "SELECT gen_id(FLAMEROBIN$LOG_GEN, 1) FROM rdb$database";
+    if (cfg->get("LoggingUsesCustomSelect", false))
+    {
+        sql = cfg->get("LoggingCustomSelect",
+            wxString("SELECT 1+MAX(ID) FROM FLAMEROBIN$LOG"));
+    }
+    std::string idSql(wx2std(sql, conv));
+
+    std::vector<LogWriter::DatabaseEntry> entries;
+    entries.reserve(statements.size());
+    for (std::vector<const SqlStatement*>::const_iterator it =
+        statements.begin(); it != statements.end(); ++it)
+    {
+        const SqlStatement& stm = *(*it);
+        LogWriter::DatabaseEntry entry;
+        if (stm.isDDL())
+        {
+            entry.objectType = wx2std(getNameOfType(stm.getObjectType()),
+                conv);
+            entry.objectName = wx2std(stm.getName(), conv);
+        }
+        entry.statement = wx2std(stm.getStatement(), conv);
+        entries.push_back(entry);
+    }
+
+    // every database and id statement gets its own attachment
+    IBPP::Database clone = db->getIBPPDatabase()->Clone();
+    getLogWriter().write(db->getId() + "\n" + sql, clone, idSql, entries);
+    return true;
+}
+
+bool Logger::log2file(Config *cfg,
+    const std::vector<const SqlStatement*>& statements, Database *db,
+    const wxString& filename)
 {
     enum { singleFile=0, multiFile };
     int logToFileType;
     cfg->getValue("LogToFileType", logToFileType);
-
-    wxString sql = st.getStatement();
     bool logSetTerm = false;
     cfg->getValue("LogSetTerm", logSetTerm);
-    // add term. to statement if missing
-    if (logToFileType == singleFile || (logSetTerm && st.getTerminator() != ";"))
+    bool loggingAddHeader = true;
+    cfg->getValue("LoggingAddHeader", loggingAddHeader);
+    int start = 1;
+    cfg->getValue("IncrementalLogFileStart", start);
+
+    // filename should contain stuff like: %d, %02d, %05d, etc.
+    if (logToFileType == multiFile
+        && filename.find_last_of("%") == wxString::npos) // % not found
     {
-        sql.Trim();
-        wxString::size_type pos = sql.rfind(st.getTerminator());
-        if (pos == wxString::npos || pos < sql.length() - st.getTerminator().length())
-            sql += st.getTerminator();
+        showWarningDialog(0, _("Logging to file failed"),
+            _("Multiple file option selected, but path string does not contain the % character"),
+            AdvancedMessageDialogButtonsOk());
+        return false;
     }
 
-    wxFile f;
-    if (logToFileType == multiFile)
-    {   // filename should contain stuff like: %d, %02d, %05d, etc.
-        if (filename.find_last_of("%") == wxString::npos) // % not found
+    wxString header;
+    if (loggingAddHeader)
+    {
+        header = wxString::Format(
+            _("\n/* Logged by FlameRobin %d.%d.%d at %s\n   User: %s    Database: %s */\n"),
+            FR_VERSION_MAJOR, FR_VERSION_MINOR, FR_VERSION_RLS,
+            wxDateTime::Now().Format().c_str(),
+            db->getUsername().c_str(),
+            db->getPath().c_str()
+        );
+    }
+    else
+        header = "\n";
+
+    wxString text;
+    for (std::vector<const SqlStatement*>::const_iterator it =
+        statements.begin(); it != statements.end(); ++it)
+    {
+        const SqlStatement& st = *(*it);
+        wxString sql = st.getStatement();
+        // add term. to statement if missing
+        if (logToFileType == singleFile || (logSetTerm && st.getTerminator() != ";"))
         {
-            showWarningDialog(0, _("Logging to file failed"),
-                _("Multiple file option selected, but path string does not contain the % character"),
-                AdvancedMessageDialogButtonsOk());
-            return false;
+            sql.Trim();
+            wxString::size_type pos = sql.rfind(st.getTerminator());
+            if (pos == wxString::npos || pos < sql.length() - st.getTerminator().length())
+                sql += st.getTerminator();
+        }
+
+        wxString entry(header);
+        if (logSetTerm && st.getTerminator() != ";")
+            entry += "SET TERM " + st.getTerminator() + " ;\n";
+        entry += sql;
+        if (logSetTerm && st.getTerminator() != ";")
+            entry += "\nSET TERM ; " + st.getTerminator() + "\n";
+
+        if (logToFileType != multiFile)
+        {
+            text += entry;
+            continue;
         }
+
+        // create the next free file, so that its name is taken until the
+        // writer thread has written the statement to it
         wxString test;
-        int start = 1;
-        cfg->getValue("IncrementalLogFileStart", start);
+        wxFile f;
         for (int i=start; i < 100000; ++i) // dummy test for 100000
         {
             test.Printf(filename, i);
@@ -154,51 +497,47 @@ bool Logger::log2file(Config *cfg, const SqlStatement& st,
                 _("Cannot open log file."), AdvancedMessageDialogButtonsOk());
             return false;
         }
-    }
-    else if (!f.Open(filename, wxFile::write_append )) // cannot open
-    {
-        showWarningDialog(0, _("Logging to file failed"),
-            _("Cannot open log file for writing."),
-            AdvancedMessageDialogButtonsOk());
-        return false;
+        f.Close();
+        getLogWriter().write(test, entry);
     }
 
-    bool loggingAddHeader = true;
-    cfg->getValue("LoggingAddHeader", loggingAddHeader);
-    if (loggingAddHeader)
-    {
-        wxString header = wxString::Format(
-            _("\n/* Logged by FlameRobin %d.%d.%d at %s\n   User: %s    Database: %s */\n"),
-            FR_VERSION_MAJOR, FR_VERSION_MINOR, FR_VERSION_RLS,
-            wxDateTime::Now().Format().c_str(),
-            db->getUsername().c_str(),
-            db->getPath().c_str()
-        );
-        f.Write(header);
-    }
-    else
-        f.Write("\n");
-    if (logSetTerm && st.getTerminator() != ";")
-        f.Write("SET TERM " + st.getTerminator() + " ;\n");
-    f.Write(sql);
-    if (logSetTerm && st.getTerminator() != ";")
-        f.Write("\nSET TERM ; " + st.getTerminator() + "\n");
-    f.Close();
+    if (!text.empty())
+        getLogWriter().write(filename, text);
     return true;
 }
 
 bool Logger::logStatement(const SqlStatement& st, Database* db)
 {
+    return logStatements(std::vector<SqlStatement>(1, st), db);
+}
+
+bool Logger::logStatements(const std::vector<SqlStatement>& statements,
+    Database* db)
+{
+    if (statements.empty())
+        return true;
     DatabaseConfig dc(db, config());
-    bool result = logStatementByConfig(&dc, st, db);
+    bool result = logStatementsByConfig(&dc, statements, db);
     if (!dc.get("ExcludeFromGlobalLogging", false))
     {
         Config& globalConfig = config();
-        result = result && logStatementByConfig(&globalConfig, st, db);
+        result = result && logStatementsByConfig(&globalConfig, statements,
+            db);
     }
     return result;
 }
 
+/*static*/
+void Logger::shutdown()
+{
+    if (logWriter)
+    {
+        logWriter->stop();
+        delete logWriter;
+        logWriter = 0;
+    }
+}
+
 bool Logger::prepareDatabase(Database *db)
 {
     IBPP::Transaction tr = IBPP::TransactionFactory(db->getIBPPDatabase());
@@ -246,12 +585,19 @@ bool Logger::prepareDatabase(Database *db)
     return false;
 }
 
-bool Logger::logStatementByConfig(Config* cfg, const SqlStatement& st,
-    Database *db)
+bool Logger::logStatementsByConfig(Config* cfg,
+    const std::vector<SqlStatement>& statements, Database *db)
 {
     bool logDML = false;
     cfg->getValue("LogDML", logDML);
-    if (!logDML && !st.isDDL())    // logging not needed
+    std::vector<const SqlStatement*> logged;
+    for (std::vector<SqlStatement>::const_iterator it = statements.begin();
+        it != statements.end(); ++it)
+    {
+        if (logDML || (*it).isDDL())
+            logged.push_back(&(*it));
+    }
+    if (logged.empty())    // logging not needed
         return true;
 
     bool logToFile = false;
@@ -268,7 +614,7 @@ bool Logger::logStatementByConfig(Config* cfg, const SqlStatement& st,
             );
             return false;
         }
-        return log2file(cfg, st, db, logFilename);
+        return log2file(cfg, logged, db, logFilename);
     }
     bool logToDb = false;
     cfg->getValue("LogToDatabase", logToDb);
@@ -276,8 +622,7 @@ bool Logger::logStatementByConfig(Config* cfg, const SqlStatement& st,
     {
         if (!prepareDatabase(db))
             return false;
-        return log2database(cfg, st, db);            // <- log it
+        return log2database(cfg, logged, db);            // <- log it
     }
     return true;
 }
-
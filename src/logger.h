@@ -27,6 +27,9 @@
 // Functions used to log successfully executed statements
 // in database or textual files
 #include <ibpp.h>
+
+#include <vector>
+
 class SqlStatement;
 
 class Database;
@@ -36,11 +39,21 @@ class Logger            // maybe we'll extend this later
 {
 private:
     static bool prepareDatabase(Database *db);
-    static bool log2database(Config *, const SqlStatement& st, Database *db);
-    static bool log2file(Config *, const SqlStatement& st, Database *db, const wxString& filename);
-    static bool logStatementByConfig(Config *cfg, const SqlStatement& st, Database *db);
+    static bool log2database(Config *,
+        const std::vector<const SqlStatement*>& statements, Database *db);
+    static bool log2file(Config *,
+        const std::vector<const SqlStatement*>& statements, Database *db,
+        const wxString& filename);
+    static bool logStatementsByConfig(Config *cfg,
+        const std::vector<SqlStatement>& statements, Database *db);
 public:
     static bool logStatement(const SqlStatement& st, Database *db);
+    // logs all statements at once, log files and log tables are written
+    // by a background thread
+    static bool logStatements(const std::vector<SqlStatement>& statements,
+        Database *db);
+    // writes all pending log output, needs to be called before exit
+    static void shutdown();
 };
 
 #endif
@@ -40,6 +40,7 @@
 #include "core/FRError.h"
 #include "core/StringUtils.h"
 #include "gui/MainFrame.h"
+#include "logger.h"
 #include "main.h"
 
 IMPLEMENT_APP(Application)
@@ -131,6 +132,7 @@ void Application::HandleEvent(wxEvtHandler* handler, wxEventFunction func,
 
 int Application::OnExit()
 {
+    Logger::shutdown();
     return 0;
 }
 
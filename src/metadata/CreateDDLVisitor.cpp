@@ -31,8 +31,13 @@
     #include "wx/wx.h"
 #endif
 
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+
 #include <vector>
 
+#include "core/FRError.h"
 #include "core/ProgressIndicator.h"
 #include "metadata/MetadataContainer.h"
 #include "metadata/column.h"
@@ -102,7 +107,7 @@ wxString CreateDDLVisitor::getCommentOn(MetadataItem& object)
 }
 
 CreateDDLVisitor::CreateDDLVisitor(ProgressIndicator* progressIndicator)
-    : MetadataItemVisitor()
+    : MetadataItemVisitor(), preFileM(0), postFileM(0), grantFileM(0)
 {
     progressIndicatorM = progressIndicator;
 }
@@ -126,6 +131,130 @@ wxString CreateDDLVisitor::getSuffixSql() const
     return postSqlM + grantSqlM;
 }
 
+const DDLPhaseTimings& CreateDDLVisitor::getPhaseTimings() const
+{
+    return phaseTimingsM;
+}
+
+static void writeSection(wxFFile& file, const wxString& sql)
+{
+    if (sql.empty())
+        return;
+    wxScopedCharBuffer buf(sql.utf8_str());
+    if (file.Write(buf.data(), buf.length()) != buf.length())
+        throw FRError(_("Cannot write to destination file."));
+}
+
+static void appendFile(wxFFile& file, wxFFile& source)
+{
+    if (!source.Flush() || !source.Seek(0))
+        throw FRError(_("Cannot read temporary file."));
+    char buf[64 * 1024];
+    while (!source.Eof())
+    {
+        size_t len = source.Read(buf, sizeof(buf));
+        if (source.Error())
+            throw FRError(_("Cannot read temporary file."));
+        if (len == 0)
+            break;
+        if (file.Write(buf, len) != len)
+            throw FRError(_("Cannot write to destination file."));
+    }
+}
+
+void CreateDDLVisitor::appendPreSql(const wxString& sql)
+{
+    if (preFileM)
+        writeSection(*preFileM, sql);
+    else
+        preSqlM += sql;
+}
+
+// the objects of a database are each visited by their own visitor, so the
+// sections collected so far don't need to be copied for every object
+void CreateDDLVisitor::appendSections(const CreateDDLVisitor& objectVisitor)
+{
+    if (preFileM)
+    {
+        writeSection(*preFileM, objectVisitor.preSqlM);
+        writeSection(*postFileM, objectVisitor.postSqlM);
+        writeSection(*grantFileM, objectVisitor.grantSqlM);
+    }
+    else
+    {
+        preSqlM += objectVisitor.preSqlM;
+        postSqlM += objectVisitor.postSqlM;
+        grantSqlM += objectVisitor.grantSqlM;
+    }
+}
+
+// the statements that go after the object definitions (constraints, indices,
+// comments, routine bodies) and the grants are spooled to temporary files
+// and appended to the output at the end
+bool CreateDDLVisitor::writeDatabaseDDL(Database& database, wxFFile& output)
+{
+    wxFFile postFile, grantFile;
+    wxString postFileName(wxFileName::CreateTempFileName("frddl", &postFile));
+    wxString grantFileName(wxFileName::CreateTempFileName("frddl", &grantFile));
+    if (postFileName.empty() || grantFileName.empty())
+    {
+        if (!postFileName.empty())
+            wxRemoveFile(postFileName);
+        if (!grantFileName.empty())
+            wxRemoveFile(grantFileName);
+        throw FRError(_("Cannot create temporary file."));
+    }
+
+    preFileM = &output;
+    postFileM = &postFile;
+    grantFileM = &grantFile;
+    bool completed = false;
+    try
+    {
+        visitDatabase(database);
+        completed = !progressIndicatorM || !progressIndicatorM->isCanceled();
+    }
+    catch (...)
+    {
+        preFileM = postFileM = grantFileM = 0;
+        postFile.Close();
+        grantFile.Close();
+        wxRemoveFile(postFileName);
+        wxRemoveFile(grantFileName);
+        throw;
+    }
+    preFileM = postFileM = grantFileM = 0;
+    postFile.Close();
+    grantFile.Close();
+    wxRemoveFile(postFileName);
+    wxRemoveFile(grantFileName);
+    return completed;
+}
+
+bool CreateDDLVisitor::writeDDL(MetadataItem& item, const wxString& fileName)
+{
+    wxFFile output(fileName, "wb");
+    if (!output.IsOpened())
+        throw FRError(_("Cannot open destination file."));
+
+    bool completed;
+    if (Database* db = dynamic_cast<Database*>(&item))
+        completed = writeDatabaseDDL(*db, output);
+    else
+    {
+        item.acceptVisitor(this);
+        completed = !progressIndicatorM || !progressIndicatorM->isCanceled();
+        if (completed)
+            writeSection(output, sqlM);
+    }
+    if (!output.Close())
+        throw FRError(_("Cannot write to destination file."));
+    // don't leave an incomplete script behind
+    if (!completed)
+        wxRemoveFile(fileName);
+    return completed;
+}
+
 void CreateDDLVisitor::visitCollation(Collation& collation)
 {
     preSqlM += "CREATE COLLATION "  + collation.getName_() + " \n" +
@@ -192,7 +321,10 @@ void CreateDDLVisitor::iterateit(C mc)
 {
     //wxASSERT(mc);
     if (mc) {
-        preSqlM << "/********************* "<< mc->getName_().Upper() <<" **********************/ \n\n";
+        wxStopWatch sw;
+        wxString header;
+        header << "/********************* "<< mc->getName_().Upper() <<" **********************/ \n\n";
+        appendPreSql(header);
         if (progressIndicatorM)
         {
             progressIndicatorM->setProgressMessage(_("Extracting ") + mc->getName_());
@@ -209,8 +341,11 @@ void CreateDDLVisitor::iterateit(C mc)
                 progressIndicatorM->setProgressMessage(_("Extracting ") + (*it)->getName_(), 2);
                 progressIndicatorM->stepProgress(1, 2);
             }
-            (*it)->acceptVisitor(this);
+            CreateDDLVisitor objectVisitor(0);
+            (*it)->acceptVisitor(&objectVisitor);
+            appendSections(objectVisitor);
         }
+        phaseTimingsM.push_back(std::make_pair(mc->getName_(), sw.Time()));
     }
 }
 
@@ -219,6 +354,7 @@ void CreateDDLVisitor::visitDatabase(Database& d)
 {
     if (progressIndicatorM)
         progressIndicatorM->initProgress(wxEmptyString, 10, 0, 1);
+    phaseTimingsM.clear();
 
     try
     {
@@ -273,7 +409,16 @@ void CreateDDLVisitor::visitDatabase(Database& d)
         return;
     }
 
-    sqlM = preSqlM + "\n" + postSqlM + grantSqlM;
+    if (preFileM)
+    {
+        wxStopWatch sw;
+        writeSection(*preFileM, "\n");
+        appendFile(*preFileM, *postFileM);
+        appendFile(*preFileM, *grantFileM);
+        phaseTimingsM.push_back(std::make_pair(_("Writing"), sw.Time()));
+    }
+    else
+        sqlM = preSqlM + "\n" + postSqlM + grantSqlM;
     if (progressIndicatorM)
     {
         progressIndicatorM->initProgress(_("Extraction complete."), 1, 1);
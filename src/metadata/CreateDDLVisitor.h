@@ -25,10 +25,16 @@
 #ifndef FR_CREATEDDLVISITOR_H
 #define FR_CREATEDDLVISITOR_H
 
+#include <utility>
+#include <vector>
+
 #include "sql/SqlTokenizer.h"
 #include "metadata/MetadataItemVisitor.h"
 
 class ProgressIndicator;
+class wxFFile;
+
+typedef std::vector<std::pair<wxString, long> > DDLPhaseTimings;
 
 class CreateDDLVisitor: public MetadataItemVisitor
 {
@@ -41,6 +47,17 @@ private:
 
     ProgressIndicator* progressIndicatorM;
 
+    // set by writeDDL() for a database: the sections are written to these
+    // files as the objects are extracted instead of being kept in memory
+    wxFFile* preFileM;
+    wxFFile* postFileM;
+    wxFFile* grantFileM;
+    DDLPhaseTimings phaseTimingsM;
+
+    void appendPreSql(const wxString& sql);
+    void appendSections(const CreateDDLVisitor& objectVisitor);
+    bool writeDatabaseDDL(Database& database, wxFFile& output);
+
 protected:
     wxString getCommentOn(MetadataItem& metadataitem);
     template <class C, class M>
@@ -54,6 +71,14 @@ public:
     wxString getPrefixSql() const;
     wxString getSuffixSql() const;
 
+    // writes the DDL of item to fileName, for a database the script is
+    // streamed to the file while it is extracted; returns false if the
+    // extraction has been canceled
+    bool writeDDL(MetadataItem& item, const wxString& fileName);
+    // time in milliseconds spent on each collection of the last database
+    // extraction
+    const DDLPhaseTimings& getPhaseTimings() const;
+
     virtual void visitCollation(Collation& collation);
     virtual void visitColumn(Column& column);
     virtual void visitDatabase(Database& database);
@@ -0,0 +1,424 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/file.h>
+#include <wx/filename.h>
+
+#include <cstdint>
+
+#include "metadata/MetadataCache.h"
+
+// file layout, all integers are stored little endian, all strings as
+// uint32 byte length followed by the UTF-8 encoded characters:
+//   "FRMDC002"
+//   string     database key
+//   string     change marker
+//   uint32     number of statements, for each:
+//     string   statement
+//     uint32   number of names, followed by the names
+//   uint32     number of relations, for each:
+//     string   relation name
+//     string   relation version
+//     uint32   number of columns, for each:
+//       string name, source, computed source, collation, default source,
+//              identity type
+//       uint8  flags (1 = nullable, 2 = has default, 4 = has description)
+//       int32  initial value, increment value
+static const char cacheFileMagic[] = "FRMDC002";
+static const size_t cacheFileMagicLen = 8;
+
+class CacheFileWriter
+{
+private:
+    std::string bufferM;
+public:
+    const std::string& getBuffer() const { return bufferM; }
+    void writeRaw(const char* data, size_t len)
+    {
+        bufferM.append(data, len);
+    }
+    void writeUInt32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            bufferM += char((value >> (8 * i)) & 0xFF);
+    }
+    void writeInt32(int value)
+    {
+        writeUInt32(static_cast<uint32_t>(value));
+    }
+    void writeByte(unsigned char value)
+    {
+        bufferM += char(value);
+    }
+    void writeString(const std::string& value)
+    {
+        writeUInt32(uint32_t(value.size()));
+        bufferM += value;
+    }
+    void writeString(const wxString& value)
+    {
+        wxScopedCharBuffer utf8(value.utf8_str());
+        writeUInt32(uint32_t(utf8.length()));
+        bufferM.append(utf8.data(), utf8.length());
+    }
+};
+
+class CacheFileReader
+{
+private:
+    const std::string& bufferM;
+    size_t posM;
+    bool okM;
+
+    bool require(size_t len)
+    {
+        if (okM && bufferM.size() - posM < len)
+            okM = false;
+        return okM;
+    }
+public:
+    CacheFileReader(const std::string& buffer)
+        : bufferM(buffer), posM(0), okM(true)
+    {
+    }
+    bool ok() const { return okM; }
+    bool readMagic()
+    {
+        if (!require(cacheFileMagicLen))
+            return false;
+        okM = bufferM.compare(0, cacheFileMagicLen, cacheFileMagic) == 0;
+        posM += cacheFileMagicLen;
+        return okM;
+    }
+    uint32_t readUInt32()
+    {
+        if (!require(4))
+            return 0;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+            value |= uint32_t((unsigned char)bufferM[posM++]) << (8 * i);
+        return value;
+    }
+    int readInt32()
+    {
+        return static_cast<int>(readUInt32());
+    }
+    unsigned char readByte()
+    {
+        if (!require(1))
+            return 0;
+        return (unsigned char)bufferM[posM++];
+    }
+    std::string readStdString()
+    {
+        uint32_t len = readUInt32();
+        if (!require(len))
+            return std::string();
+        std::string value(bufferM, posM, len);
+        posM += len;
+        return value;
+    }
+    wxString readString()
+    {
+        uint32_t len = readUInt32();
+        if (!require(len))
+            return wxString();
+        wxString value(wxString::FromUTF8(bufferM.data() + posM, len));
+        posM += len;
+        return value;
+    }
+    // guards against allocating huge containers for corrupted files,
+    // every element needs at least minSize bytes in the file
+    uint32_t readCount(size_t minSize)
+    {
+        uint32_t count = readUInt32();
+        if (okM && count > (bufferM.size() - posM) / minSize)
+            okM = false;
+        return okM ? count : 0;
+    }
+};
+
+MetadataCache::MetadataCache()
+    : openM(false), modifiedM(false), identifiersValidM(false)
+{
+}
+
+bool MetadataCache::read(const wxString& fileName,
+    const std::string& databaseKey, std::string& marker)
+{
+    if (!wxFileName::FileExists(fileName))
+        return false;
+    wxFile file(fileName, wxFile::read);
+    if (!file.IsOpened())
+        return false;
+    wxFileOffset len = file.Length();
+    if (len < wxFileOffset(cacheFileMagicLen))
+        return false;
+    std::string buffer(size_t(len), '\0');
+    if (file.Read(&buffer[0], buffer.size()) != ssize_t(buffer.size()))
+        return false;
+
+    CacheFileReader reader(buffer);
+    if (!reader.readMagic() || reader.readStdString() != databaseKey)
+        return false;
+    marker = reader.readStdString();
+
+    std::map<wxString, wxArrayString> identifiers;
+    uint32_t statements = reader.readCount(8);
+    for (uint32_t i = 0; i < statements && reader.ok(); ++i)
+    {
+        wxString statement(reader.readString());
+        wxArrayString& names = identifiers[statement];
+        uint32_t count = reader.readCount(4);
+        names.reserve(count);
+        for (uint32_t j = 0; j < count && reader.ok(); ++j)
+            names.push_back(reader.readString());
+    }
+
+    RelationColumnsMap columns;
+    uint32_t relations = reader.readCount(12);
+    for (uint32_t i = 0; i < relations && reader.ok(); ++i)
+    {
+        wxString relation(reader.readString());
+        RelationColumns& rc = columns[relation];
+        rc.version = reader.readStdString();
+        rc.used = false;
+        uint32_t count = reader.readCount(33);
+        rc.columns.resize(count);
+        for (uint32_t j = 0; j < count && reader.ok(); ++j)
+        {
+            ColumnDefinition& cd = rc.columns[j];
+            cd.name = reader.readString();
+            cd.source = reader.readString();
+            cd.computedSource = reader.readString();
+            cd.collation = reader.readString();
+            cd.defaultSource = reader.readString();
+            cd.identityType = reader.readString();
+            unsigned char flags = reader.readByte();
+            cd.nullable = (flags & 1) != 0;
+            cd.hasDefault = (flags & 2) != 0;
+            cd.hasDescription = (flags & 4) != 0;
+            cd.initialValue = reader.readInt32();
+            cd.incrementValue = reader.readInt32();
+        }
+    }
+    if (!reader.ok())
+        return false;
+
+    identifiersM.swap(identifiers);
+    columnsM.swap(columns);
+    return true;
+}
+
+void MetadataCache::open(const wxString& fileName,
+    const std::string& databaseKey, const std::string& marker,
+    const RelationVersions& versions)
+{
+    close();
+
+    std::string cachedMarker;
+    if (!read(fileName, databaseKey, cachedMarker))
+    {
+        identifiersM.clear();
+        columnsM.clear();
+    }
+    fileNameM = fileName;
+    openM = true;
+    databaseKeyM = databaseKey;
+    markerM = marker;
+    versionsM = versions;
+
+    identifiersValidM = !cachedMarker.empty() && cachedMarker == marker;
+    if (!identifiersValidM)
+    {
+        identifiersM.clear();
+        modifiedM = true;
+    }
+    // drop columns of relations that have been changed or dropped
+    for (RelationColumnsMap::iterator it = columnsM.begin();
+        it != columnsM.end(); )
+    {
+        RelationVersions::const_iterator v = versionsM.find(it->first);
+        if (v == versionsM.end() || v->second != it->second.version)
+        {
+            it = columnsM.erase(it);
+            modifiedM = true;
+        }
+        else
+            ++it;
+    }
+}
+
+void MetadataCache::close()
+{
+    if (openM && modifiedM)
+        save();
+    openM = false;
+    modifiedM = false;
+    identifiersValidM = false;
+    fileNameM.clear();
+    databaseKeyM.clear();
+    markerM.clear();
+    identifiersM.clear();
+    versionsM.clear();
+    columnsM.clear();
+}
+
+void MetadataCache::save()
+{
+    if (!openM || fileNameM.empty())
+        return;
+
+    CacheFileWriter writer;
+    writer.writeRaw(cacheFileMagic, cacheFileMagicLen);
+    writer.writeString(databaseKeyM);
+    writer.writeString(markerM);
+    writer.writeUInt32(uint32_t(identifiersM.size()));
+    for (std::map<wxString, wxArrayString>::const_iterator it =
+        identifiersM.begin(); it != identifiersM.end(); ++it)
+    {
+        writer.writeString(it->first);
+        writer.writeUInt32(uint32_t(it->second.size()));
+        for (size_t i = 0; i < it->second.size(); ++i)
+            writer.writeString(it->second[i]);
+    }
+    writer.writeUInt32(uint32_t(columnsM.size()));
+    for (RelationColumnsMap::const_iterator it = columnsM.begin();
+        it != columnsM.end(); ++it)
+    {
+        writer.writeString(it->first);
+        writer.writeString(it->second.version);
+        writer.writeUInt32(uint32_t(it->second.columns.size()));
+        for (ColumnDefinitions::const_iterator cd =
+            it->second.columns.begin(); cd != it->second.columns.end(); ++cd)
+        {
+            writer.writeString(cd->name);
+            writer.writeString(cd->source);
+            writer.writeString(cd->computedSource);
+            writer.writeString(cd->collation);
+            writer.writeString(cd->defaultSource);
+            writer.writeString(cd->identityType);
+            writer.writeByte((cd->nullable ? 1 : 0)
+                | (cd->hasDefault ? 2 : 0) | (cd->hasDescription ? 4 : 0));
+            writer.writeInt32(cd->initialValue);
+            writer.writeInt32(cd->incrementValue);
+        }
+    }
+
+    // write to a temporary file first, so that a failed write doesn't
+    // leave a truncated snapshot behind
+    wxFileName fn(fileNameM);
+    if (!fn.DirExists())
+        fn.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    wxString tempName(fileNameM + ".tmp");
+    {
+        wxFile file;
+        if (!file.Create(tempName, true))
+            return;
+        const std::string& buffer = writer.getBuffer();
+        bool written = file.Write(buffer.data(), buffer.size())
+            == buffer.size();
+        file.Close();
+        if (!written)
+        {
+            wxRemoveFile(tempName);
+            return;
+        }
+    }
+    if (wxRenameFile(tempName, fileNameM, true))
+        modifiedM = false;
+}
+
+bool MetadataCache::isOpen() const
+{
+    return openM;
+}
+
+bool MetadataCache::findIdentifiers(const wxString& statement,
+    wxArrayString& names)
+{
+    if (!openM || !identifiersValidM)
+        return false;
+    std::map<wxString, wxArrayString>::const_iterator it =
+        identifiersM.find(statement);
+    if (it == identifiersM.end())
+        return false;
+    names = it->second;
+    return true;
+}
+
+void MetadataCache::storeIdentifiers(const wxString& statement,
+    const wxArrayString& names)
+{
+    if (!openM)
+        return;
+    identifiersM[statement] = names;
+    modifiedM = true;
+}
+
+bool MetadataCache::takeColumns(const wxString& relation,
+    ColumnDefinitions& columns)
+{
+    if (!openM)
+        return false;
+    RelationColumnsMap::iterator it = columnsM.find(relation);
+    if (it == columnsM.end() || it->second.used)
+        return false;
+    it->second.used = true;
+    columns = it->second.columns;
+    return true;
+}
+
+void MetadataCache::storeColumns(const wxString& relation,
+    const ColumnDefinitions& columns)
+{
+    if (!openM)
+        return;
+    // relations created after connecting have no known version, they will
+    // be loaded from the database again next time
+    RelationVersions::const_iterator v = versionsM.find(relation);
+    if (v == versionsM.end())
+        return;
+    RelationColumns& rc = columnsM[relation];
+    rc.version = v->second;
+    rc.used = true;
+    rc.columns = columns;
+    modifiedM = true;
+}
+
+void MetadataCache::discardColumns(const wxString& relation)
+{
+    RelationColumnsMap::iterator it = columnsM.find(relation);
+    if (it != columnsM.end())
+        it->second.used = true;
+}
@@ -0,0 +1,124 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef FR_METADATACACHE_H
+#define FR_METADATACACHE_H
+
+#include <wx/arrstr.h>
+#include <wx/hashmap.h>
+#include <wx/string.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// column data as read from rdb$relation_fields, used to create Column
+// objects either from the database or from the metadata cache
+struct ColumnDefinition
+{
+    wxString name;
+    wxString source;
+    wxString computedSource;
+    wxString collation;
+    wxString defaultSource;
+    wxString identityType;
+    bool nullable;
+    bool hasDefault;
+    bool hasDescription;
+    int initialValue;
+    int incrementValue;
+};
+typedef std::vector<ColumnDefinition> ColumnDefinitions;
+
+// Local snapshot of metadata loaded from a database, stored in a compact
+// binary file in the user home path.
+// The snapshot has two parts with different validation:
+// - the results of the statements used to load the metadata collections
+//   (object names), which are valid only if the change marker read from
+//   the server on connect is the same as the one stored with the snapshot
+// - the columns of relations, which are stored together with the version
+//   of the relation (its rdb$relations.rdb$format and a hash over its rows
+//   in rdb$relation_fields and rdb$fields, as comments, defaults and
+//   domain changes don't create a new format), so that only the columns
+//   of relations that have been changed since need to be reloaded
+class MetadataCache
+{
+public:
+    typedef std::unordered_map<wxString, std::string, wxStringHash,
+        wxStringEqual> RelationVersions;
+private:
+    struct RelationColumns
+    {
+        std::string version;
+        bool used;
+        ColumnDefinitions columns;
+    };
+    typedef std::unordered_map<wxString, RelationColumns, wxStringHash,
+        wxStringEqual> RelationColumnsMap;
+
+    wxString fileNameM;
+    bool openM;
+    bool modifiedM;
+
+    std::string databaseKeyM;
+    std::string markerM;
+    bool identifiersValidM;
+    std::map<wxString, wxArrayString> identifiersM;
+
+    RelationVersions versionsM;
+    RelationColumnsMap columnsM;
+
+    bool read(const wxString& fileName, const std::string& databaseKey,
+        std::string& marker);
+public:
+    MetadataCache();
+
+    // reads the snapshot from fileName and drops all parts of it that are
+    // no longer valid for the marker and relation versions read from the
+    // server, snapshot data collected from now on will be saved there
+    // databaseKey identifies the database, a snapshot of another database
+    // (like after the database registration has been changed) is ignored
+    void open(const wxString& fileName, const std::string& databaseKey,
+        const std::string& marker, const RelationVersions& versions);
+    // writes the snapshot if it has been changed, and clears it
+    void close();
+    void save();
+    bool isOpen() const;
+
+    bool findIdentifiers(const wxString& statement, wxArrayString& names);
+    void storeIdentifiers(const wxString& statement,
+        const wxArrayString& names);
+
+    // returns the cached columns of a relation only once, after that the
+    // relation has to be reloaded from the database (for example after a
+    // refresh or after executing DDL statements for it)
+    bool takeColumns(const wxString& relation, ColumnDefinitions& columns);
+    void storeColumns(const wxString& relation,
+        const ColumnDefinitions& columns);
+    // makes sure the columns of the relation are loaded from the database
+    void discardColumns(const wxString& relation);
+};
+
+#endif // FR_METADATACACHE_H
@@ -0,0 +1,312 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "core/ProgressIndicator.h"
+#include "metadata/column.h"
+#include "metadata/CreateDDLVisitor.h"
+#include "metadata/database.h"
+#include "metadata/MetadataSearchIndex.h"
+#include "metadata/parameter.h"
+#include "metadata/procedure.h"
+#include "metadata/relation.h"
+
+static bool isTokenChar(wxChar c)
+{
+    return wxIsalnum(c) || c == '_' || c == '$';
+}
+
+// calls f for every maximal run of identifier characters in text
+template <class F>
+static void forEachToken(const wxString& text, F f)
+{
+    size_t start = 0;
+    const size_t len = text.length();
+    while (start < len)
+    {
+        while (start < len && !isTokenChar(text[start]))
+            ++start;
+        size_t end = start;
+        while (end < len && isTokenChar(text[end]))
+            ++end;
+        if (end > start)
+            f(text.substr(start, end - start));
+        start = end;
+    }
+}
+
+// every text matching pattern contains the longest literal run of identifier
+// characters of pattern, and since tokens are maximal runs of identifier
+// characters that run is always part of a single token
+static wxString getLongestLiteral(const wxString& pattern)
+{
+    wxString longest;
+    forEachToken(pattern, [&longest](const wxString& token)
+    {
+        if (token.length() > longest.length())
+            longest = token;
+    });
+    return longest;
+}
+
+// the change stamp of an item also covers its columns or parameters
+static unsigned long getItemChangeStamp(MetadataItem* item)
+{
+    unsigned long stamp = item->getChangeStamp();
+    std::vector<MetadataItem*> children;
+    item->getChildren(children);
+    for (std::vector<MetadataItem*>::iterator it = children.begin();
+        it != children.end(); ++it)
+    {
+        stamp = std::max(stamp, (*it)->getChangeStamp());
+    }
+    return stamp;
+}
+
+void MetadataSearchIndex::indexAspect(MetadataItem* item, Entry& entry,
+    Aspect aspect)
+{
+    std::vector<wxString>& texts = entry.texts[aspect];
+    switch (aspect)
+    {
+        case aName:
+            texts.push_back(item->getName_().Upper());
+            break;
+        case aDescription:
+        {
+            wxString desc;
+            if (item->getDescription(desc))
+                texts.push_back(desc.Upper());
+            break;
+        }
+        case aDDL:
+        {
+            CreateDDLVisitor cdv;
+            item->acceptVisitor(&cdv);
+            texts.push_back(cdv.getSql().Upper());
+            break;
+        }
+        case aField:
+        {
+            Relation* r = dynamic_cast<Relation*>(item);
+            Procedure* p = dynamic_cast<Procedure*>(item);
+            entry.hasFields = (r || p);
+            if (r)
+            {
+                r->ensureChildrenLoaded();
+                for (ColumnPtrs::iterator it = r->begin(); it != r->end(); ++it)
+                    texts.push_back((*it)->getName_().Upper());
+            }
+            if (p)
+            {
+                p->ensureChildrenLoaded();
+                for (ParameterPtrs::iterator it = p->begin(); it != p->end();
+                    ++it)
+                {
+                    texts.push_back((*it)->getName_().Upper());
+                }
+            }
+            break;
+        }
+        default:
+            return;
+    }
+
+    TokenMap& tokens = tokensM[aspect];
+    for (std::vector<wxString>::iterator it = texts.begin(); it != texts.end();
+        ++it)
+    {
+        forEachToken(*it, [&tokens, item](const wxString& token)
+        {
+            tokens[token].insert(item);
+        });
+    }
+    entry.aspects |= aspectFlag(aspect);
+}
+
+void MetadataSearchIndex::removeEntry(MetadataItem* item, Entry& entry)
+{
+    for (int aspect = 0; aspect < aspectCount; ++aspect)
+    {
+        TokenMap& tokens = tokensM[aspect];
+        std::vector<wxString>& texts = entry.texts[aspect];
+        for (std::vector<wxString>::iterator it = texts.begin();
+            it != texts.end(); ++it)
+        {
+            forEachToken(*it, [&tokens, item](const wxString& token)
+            {
+                TokenMap::iterator ti = tokens.find(token);
+                if (ti == tokens.end())
+                    return;
+                (*ti).second.erase(item);
+                if ((*ti).second.empty())
+                    tokens.erase(ti);
+            });
+        }
+        texts.clear();
+    }
+    entry.aspects = 0;
+    entry.hasFields = false;
+}
+
+void MetadataSearchIndex::update(Database& database, unsigned aspects,
+    const std::set<NodeType>& types, ProgressIndicator* progressIndicator)
+{
+    aspects |= aspectFlag(aName);
+
+    std::vector<MetadataItem*> colls;
+    database.getCollections(colls, false);   // false = not system objects
+    std::vector<MetadataItem*> items;
+    for (std::vector<MetadataItem*>::iterator col = colls.begin();
+        col != colls.end(); ++col)
+    {
+        std::vector<MetadataItem*> children;
+        (*col)->getChildren(children);
+        if (progressIndicator)
+        {
+            progressIndicator->initProgress(_("Indexing ")
+                + (*col)->getName_(), children.size(), 0, 2);
+        }
+        for (std::vector<MetadataItem*>::iterator it = children.begin();
+            it != children.end(); ++it)
+        {
+            if (progressIndicator)
+            {
+                checkProgressIndicatorCanceled(progressIndicator);
+                progressIndicator->stepProgress(1, 2);
+            }
+            items.push_back(*it);
+
+            std::pair<EntryMap::iterator, bool> ins = entriesM.insert(
+                std::make_pair(*it, Entry()));
+            Entry& entry = (*ins.first).second;
+            if (ins.second)
+            {
+                entry.aspects = 0;
+                entry.hasFields = false;
+            }
+            else if (entry.changeStamp != getItemChangeStamp(*it))
+                removeEntry(*it, entry);
+            // objects filtered out by their type can't be search results,
+            // don't load their DDL, descriptions or fields
+            unsigned itemAspects = aspects;
+            if (!types.empty() && types.find((*it)->getType()) == types.end())
+                itemAspects = aspectFlag(aName);
+            if ((entry.aspects & itemAspects) == itemAspects)
+                continue;
+
+            for (int aspect = 0; aspect < aspectCount; ++aspect)
+            {
+                unsigned flag = aspectFlag(Aspect(aspect));
+                if ((itemAspects & flag) && !(entry.aspects & flag))
+                    indexAspect(*it, entry, Aspect(aspect));
+            }
+            // loading the texts can change the stamp, so read it last
+            entry.changeStamp = getItemChangeStamp(*it);
+        }
+    }
+
+    // drop the objects that no longer exist, they are only compared by
+    // their address since the objects may already have been deleted
+    Items current(items.begin(), items.end());
+    for (EntryMap::iterator it = entriesM.begin(); it != entriesM.end(); )
+    {
+        if (current.find((*it).first) == current.end())
+        {
+            removeEntry((*it).first, (*it).second);
+            it = entriesM.erase(it);
+        }
+        else
+            ++it;
+    }
+    itemsM.swap(items);
+}
+
+void MetadataSearchIndex::clear()
+{
+    entriesM.clear();
+    itemsM.clear();
+    for (int aspect = 0; aspect < aspectCount; ++aspect)
+        tokensM[aspect].clear();
+}
+
+const std::vector<MetadataItem*>& MetadataSearchIndex::getItems() const
+{
+    return itemsM;
+}
+
+bool MetadataSearchIndex::addCandidates(Aspect aspect,
+    const wxString& pattern, Items& candidates) const
+{
+    wxString literal(getLongestLiteral(pattern));
+    if (literal.empty())
+        return false;
+
+    const TokenMap& tokens = tokensM[aspect];
+    for (TokenMap::const_iterator it = tokens.begin(); it != tokens.end();
+        ++it)
+    {
+        if ((*it).first.find(literal) != wxString::npos)
+            candidates.insert((*it).second.begin(), (*it).second.end());
+    }
+    if (aspect == aField)
+    {
+        for (EntryMap::const_iterator it = entriesM.begin();
+            it != entriesM.end(); ++it)
+        {
+            if (!(*it).second.hasFields)
+                candidates.insert((*it).first);
+        }
+    }
+    return true;
+}
+
+bool MetadataSearchIndex::matches(MetadataItem* item, Aspect aspect,
+    const wxString& pattern) const
+{
+    EntryMap::const_iterator it = entriesM.find(item);
+    if (it == entriesM.end())
+        return false;
+    const Entry& entry = (*it).second;
+    if (aspect == aField && !entry.hasFields)
+        return true;
+    const std::vector<wxString>& texts = entry.texts[aspect];
+    for (std::vector<wxString>::const_iterator ti = texts.begin();
+        ti != texts.end(); ++ti)
+    {
+        if ((*ti).Matches(pattern))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,97 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_METADATASEARCHINDEX_H
+#define FR_METADATASEARCHINDEX_H
+
+#include <wx/hashmap.h>
+#include <wx/string.h>
+
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "metadata/MetadataClasses.h"
+#include "metadata/metadataitem.h"
+
+class ProgressIndicator;
+
+// Inverted index of the names, descriptions, DDL and field names of the
+// non-system objects of a database, used by the advanced metadata search.
+// The texts are split into tokens (runs of identifier characters), so the
+// objects which can match a wildcard pattern are found by looking up the
+// literal part of the pattern in the tokens instead of matching the text
+// of every object.
+// The index is kept between searches, an object is indexed again only if
+// it (or one of its children) has changed, and the DDL, descriptions and
+// field names are only indexed once they are searched for.
+class MetadataSearchIndex
+{
+public:
+    enum Aspect { aName, aDescription, aDDL, aField, aspectCount };
+    typedef std::unordered_set<MetadataItem*> Items;
+private:
+    struct Entry
+    {
+        unsigned long changeStamp;
+        unsigned aspects;
+        // only relations and procedures have fields
+        bool hasFields;
+        std::vector<wxString> texts[aspectCount];
+    };
+    typedef std::unordered_map<MetadataItem*, Entry> EntryMap;
+    typedef std::unordered_map<wxString, Items, wxStringHash, wxStringEqual>
+        TokenMap;
+
+    EntryMap entriesM;
+    std::vector<MetadataItem*> itemsM;
+    TokenMap tokensM[aspectCount];
+
+    void indexAspect(MetadataItem* item, Entry& entry, Aspect aspect);
+    void removeEntry(MetadataItem* item, Entry& entry);
+public:
+    static unsigned aspectFlag(Aspect aspect) { return 1U << aspect; }
+
+    // brings the index up to date with the current objects of the database,
+    // aspects are the aspectFlag() values of the texts that are needed;
+    // if types is not empty, only the names of objects of other types
+    // are indexed
+    void update(Database& database, unsigned aspects,
+        const std::set<NodeType>& types,
+        ProgressIndicator* progressIndicator = 0);
+    void clear();
+
+    // the indexed objects, in the order of the database collections
+    const std::vector<MetadataItem*>& getItems() const;
+    // adds all objects that may match pattern (in upper case, with * and ?
+    // wildcards) to candidates, returns false if the pattern has no literal
+    // text so that all objects are candidates
+    bool addCandidates(Aspect aspect, const wxString& pattern,
+        Items& candidates) const;
+    // objects without fields match every field pattern
+    bool matches(MetadataItem* item, Aspect aspect, const wxString& pattern)
+        const;
+};
+
+#endif // FR_METADATASEARCHINDEX_H
@@ -33,6 +33,7 @@
 #include "core/ProcessableObject.h"
 #include "core/StringUtils.h"
 #include "core/TemplateProcessor.h"
+#include "engine/MetadataLoader.h"
 #include "metadata/CreateDDLVisitor.h"
 #include "metadata/column.h"
 #include "metadata/database.h"
@@ -51,6 +52,9 @@
 #include "metadata/view.h"
 #include "metadata/package.h"
 
+#include <algorithm>
+#include <iterator>
+
 
 class MetadataTemplateCmdHandler: public TemplateCmdHandler
 {
@@ -61,10 +65,29 @@ public:
     virtual void handleTemplateCmd(TemplateProcessor *tp,
         const wxString& cmdName, const TemplateCmdParams& cmdParams,
         ProcessableObject* object, wxString& processedText);
+    virtual bool handlesCommand(const wxString& cmdName) const;
 };
 
 const MetadataTemplateCmdHandler MetadataTemplateCmdHandler::handlerInstance;
 
+bool MetadataTemplateCmdHandler::handlesCommand(const wxString& cmdName) const
+{
+    static const wxString commands[] = {
+        "auxiliar", "checkconstraintinfo", "collationinfo", "columninfo",
+        "constraintinfo", "database", "dbinfo", "dependencyinfo",
+        "exceptioninfo", "fkinfo", "foreach", "functioninfo",
+        "generatorinfo", "indexinfo", "is_system", "keyinfo",
+        "no_pk_or_unique", "object_ddl", "object_description",
+        "object_handle", "object_name", "object_path", "object_quoted_name",
+        "object_type", "owner_name", "packageinfo", "parent", "primary_key",
+        "privilegeinfo", "privilegeitemcount", "privilegeiteminfo",
+        "procedureinfo", "sql_security", "triggerinfo", "udfinfo",
+        "userinfo", "viewinfo"
+    };
+    return std::find(std::begin(commands), std::end(commands), cmdName)
+        != std::end(commands);
+}
+
 void MetadataTemplateCmdHandler::handleTemplateCmd(TemplateProcessor *tp,
     const wxString& cmdName, const TemplateCmdParams& cmdParams,
     ProcessableObject* object, wxString& processedText)
@@ -913,6 +936,27 @@ void MetadataTemplateCmdHandler::handleTemplateCmd(TemplateProcessor *tp,
             processedText += wxString() << db->getLinger();
         else if (cmdParams[0] == "sql_security")
             processedText += wxString() << db->getSqlSecurity();
+        else if (cmdParams[0] == "statement_cache_size")
+        {
+            MetadataLoader* loader = db->getMetadataLoader();
+            processedText += wxString::Format("%zu / %u",
+                loader->getCachedStatementCount(),
+                loader->getMaximumConcurrentStatements());
+        }
+        else if (cmdParams[0] == "statement_cache_hits")
+        {
+            const MetadataLoader::Statistics& stats =
+                db->getMetadataLoader()->getStatistics();
+            processedText += wxString::Format("%lu / %lu",
+                stats.hits, stats.hits + stats.misses);
+        }
+        else if (cmdParams[0] == "statement_cache_prepares")
+        {
+            const MetadataLoader::Statistics& stats =
+                db->getMetadataLoader()->getStatistics();
+            processedText += wxString::Format("%lu (%.1f ms)",
+                stats.prepares, stats.prepareTime / 1000.0);
+        }
     }
 
     // {%privilegeinfo:<property>%}
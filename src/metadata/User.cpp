@@ -436,7 +436,8 @@ void Users12_0::load(ProgressIndicator* progressIndicator)
 {
     DatabasePtr db = getDatabase();
     wxString stmt = "select sec$user_name from sec$users order by 1 ";
-    setItems(db->loadIdentifiers(stmt, progressIndicator));
+    // users are not covered by the change marker of the metadata cache
+    setItems(db->loadIdentifiers(stmt, progressIndicator, false));
 }
 
 void Users12_0::loadChildren()
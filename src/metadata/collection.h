@@ -28,6 +28,9 @@
 #include <iterator>
 #include <vector>
 #include <functional>
+#include <unordered_map>
+
+#include <wx/hashmap.h>
 
 #include "config/DatabaseConfig.h"
 #include "core/ProgressIndicator.h"
@@ -151,28 +154,89 @@ public:
     typedef typename CollectionType::const_iterator const_iterator;
 
 private:
+    typedef std::unordered_map<wxString, ItemType, wxStringHash,
+        wxStringEqual> NameIndex;
+
     CollectionType itemsM;
+    // hashed lookups by identifier, by full name (including the schema) and
+    // by metadata id, rebuilt on demand after itemsM has been replaced;
+    // the first item in itemsM wins if several share the same key
+    mutable NameIndex identifierIndexM;
+    mutable NameIndex nameIndexM;
+    mutable std::unordered_map<int, ItemType> idIndexM;
+    mutable bool indexValidM = false;
+
+    void addToIndex(const ItemType& item) const
+    {
+        identifierIndexM.emplace(item->getIdentifier().get(), item);
+        nameIndexM.emplace(item->getName_(), item);
+        idIndexM.emplace(item->getMetadataId(), item);
+    }
 
-    iterator getPosition(const wxString& name)
+    void buildIndex() const
     {
-        Identifier id(name);
-        for (iterator it = itemsM.begin(); it != itemsM.end(); ++it)
+        if (indexValidM)
+            return;
+        identifierIndexM.clear();
+        nameIndexM.clear();
+        idIndexM.clear();
+        identifierIndexM.reserve(itemsM.size());
+        nameIndexM.reserve(itemsM.size());
+        idIndexM.reserve(itemsM.size());
+        for (const auto& item : itemsM)
         {
-            if ((*it)->getIdentifier().equals(id))
-                return it;
+            if (item)
+                addToIndex(item);
         }
-        return itemsM.end();
+        indexValidM = true;
     }
 
-    iterator getPositionMetadataId(const int id)
+    // items aren't renamed in practice, but a stale entry must never be
+    // returned, so hits are verified and the index rebuilt if necessary
+    ItemType findInIndex(NameIndex& index, const wxString& key,
+        bool byIdentifier) const
     {
-        for (iterator it = itemsM.begin(); it != itemsM.end(); ++it)
+        for (int pass = 0; pass < 2; ++pass)
         {
-            if ((*it)->getMetadataId() == id)
-                return it;
+            buildIndex();
+            typename NameIndex::const_iterator it = index.find(key);
+            if (it == index.end())
+                return ItemType();
+            const ItemType& item = (*it).second;
+            if ((byIdentifier ? item->getIdentifier().get()
+                : item->getName_()) == key)
+            {
+                return item;
+            }
+            indexValidM = false;
         }
-        return itemsM.end();
+        return ItemType();
+    }
 
+    ItemType findByIdentifier(const wxString& name) const
+    {
+        // normalised according to the Identifier rules
+        return findInIndex(identifierIndexM, Identifier(name).get(), true);
+    }
+
+    ItemType findById(const int id) const
+    {
+        buildIndex();
+        typename std::unordered_map<int, ItemType>::const_iterator it =
+            idIndexM.find(id);
+        if (it != idIndexM.end() && (*it).second->getMetadataId() == id)
+            return (*it).second;
+        // metadata ids are set when item properties are loaded, which
+        // happens after the item has been added to the collection
+        for (const auto& item : itemsM)
+        {
+            if (item && item->getMetadataId() == id)
+            {
+                indexValidM = false;
+                return item;
+            }
+        }
+        return ItemType();
     }
 
 protected:
@@ -199,11 +263,20 @@ public:
     // order of item names, and returns pointer to it
     ItemType insert(const wxString& name)
     {
-        iterator pos = std::find_if(itemsM.begin(), itemsM.end(),
-            InsertionPosByName(name));
+        // items are kept in order of their names, so the first item with
+        // a greater name can be found with a binary search
+        iterator pos = std::upper_bound(itemsM.begin(), itemsM.end(), name,
+            [](const wxString& n, const ItemType& item)
+            {
+                return InsertionPosByName(n)(item);
+            });
         ItemType item = newItem(name);// (new T(getDatabase(), name));
         initializeLockCount(item, getLockCount());
         itemsM.insert(pos, item);
+        // items with the same name are inserted after the existing ones,
+        // so the index entries of those stay valid
+        if (indexValidM)
+            addToIndex(item);
         notifyObservers();
         return item;
     }
@@ -222,6 +295,7 @@ public:
         if (pos != itemsM.end())
         {
             itemsM.erase(pos);
+            indexValidM = false;
             notifyObservers();
         }
     }
@@ -232,16 +306,15 @@ public:
         CollectionType newItems;
         for (size_t i = 0; i < names.size(); ++i)
         {
-            wxString itemName(names[i]);
-            iterator oldPos = getPosition(itemName);
-            if (oldPos == itemsM.end())
+            ItemType oldItem = findByIdentifier(names[i]);
+            if (!oldItem)
             {
                ItemType item = newItem(names[i]);//(new T(database, names[i]));
                 newItems.push_back(item);
                 initializeLockCount(item, getLockCount());
             }
             else
-                newItems.push_back(*oldPos);
+                newItems.push_back(oldItem);
         }
         setItems(newItems);
     }
@@ -262,6 +335,7 @@ public:
         if (itemsM != items)
         {
             itemsM = items;
+            indexValidM = false;
             notifyObservers();
         }
         setChildrenLoaded(true);
@@ -291,20 +365,19 @@ public:
         if (!itemsM.empty())
         {
             itemsM.clear();
+            indexValidM = false;
             notifyObservers();
         }
     };
 
     ItemType findByName(const wxString& name)
     {
-        iterator it = getPosition(name);
-        return (it != itemsM.end()) ? (*it) : ItemType();
+        return findByIdentifier(name);
     };
 
     ItemType findByMetadataId(const int id)
     {
-        iterator it = getPositionMetadataId(id);
-        return (it != itemsM.end()) ? (*it) : ItemType();
+        return findById(id);
     }
 
     // returns vector of all subnodes
@@ -332,25 +405,13 @@ public:
 
     MetadataItemPtr findByName_(const wxString& name) const override 
     {
-        for (const auto& item : itemsM) {
-            if (item && item->getName_() == name) {
-                return std::static_pointer_cast<MetadataItem>(item);
-            }
-        }
-        return nullptr;
+        return std::static_pointer_cast<MetadataItem>(
+            findInIndex(nameIndexM, name, false));
     }
 
     MetadataItemPtr findByMetadataId_(const int& id) const override 
     {
-        for (const auto& item : itemsM) {
-            if (item  && item->getMetadataId() == id) {
-                //int LId = item->getMetadataId();
-                //if (LId == id) {
-                    return std::static_pointer_cast<MetadataItem>(item);
-                //}
-            }
-        }
-        return nullptr;
+        return std::static_pointer_cast<MetadataItem>(findById(id));
     }
 
     bool operator < (const MetadataCollection<T>& other) const
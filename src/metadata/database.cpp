@@ -31,6 +31,7 @@
 #endif
 
 #include <wx/encconv.h>
+#include <wx/filename.h>
 #include <wx/fontmap.h>
 
 #include <algorithm>
@@ -300,7 +301,8 @@ bool DatabaseAuthenticationMode::getUseEncryptedPassword() const
 // Database class
 Database::Database()
     : MetadataItem(ntDatabase), metadataLoaderM(0), connectedM(false),
-        connectionCredentialsM(0), dialectM(3), idM(0), volatileM(false)
+        connectionCredentialsM(0), dialectM(3), idM(0), volatileM(false),
+        cacheIdentifiersM(false)
 {
     defaultTimezoneM.name = "";
     defaultTimezoneM.id = 0;
@@ -308,6 +310,7 @@ Database::Database()
 
 Database::~Database()
 {
+    metadataCacheM.close();
     resetCredentials();
 }
 
@@ -430,14 +433,49 @@ void Database::loadGeneratorValues()
     MetadataLoaderTransaction tr(loader);
     SubjectLocker lock(this);
 
-    getGenerators()->forEachItem([&](const MetadataItemPtr& item) {
-        if (item) {
-            // make sure generator value is reloaded from database
-            item->invalidate();
-            item->ensurePropertiesLoaded();
-        }
-        }
-    );
+    getGenerators()->loadValues();
+}
+
+void Database::prefetchRelationColumns(ProgressIndicator* progressIndicator)
+{
+    checkConnected(_("prefetchRelationColumns"));
+
+    std::vector<Relation*> relations;
+    auto addRelations = [&relations](const MetadataCollectionBasePtr& coll) {
+        if (!coll)
+            return;
+        coll->forEachItem([&relations](const MetadataItemPtr& item) {
+                if (Relation* r = dynamic_cast<Relation*>(item.get()))
+                    relations.push_back(r);
+            }
+        );
+    };
+    addRelations(getTables());
+    addRelations(getGTTables());
+    addRelations(getViews());
+    addRelations(getSysTables());
+    Relation::loadColumns(getDatabase(), relations, progressIndicator);
+}
+
+void Database::prefetchMetadata(ProgressIndicator* progressIndicator)
+{
+    prefetchRelationColumns(progressIndicator);
+
+    std::vector<Table*> tables;
+    auto addTables = [&tables](const MetadataCollectionBasePtr& coll) {
+        if (!coll)
+            return;
+        coll->forEachItem([&tables](const MetadataItemPtr& item) {
+                if (Table* t = dynamic_cast<Table*>(item.get()))
+                    tables.push_back(t);
+            }
+        );
+    };
+    addTables(getTables());
+    addTables(getGTTables());
+    addTables(getSysTables());
+    Table::loadConstraintsAndIndices(getDatabase(), tables,
+        progressIndicator);
 }
 
 DatabasePtr Database::getDatabase() const
@@ -517,6 +555,9 @@ void Database::parseCommitedSql(const SqlStatement& stm)
     if (!stm.isDDL())
         return;    // return false only on IBPP exception
 
+    // don't restore columns from the metadata cache for changed objects
+    metadataCacheM.discardColumns(stm.getName());
+
     if (stm.actionIs(actGRANT))
     {
         MetadataItem *obj = stm.getObject();
@@ -907,10 +948,15 @@ void Database::connect(const wxString& password, ProgressIndicator* indicator)
                 loadDefaultTimezone();
                 loadTimezones();
 
-                // load collections of metadata objects
+                // load collections of metadata objects, from the local
+                // snapshot if the metadata hasn't been changed since
+                openMetadataCache();
                 setChildrenLoaded(false);
+                cacheIdentifiersM = true;
                 loadCollections(indicator);
+                cacheIdentifiersM = false;
                 setChildrenLoaded(true);
+                metadataCacheM.save();
                 if (indicator)
                     indicator->initProgress(_("Complete"), 1, 1);
             }
@@ -981,8 +1027,15 @@ void Database::loadDatabaseInfo()
 }
 
 wxArrayString Database::loadIdentifiers(const wxString& loadStatement,
-    ProgressIndicator* progressIndicator)
+    ProgressIndicator* progressIndicator, bool cacheable)
 {
+    wxArrayString names;
+    // the metadata cache is only used while loading the collections on
+    // connect, later calls always return the current state
+    cacheable = cacheable && cacheIdentifiersM;
+    if (cacheable && metadataCacheM.findIdentifiers(loadStatement, names))
+        return names;
+
     MetadataLoader* loader = getMetadataLoader();
     MetadataLoaderTransaction tr(loader);
     wxMBConv* converter = getCharsetConverter();
@@ -991,7 +1044,6 @@ wxArrayString Database::loadIdentifiers(const wxString& loadStatement,
         wx2std(loadStatement, getCharsetConverter()));
     st1->Execute();
 
-    wxArrayString names;
     while (st1->Fetch())
     {
         checkProgressIndicatorCanceled(progressIndicator);
@@ -1002,6 +1054,8 @@ wxArrayString Database::loadIdentifiers(const wxString& loadStatement,
             names.push_back(std2wxIdentifier(s, converter));
         }
     }
+    if (cacheable)
+        metadataCacheM.storeIdentifiers(loadStatement, names);
     return names;
 }
 
@@ -1016,6 +1070,9 @@ void Database::disconnect()
 
 void Database::setDisconnected()
 {
+    metadataCacheM.close();
+    searchIndexM.clear();
+    cacheIdentifiersM = false;
     delete metadataLoaderM;
     metadataLoaderM = 0;
     resetCredentials();     // "forget" temporary username/password
@@ -1035,10 +1092,148 @@ bool Database::isConnected() const
     return connectedM;
 }
 
+MetadataCache& Database::getMetadataCache()
+{
+    return metadataCacheM;
+}
+
+MetadataSearchIndex& Database::getSearchIndex()
+{
+    return searchIndexM;
+}
+
+void Database::openMetadataCache()
+{
+    metadataCacheM.close();
+    // hash() and list() are needed for the change marker
+    if (getIsVolative() || !config().get("UseMetadataCache", true)
+        || !getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
+    {
+        return;
+    }
+
+    // every part of the marker is the number of rows and the sum of the
+    // row hashes of a system table, so it doesn't depend on the order of
+    // rows but changes when objects are created, dropped or changed in a
+    // way that matters for the metadata collections
+    std::vector<std::string> parts;
+    parts.push_back("rdb$relations:rdb$relation_name || '/' "
+        "|| coalesce(rdb$format, 0) || '/' || coalesce(rdb$system_flag, 0) "
+        "|| '/' || coalesce(rdb$relation_type, 0) "
+        "|| iif(rdb$view_blr is null, 'T', 'V')");
+    parts.push_back("rdb$procedures:rdb$procedure_name");
+    parts.push_back("rdb$triggers:rdb$trigger_name || '/' "
+        "|| rdb$trigger_type || '/' || coalesce(rdb$trigger_inactive, 0) "
+        "|| '/' || coalesce(rdb$system_flag, 0) "
+        "|| '/' || coalesce(rdb$relation_name, '')");
+    parts.push_back("rdb$generators:rdb$generator_name");
+    parts.push_back("rdb$functions:rdb$function_name");
+    parts.push_back("rdb$fields:rdb$field_name");
+    parts.push_back("rdb$indices:rdb$index_name || '/' "
+        "|| coalesce(rdb$index_inactive, 0) || '/' "
+        "|| coalesce(rdb$system_flag, 0)");
+    parts.push_back("rdb$roles:rdb$role_name");
+    parts.push_back("rdb$character_sets:rdb$character_set_name");
+    parts.push_back("rdb$collations:rdb$collation_name");
+    if (getInfo().getODSVersionIsHigherOrEqualTo(12, 0))
+        parts.push_back("rdb$packages:rdb$package_name");
+    if (getInfo().getODSVersionIsHigherOrEqualTo(14, 0))
+        parts.push_back("rdb$schemas:rdb$schema_name");
+
+    std::string sql("select ");
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        std::string::size_type colon = parts[i].find(':');
+        if (i > 0)
+            sql += ", ";
+        sql += "(select count(*) || '/' || coalesce(sum(mod(hash("
+            + parts[i].substr(colon + 1) + "), 2147483647)), 0) from "
+            + parts[i].substr(0, colon) + ")";
+    }
+    sql += " from rdb$database";
+
+    try
+    {
+        MetadataLoader* loader = getMetadataLoader();
+        MetadataLoaderTransaction tr(loader);
+        wxMBConv* converter = getCharsetConverter();
+
+        std::string marker(wx2std(getConnectionCharset(), converter));
+        IBPP::Statement st1 = loader->createStatement(sql);
+        st1->Execute();
+        if (!st1->Fetch())
+            return;
+        for (size_t i = 1; i <= parts.size(); ++i)
+        {
+            std::string s;
+            st1->Get(int(i), s);
+            marker += ";" + s;
+        }
+
+        // the format of a relation doesn't change with comments, defaults,
+        // nullability or domains of its columns, so the version of the
+        // cached columns contains a hash of their definitions too
+        bool ods12 = getInfo().getODSVersionIsHigherOrEqualTo(12, 0);
+        std::string columnSql("rf.rdb$field_name || '/' "
+            "|| rf.rdb$field_source || '/' || coalesce(rf.rdb$null_flag, 0) "
+            "|| '/' || coalesce(rf.rdb$collation_id, -1) "
+            "|| '/' || coalesce(rf.rdb$field_position, -1) "
+            "|| '/' || coalesce(f.rdb$null_flag, 0) "
+            "|| '/' || coalesce(f.rdb$default_source, '') "
+            "|| '/' || coalesce(f.rdb$computed_source, '') "
+            "|| '/' || coalesce(rf.rdb$default_source, '') "
+            "|| '/' || coalesce(rf.rdb$description, '')");
+        if (ods12)
+        {
+            columnSql += " || '/' || coalesce(rf.rdb$identity_type, -1) "
+                "|| '/' || coalesce(g.rdb$initial_value, 0) "
+                "|| '/' || coalesce(g.rdb$generator_increment, 0)";
+        }
+        std::string versionSql("select r.rdb$relation_name, "
+            "coalesce(r.rdb$format, 0) || '/' || count(rf.rdb$field_name) "
+            "|| '/' || coalesce(sum(mod(hash(" + columnSql
+            + "), 2147483647)), 0) from rdb$relations r "
+            "left join rdb$relation_fields rf "
+            "on rf.rdb$relation_name = r.rdb$relation_name "
+            "left join rdb$fields f on f.rdb$field_name = rf.rdb$field_source ");
+        if (ods12)
+        {
+            versionSql += "left join rdb$generators g "
+                "on g.rdb$generator_name = rf.rdb$generator_name ";
+        }
+        versionSql += "group by r.rdb$relation_name, r.rdb$format";
+
+        MetadataCache::RelationVersions versions;
+        IBPP::Statement st2 = loader->createStatement(versionSql);
+        st2->Execute();
+        while (st2->Fetch())
+        {
+            std::string s, version;
+            st2->Get(1, s);
+            st2->Get(2, version);
+            versions[std2wxIdentifier(s, converter)] = version;
+        }
+
+        wxString fileName(config().getUserHomePath() + "metadata-cache"
+            + wxFileName::GetPathSeparator() + "db" + getId() + ".frmc");
+        std::string databaseKey(wx2std(getConnectionString() + "|"
+            + getUsername(), converter));
+        metadataCacheM.open(fileName, databaseKey, marker, versions);
+    }
+    catch (IBPP::Exception&)
+    {
+        // the cache is an optimization only, connect without it
+        metadataCacheM.close();
+    }
+}
+
 MetadataLoader* Database::getMetadataLoader()
 {
     if (metadataLoaderM == 0)
-        metadataLoaderM = new MetadataLoader(*this, 8);
+    {
+        metadataLoaderM = new MetadataLoader(*this,
+            config().get("MetadataStatementCacheSize", 64));
+    }
     return metadataLoaderM;
 }
 
@@ -30,8 +30,10 @@
 
 #include <ibpp.h>
 
+#include "metadata/MetadataCache.h"
 #include "metadata/MetadataClasses.h"
 #include "metadata/metadataitem.h"
+#include "metadata/MetadataSearchIndex.h"
 //#include "metadata/MetadataRegistry.h"
 
 
@@ -192,6 +194,12 @@ private:
 
     MetadataContainerPtr metadataContainerM;
 
+    MetadataCache metadataCacheM;
+    bool cacheIdentifiersM;
+    void openMetadataCache();
+
+    MetadataSearchIndex searchIndexM;
+
     // copy constructor implementation removed since it's no longer needed
     // (Server uses a vector of std::shared_ptr<Database> now)
     Database(const Database& rhs);
@@ -266,12 +274,22 @@ public:
     void drop();
 
     MetadataLoader* getMetadataLoader();
+    MetadataCache& getMetadataCache();
+    MetadataSearchIndex& getSearchIndex();
 
+    // cacheable statements return the names from the metadata cache while
+    // the collections are loaded on connect
     wxArrayString loadIdentifiers(const wxString& loadStatement,
-        ProgressIndicator* progressIndicator = 0);
+        ProgressIndicator* progressIndicator = 0, bool cacheable = true);
 
 
     void loadGeneratorValues();
+
+    //! loads the columns of all relations with a single query
+    void prefetchRelationColumns(ProgressIndicator* progressIndicator = 0);
+    //! loads columns of all relations and constraints and indices of all
+    //! tables with a few set-based queries instead of several per object
+    void prefetchMetadata(ProgressIndicator* progressIndicator = 0);
     Relation* getRelationForTrigger(DMLTrigger* trigger);
 
     virtual DatabasePtr getDatabase() const;
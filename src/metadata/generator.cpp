@@ -31,6 +31,10 @@
 #endif
 
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include <ibpp.h>
 
 #include "core/FRError.h"
@@ -53,6 +57,16 @@ int64_t Generator::getValue()
     return valueM;
 }
 
+void Generator::setValues(int64_t value, int64_t initialValue,
+    int64_t incrementalValue)
+{
+    valueM = value;
+    initialValueM = initialValue;
+    incrementalValueM = incrementalValue;
+    setPropertiesLoaded(true);
+    notifyObservers();
+}
+
 void Generator::loadProperties()
 {
     setPropertiesLoaded(false);
@@ -195,6 +209,93 @@ void Generators::loadChildren()
     load(0);
 }
 
+void Generators::loadValues()
+{
+    DatabasePtr db = getDatabase();
+    if (!db->getInfo().getODSVersionIsHigherOrEqualTo(11, 0)
+        || db->getSqlDialect() < 3)
+    {
+        // no EXECUTE BLOCK before Firebird 2.0, and no BIGINT for its
+        // output in dialect 1 databases
+        forEachItem([](const MetadataItemPtr& item) {
+            item->invalidate();
+            item->ensurePropertiesLoaded();
+        });
+        return;
+    }
+
+    MetadataLoader* loader = db->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(this);
+    wxMBConv* converter = db->getCharsetConverter();
+
+    std::vector<GeneratorPtr> generators(begin(), end());
+    std::vector<int64_t> initialValues(generators.size(), 0);
+    std::vector<int64_t> increments(generators.size(), 0);
+    if (db->getInfo().getODSVersionIsHigherOrEqualTo(12, 0))
+    {
+        IBPP::Statement& st1 = loader->getStatement(
+            "select rdb$generator_name, rdb$initial_value, "
+            "rdb$generator_increment from rdb$generators "
+            "where (rdb$system_flag = 0 or rdb$system_flag is null)");
+        st1->Execute();
+        std::map<wxString, size_t> indices;
+        for (size_t i = 0; i < generators.size(); ++i)
+            indices[generators[i]->getName_()] = i;
+        while (st1->Fetch())
+        {
+            std::string name;
+            st1->Get(1, name);
+            std::map<wxString, size_t>::iterator it =
+                indices.find(std2wxIdentifier(name, converter));
+            if (it == indices.end())
+                continue;
+            if (!st1->IsNull(2))
+                st1->Get(2, initialValues[(*it).second]);
+            if (!st1->IsNull(3))
+                st1->Get(3, increments[(*it).second]);
+        }
+    }
+
+    // gen_id() needs the generator name in the statement text, so the
+    // current values are read by EXECUTE BLOCK statements returning one
+    // row per generator, each one covering a batch of generators that
+    // stays well below the statement length limit of older servers
+    const size_t maxBatchSql = 48 * 1024;
+    size_t batchStart = 0;
+    while (batchStart < generators.size())
+    {
+        std::string sql("execute block returns (idx integer, val bigint) "
+            "as begin\n");
+        size_t batchEnd = batchStart;
+        while (batchEnd < generators.size() && sql.size() < maxBatchSql)
+        {
+            // IMPORTANT: getQuotedName() has to be used when building
+            // the SQL statement dynamically
+            sql += "idx = " + std::to_string(batchEnd - batchStart)
+                + "; val = gen_id("
+                + wx2std(generators[batchEnd]->getQuotedName(), converter)
+                + ", 0); suspend;\n";
+            ++batchEnd;
+        }
+        sql += "end";
+
+        // do not use cached statements, because this can not be reused
+        IBPP::Statement st2 = loader->createStatement(sql);
+        st2->Execute();
+        while (st2->Fetch())
+        {
+            int idx;
+            int64_t value;
+            st2->Get(1, idx);
+            st2->Get(2, value);
+            size_t i = batchStart + idx;
+            generators[i]->setValues(value, initialValues[i], increments[i]);
+        }
+        batchStart = batchEnd;
+    }
+}
+
 const wxString Generators::getTypeName() const
 {
     return "GENERATOR_COLLECTION";
@@ -37,13 +37,16 @@ private:
     int64_t initialValueM;
     int64_t incrementalValueM;
     std::vector<Privilege> privilegesM;
-    void setValue(int64_t value);
 protected:
     virtual void loadProperties();
 public:
     Generator(DatabasePtr database, const wxString& name);
 
     int64_t getValue();
+    // sets the properties without querying the database, used to refresh
+    // all generators of the database at once
+    void setValues(int64_t value, int64_t initialValue,
+        int64_t incrementalValue);
 
     virtual const wxString getTypeName() const;
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
@@ -60,6 +63,9 @@ public:
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
     void load(ProgressIndicator* progressIndicator);
+    // reloads the current values (and start values and increments) of all
+    // generators with a few statements instead of two per generator
+    void loadValues();
     virtual const wxString getTypeName() const;
 };
 
@@ -30,10 +30,15 @@
     #include "wx/wx.h"
 #endif
 
+#include <unordered_map>
+
+#include <wx/hashmap.h>
+
 #include <ibpp.h>
 
 #include "core/StringUtils.h"
 #include "core/FRError.h"
+#include "core/ProgressIndicator.h"
 #include "engine/MetadataLoader.h"
 #include "frutils.h"
 #include "firebird/constants.h"
@@ -194,12 +199,116 @@ int Relation::getRelationType()
     return relationTypeM;
 }
 
+std::string Relation::getColumnsSql(DatabasePtr db, bool allRelations)
+{
+    bool ods12 = db->getInfo().getODSVersionIsHigherOrEqualTo(12, 0);
+    std::string sql(
+            "select r.rdb$field_name, r.rdb$null_flag, r.rdb$field_source,"         //1,2,3
+            " l.rdb$collation_name, f.rdb$computed_source, r.rdb$default_source,"   //4,5,6
+            " r.rdb$description ");                                                 //7
+    sql += ods12 ? ", r.RDB$GENERATOR_NAME, r.RDB$IDENTITY_TYPE, g.RDB$INITIAL_VALUE, RDB$GENERATOR_INCREMENT " : ", null, null, null, null "; //8,9, 10, 11
+    sql +=  ", r.rdb$relation_name "                                                //12
+            " from rdb$fields f"
+            " join rdb$relation_fields r "
+            "     on f.rdb$field_name=r.rdb$field_source"
+            " left outer join rdb$collations l "
+            "     on l.rdb$collation_id = r.rdb$collation_id "
+            "     and l.rdb$character_set_id = f.rdb$character_set_id";
+
+    if (ods12)
+        sql += " left join RDB$GENERATORS g on g.RDB$GENERATOR_NAME = r.RDB$GENERATOR_NAME ";
+    if (allRelations)
+        sql += " order by r.rdb$relation_name, r.rdb$field_position";
+    else
+    {
+        sql +=  " where r.rdb$relation_name = ?"
+                " order by r.rdb$field_position";
+    }
+    return sql;
+}
+
+ColumnDefinition Relation::readColumn(IBPP::Statement& st1,
+    wxMBConv* converter)
+{
+    ColumnDefinition cd;
+    std::string s, coll;
+    st1->Get(1, s);
+    cd.name = std2wxIdentifier(s, converter);
+    bool notNull = false;
+    if (!st1->IsNull(2))
+        st1->Get(2, &notNull);
+    cd.nullable = !notNull;
+    st1->Get(3, s);
+    cd.source = std2wxIdentifier(s, converter);
+    if (!st1->IsNull(4))
+        st1->Get(4, coll);
+    cd.collation = std2wxIdentifier(coll, converter);
+    readBlob(st1, 5, cd.computedSource, converter);
+    cd.hasDefault = !st1->IsNull(6);
+    if (cd.hasDefault)
+    {
+        readBlob(st1, 6, cd.defaultSource, converter);
+        // Some users reported two spaces before DEFAULT word in source
+        // Perhaps some other tools can put garbage here? Should we
+        // parse it as SQL to clean up comments, whitespace, etc?
+        cd.defaultSource.Trim(false).Remove(0, 8);
+    }
+    cd.hasDescription = !st1->IsNull(7);
+    cd.initialValue = 0;
+    cd.incrementValue = 0;
+    if (!st1->IsNull(8)) {
+        int i;
+        st1->Get(9, i);
+        cd.identityType = i == IDENT_TYPE_BY_DEFAULT ? "BY DEFAULT" : i == IDENT_TYPE_ALWAYS ? "ALWAYS" : "";
+        st1->Get(10, cd.initialValue);
+        st1->Get(11, cd.incrementValue);
+    }
+    return cd;
+}
+
+void Relation::setColumns(const ColumnDefinitions& definitions)
+{
+    ColumnPtrs columns;
+    for (ColumnDefinitions::const_iterator it = definitions.begin();
+        it != definitions.end(); ++it)
+    {
+        ColumnPtr col = findColumn(it->name);
+        if (!col)
+        {
+            col.reset(new Column(this, it->name));
+            initializeLockCount(col, getLockCount());
+        }
+        columns.push_back(col);
+        col->initialize(it->source, it->computedSource, it->collation,
+            it->nullable, it->defaultSource, it->hasDefault,
+            it->hasDescription, it->identityType, it->initialValue,
+            it->incrementValue);
+    }
+
+    setChildrenLoaded(true);
+    if (columnsM != columns)
+    {
+        columnsM.swap(columns);
+        notifyObservers();
+    }
+}
+
 void Relation::loadChildren()
 {
     // in case an exception is thrown this should be repeated
     setChildrenLoaded(false);
 
     DatabasePtr db = getDatabase();
+    // columns restored from the metadata cache need no database access
+    ColumnDefinitions columns;
+    MetadataCache& cache = db->getMetadataCache();
+    if (cache.takeColumns(getName_(), columns))
+    {
+        SubjectLocker lock(db.get());
+        setColumns(columns);
+        return;
+    }
+
     MetadataLoader* loader = db->getMetadataLoader();
     // first start a transaction for metadata loading, then lock the database
     // (lock the database instead of the relation itself, as loading columns
@@ -211,80 +320,100 @@ void Relation::loadChildren()
     MetadataLoaderTransaction tr(loader);
     SubjectLocker lock(db.get());
     wxMBConv* converter = db->getCharsetConverter();
-    std::string sql(
-            "select r.rdb$field_name, r.rdb$null_flag, r.rdb$field_source,"         //1,2,3
-            " l.rdb$collation_name, f.rdb$computed_source, r.rdb$default_source,"   //4,5,6
-            " r.rdb$description ");                                                 //7
-    sql += db->getInfo().getODSVersionIsHigherOrEqualTo(12, 0) ? ", r.RDB$GENERATOR_NAME, r.RDB$IDENTITY_TYPE, g.RDB$INITIAL_VALUE, RDB$GENERATOR_INCREMENT " : ", null, null, null, null "; //8,9, 10, 11
-    sql +=  " from rdb$fields f"
-            " join rdb$relation_fields r "
-            "     on f.rdb$field_name=r.rdb$field_source"
-            " left outer join rdb$collations l "
-            "     on l.rdb$collation_id = r.rdb$collation_id "
-            "     and l.rdb$character_set_id = f.rdb$character_set_id";
-    
-    if (db->getInfo().getODSVersionIsHigherOrEqualTo(12, 0))
-        sql += " left join RDB$GENERATORS g on g.RDB$GENERATOR_NAME = r.RDB$GENERATOR_NAME ";
-    sql +=  " where r.rdb$relation_name = ?"
-            " order by r.rdb$field_position";
-    
-    IBPP::Statement& st1 = loader->getStatement(sql);
+
+    IBPP::Statement& st1 = loader->getStatement(getColumnsSql(db, false));
     st1->Set(1, wx2std(getName_(), converter));
     st1->Execute();
 
-    ColumnPtrs columns;
     while (st1->Fetch())
+        columns.push_back(readColumn(st1, converter));
+    setColumns(columns);
+    cache.storeColumns(getName_(), columns);
+}
+
+void Relation::loadColumns(DatabasePtr db,
+    const std::vector<Relation*>& relations,
+    ProgressIndicator* progressIndicator)
+{
+    typedef std::unordered_map<wxString, Relation*, wxStringHash,
+        wxStringEqual> RelationMap;
+    RelationMap pending;
+    MetadataCache& cache = db->getMetadataCache();
     {
-        std::string s, coll;
-        st1->Get(1, s);
-        wxString fname(std2wxIdentifier(s, converter));
-        bool notNull = false;
-        if (!st1->IsNull(2))
-            st1->Get(2, &notNull);
-        st1->Get(3, s);
-        wxString source(std2wxIdentifier(s, converter));
-        if (!st1->IsNull(4))
-            st1->Get(4, coll);
-        wxString collation(std2wxIdentifier(coll, converter));
-        wxString computedSrc, defaultSrc;
-        readBlob(st1, 5, computedSrc, converter);
-        bool hasDefault = !st1->IsNull(6);
-        if (hasDefault)
+        SubjectLocker lock(db.get());
+        ColumnDefinitions columns;
+        for (std::vector<Relation*>::const_iterator it = relations.begin();
+            it != relations.end(); ++it)
         {
-            readBlob(st1, 6, defaultSrc, converter);
-            // Some users reported two spaces before DEFAULT word in source
-            // Perhaps some other tools can put garbage here? Should we
-            // parse it as SQL to clean up comments, whitespace, etc?
-            defaultSrc.Trim(false).Remove(0, 8);
-        }
-        bool hasDescription = !st1->IsNull(7);
-        wxString identityType = "";
-        int initialValue = 0, incrementValue = 0;
-        if (!st1->IsNull(8)) {
-            int i;
-            st1->Get(9, i);
-            identityType = i == IDENT_TYPE_BY_DEFAULT ? "BY DEFAULT" : i == IDENT_TYPE_ALWAYS ? "ALWAYS" : "";
-            st1->Get(10, initialValue);
-            st1->Get(11, incrementValue);
+            if ((*it)->childrenLoaded())
+                continue;
+            if (cache.takeColumns((*it)->getName_(), columns))
+                (*it)->setColumns(columns);
+            else
+                pending[(*it)->getName_()] = *it;
         }
+    }
+    if (pending.empty())
+        return;
 
+    MetadataLoader* loader = db->getMetadataLoader();
+    // see loadChildren() for the order of transaction and lock
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(db.get());
+    wxMBConv* converter = db->getCharsetConverter();
 
-        ColumnPtr col = findColumn(fname);
-        if (!col)
+    if (progressIndicator)
+    {
+        progressIndicator->initProgress(_("Loading columns..."),
+            pending.size(), 0, 1);
+    }
+
+    // executed once per call, so there's no point in keeping it prepared
+    IBPP::Statement st1 = loader->createStatement(getColumnsSql(db, true));
+    st1->Execute();
+
+    // rows are ordered by relation, so columns of one relation are
+    // collected and assigned as soon as the next relation starts
+    wxString currentName;
+    Relation* current = 0;
+    ColumnDefinitions columns;
+    while (st1->Fetch())
+    {
+        std::string s;
+        st1->Get(12, s);
+        wxString relationName(std2wxIdentifier(s, converter));
+        if (relationName != currentName)
         {
-            col.reset(new Column(this, fname));
-            initializeLockCount(col, getLockCount());
+            if (current)
+            {
+                current->setColumns(columns);
+                cache.storeColumns(currentName, columns);
+                columns.clear();
+                if (progressIndicator)
+                    progressIndicator->stepProgress();
+            }
+            checkProgressIndicatorCanceled(progressIndicator);
+
+            currentName = relationName;
+            RelationMap::iterator it = pending.find(relationName);
+            current = (it != pending.end()) ? it->second : 0;
+            if (current)
+                pending.erase(it);
         }
-        columns.push_back(col);
-        col->initialize(source, computedSrc, collation, !notNull,
-            defaultSrc, hasDefault, hasDescription, identityType, initialValue, incrementValue);
+        if (current)
+            columns.push_back(readColumn(st1, converter));
+    }
+    if (current)
+    {
+        current->setColumns(columns);
+        cache.storeColumns(currentName, columns);
     }
 
-    setChildrenLoaded(true);
-    if (columnsM != columns)
+    // relations without a single row in rdb$relation_fields
+    for (RelationMap::iterator it = pending.begin(); it != pending.end();
+        ++it)
     {
-        columnsM.swap(columns);
-        notifyObservers();
+        it->second->setColumns(ColumnDefinitions());
     }
 }
 
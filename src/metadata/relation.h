@@ -28,11 +28,14 @@
 #include <vector>
 
 #include "metadata/constraints.h"
+#include "metadata/MetadataCache.h"
 #include "metadata/MetadataClasses.h"
 #include "metadata/metadataitem.h"
 #include "metadata/privilege.h"
 #include "metadata/trigger.h"
 
+class ProgressIndicator;
+
 class Relation: public MetadataItem
 {
 private:
@@ -52,6 +55,14 @@ protected:
     virtual void lockChildren();
     virtual void unlockChildren();
 
+    // column loading is split up so that the columns of all relations can
+    // be loaded with a single statement as well (see loadColumns()), and
+    // so that columns can be restored from the metadata cache
+    static std::string getColumnsSql(DatabasePtr db, bool allRelations);
+    static ColumnDefinition readColumn(IBPP::Statement& st,
+        wxMBConv* converter);
+    void setColumns(const ColumnDefinitions& definitions);
+
     // property setters, used for either tables or views
     // (called from loadProperties() method)
     // this loads more data than necesary, but causes less database roundtrips
@@ -83,6 +94,12 @@ public:
     ColumnPtr findColumn(const wxString& name) const;
     int findColumnPosition(const wxString& name) const;
 
+    // loads the columns of all relations in the list that haven't been
+    // loaded yet, using one query for the whole database
+    static void loadColumns(DatabasePtr db,
+        const std::vector<Relation*>& relations,
+        ProgressIndicator* progressIndicator = 0);
+
     wxString getRebuildSql(const wxString& forColumn = "");
     std::vector<Privilege>* getPrivileges(bool splitPerGrantor=true);
     bool getChildren(std::vector<MetadataItem *>& temp);
@@ -30,9 +30,15 @@
     #include "wx/wx.h"
 #endif
 
+#include <functional>
+#include <unordered_map>
+
+#include <wx/hashmap.h>
+
 #include <ibpp.h>
 
 #include "core/FRError.h"
+#include "core/ProgressIndicator.h"
 #include "core/StringUtils.h"
 #include "engine/MetadataLoader.h"
 #include "frutils.h"
@@ -96,6 +102,83 @@ void Table::loadChildren()
     Relation::loadChildren();
 }
 
+// the statements below are used both for a single table and for all tables
+// of the database at once, the relation name is always the last column
+static std::string getCheckConstraintsSql(bool allTables)
+{
+    std::string sql(
+        "select r.rdb$constraint_name, t.rdb$trigger_source, d.rdb$field_name, "
+        " r.rdb$relation_name "
+        " from rdb$relation_constraints r "
+        " join rdb$check_constraints c on r.rdb$constraint_name=c.rdb$constraint_name and r.rdb$constraint_type = 'CHECK'"
+        " join rdb$triggers t on c.rdb$trigger_name=t.rdb$trigger_name and t.rdb$trigger_type = 1 "
+        " left join rdb$dependencies d on t.rdb$trigger_name = d.rdb$dependent_name "
+        "      and d.rdb$depended_on_name = r.rdb$relation_name "
+        "      and d.rdb$depended_on_type = 0 "
+    );
+    if (allTables)
+        sql += " order by 4, 1 ";
+    else
+        sql += " where r.rdb$relation_name=? order by 1 ";
+    return sql;
+}
+
+static std::string getKeyConstraintsSql(const std::string& constraintType,
+    bool allTables)
+{
+    std::string sql(
+        "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name, "
+        " r.rdb$relation_name "
+        "from rdb$relation_constraints r, rdb$index_segments i "
+        "where r.rdb$index_name=i.rdb$index_name and "
+        "(r.rdb$constraint_type='" + constraintType + "') "
+    );
+    if (allTables)
+        sql += "order by r.rdb$relation_name, ";
+    else
+        sql += "and r.rdb$relation_name=? order by ";
+    sql += "r.rdb$constraint_name, i.rdb$field_position";
+    return sql;
+}
+
+static std::string getForeignKeysSql(bool allTables)
+{
+    std::string sql(
+        "select r.rdb$constraint_name, i.rdb$field_name, c.rdb$update_rule, "
+        " c.rdb$delete_rule, c.RDB$CONST_NAME_UQ, r.rdb$index_name, "
+        " r.rdb$relation_name "
+        "from rdb$relation_constraints r, rdb$index_segments i, rdb$ref_constraints c "
+        "where r.rdb$index_name=i.rdb$index_name  "
+        "and r.rdb$constraint_name = c.rdb$constraint_name "
+        "and (r.rdb$constraint_type='FOREIGN KEY') "
+    );
+    if (allTables)
+        sql += "order by 7, 1, i.rdb$field_position";
+    else
+        sql += "and r.rdb$relation_name=? order by 1, i.rdb$field_position";
+    return sql;
+}
+
+static std::string getIndicesSql(bool allTables)
+{
+    std::string sql(
+        "SELECT i.rdb$index_name, i.rdb$unique_flag, i.rdb$index_inactive, "
+        " i.rdb$index_type, i.rdb$statistics, "
+        " s.rdb$field_name, rc.rdb$constraint_name, i.rdb$expression_source, "
+        " i.rdb$relation_name "
+        " from rdb$indices i "
+        " left join rdb$index_segments s on i.rdb$index_name = s.rdb$index_name "
+        " left join rdb$relation_constraints rc "
+        "   on rc.rdb$index_name = i.rdb$index_name "
+    );
+    if (allTables)
+        sql += " order by i.rdb$relation_name, ";
+    else
+        sql += " where i.rdb$relation_name = ? order by ";
+    sql += "i.rdb$index_name, s.rdb$field_position ";
+    return sql;
+}
+
 //! reads checks info from database
 void Table::loadCheckConstraints()
 {
@@ -114,46 +197,39 @@ void Table::loadCheckConstraints()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, t.rdb$trigger_source, d.rdb$field_name "
-        " from rdb$relation_constraints r "
-        " join rdb$check_constraints c on r.rdb$constraint_name=c.rdb$constraint_name and r.rdb$constraint_type = 'CHECK'"
-        " join rdb$triggers t on c.rdb$trigger_name=t.rdb$trigger_name and t.rdb$trigger_type = 1 "
-        " left join rdb$dependencies d on t.rdb$trigger_name = d.rdb$dependent_name "
-        "      and d.rdb$depended_on_name = r.rdb$relation_name "
-        "      and d.rdb$depended_on_type = 0 "
-        " where r.rdb$relation_name=? "
-        " order by 1 "
-    );
+        getCheckConstraintsSql(false));
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    CheckConstraint *cc = 0;
     while (st1->Fetch())
+        readCheckConstraintRow(st1, conv);
+    checkConstraintsLoadedM = true;
+}
+
+void Table::readCheckConstraintRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    if (checkConstraintsM.empty()
+        || cname != checkConstraintsM.back().getName_()) // new constraint
     {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        if (!cc || cname != cc->getName_()) // new constraint
-        {
-            wxString source;
-            readBlob(st1, 2, source, conv);
-
-            CheckConstraint c;
-            c.setParent(this);
-            c.setName_(cname);
-            c.sourceM = source;
-            checkConstraintsM.push_back(c);
-            cc = &checkConstraintsM.back();
-        }
+        wxString source;
+        readBlob(st1, 2, source, conv);
+
+        CheckConstraint c;
+        c.setParent(this);
+        c.setName_(cname);
+        c.sourceM = source;
+        checkConstraintsM.push_back(c);
+    }
 
-        if (!st1->IsNull(3))
-        {
-            st1->Get(3, s);
-            wxString fname(std2wxIdentifier(s, conv));
-            cc->columnsM.push_back(fname);
-        }
+    if (!st1->IsNull(3))
+    {
+        st1->Get(3, s);
+        wxString fname(std2wxIdentifier(s, conv));
+        checkConstraintsM.back().columnsM.push_back(fname);
     }
-    checkConstraintsLoadedM = true;
 }
 
 //! reads primary key info from database
@@ -174,32 +250,31 @@ void Table::loadPrimaryKey()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name "
-        "from rdb$relation_constraints r, rdb$index_segments i "
-        "where r.rdb$relation_name=? and r.rdb$index_name=i.rdb$index_name and "
-        "(r.rdb$constraint_type='PRIMARY KEY') order by r.rdb$constraint_name, i.rdb$field_position"
-    );
+        getKeyConstraintsSql("PRIMARY KEY", false));
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
     while (st1->Fetch())
-    {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        st1->Get(2, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        st1->Get(3, s);
-        wxString ixname(std2wxIdentifier(s, conv));
-
-        primaryKeyM.setName_(cname);
-        primaryKeyM.columnsM.push_back(fname);
-        primaryKeyM.indexNameM = ixname;
-    }
+        readPrimaryKeyRow(st1, conv);
     primaryKeyM.setParent(this);
     primaryKeyLoadedM = true;
 }
 
+void Table::readPrimaryKeyRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    st1->Get(2, s);
+    wxString fname(std2wxIdentifier(s, conv));
+    st1->Get(3, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    primaryKeyM.setName_(cname);
+    primaryKeyM.columnsM.push_back(fname);
+    primaryKeyM.indexNameM = ixname;
+}
+
 //! reads uniques from database
 void Table::loadUniqueConstraints()
 {
@@ -218,39 +293,40 @@ void Table::loadUniqueConstraints()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name "
-        "from rdb$relation_constraints r, rdb$index_segments i "
-        "where r.rdb$relation_name=? and r.rdb$index_name=i.rdb$index_name and "
-        "(r.rdb$constraint_type='UNIQUE') order by r.rdb$constraint_name, i.rdb$field_position"
-    );
+        getKeyConstraintsSql("UNIQUE", false));
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    UniqueConstraint *cc = 0;
     while (st1->Fetch())
-    {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        st1->Get(2, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        st1->Get(3, s);
-        wxString ixname(std2wxIdentifier(s, conv));
+        readUniqueConstraintRow(st1, conv);
+    uniqueConstraintsLoadedM = true;
+}
 
-        if (cc && cc->getName_() == cname)
-            cc->columnsM.push_back(fname);
-        else
-        {
-            UniqueConstraint c;
-            uniqueConstraintsM.push_back(c);
-            cc = &uniqueConstraintsM.back();
-            cc->indexNameM = ixname;
-            cc->setName_(cname);
-            cc->columnsM.push_back(fname);
-            cc->setParent(this);
-        }
+void Table::readUniqueConstraintRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    st1->Get(2, s);
+    wxString fname(std2wxIdentifier(s, conv));
+    st1->Get(3, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    if (!uniqueConstraintsM.empty()
+        && uniqueConstraintsM.back().getName_() == cname)
+    {
+        uniqueConstraintsM.back().columnsM.push_back(fname);
+    }
+    else
+    {
+        UniqueConstraint c;
+        uniqueConstraintsM.push_back(c);
+        UniqueConstraint* cc = &uniqueConstraintsM.back();
+        cc->indexNameM = ixname;
+        cc->setName_(cname);
+        cc->columnsM.push_back(fname);
+        cc->setParent(this);
     }
-    uniqueConstraintsLoadedM = true;
 }
 
 PrimaryKeyConstraint *Table::getPrimaryKey()
@@ -302,14 +378,7 @@ void Table::loadForeignKeys()
     MetadataLoaderTransaction tr(loader);
     SubjectLocker lock(this);
 
-    IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, i.rdb$field_name, c.rdb$update_rule, "
-        " c.rdb$delete_rule, c.RDB$CONST_NAME_UQ, r.rdb$index_name "
-        "from rdb$relation_constraints r, rdb$index_segments i, rdb$ref_constraints c "
-        "where r.rdb$relation_name=? and r.rdb$index_name=i.rdb$index_name  "
-        "and r.rdb$constraint_name = c.rdb$constraint_name "
-        "and (r.rdb$constraint_type='FOREIGN KEY') order by 1, i.rdb$field_position"
-    );
+    IBPP::Statement& st1 = loader->getStatement(getForeignKeysSql(false));
 
     IBPP::Statement& st2 = loader->getStatement(
         "select r.rdb$relation_name, i.rdb$field_name"
@@ -321,52 +390,64 @@ void Table::loadForeignKeys()
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    ForeignKey *fkp = 0;
     while (st1->Fetch())
     {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        st1->Get(2, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        st1->Get(3, s);
-        wxString update_rule(std2wxIdentifier(s, conv));
-        st1->Get(4, s);
-        wxString delete_rule(std2wxIdentifier(s, conv));
         std::string ref_constraint;
-        st1->Get(5, ref_constraint);
-        st1->Get(6, s);
-        wxString ixname(std2wxIdentifier(s, conv));
-
-        if (fkp && fkp->getName_() == cname) // add column
-            fkp->columnsM.push_back(fname);
-        else
+        ForeignKey* fkp = readForeignKeyRow(st1, conv, ref_constraint);
+        if (!fkp)
+            continue;
+
+        st2->Set(1, ref_constraint);
+        st2->Execute();
+        std::string rtable, s;
+        while (st2->Fetch())
         {
-            ForeignKey fk;
-            foreignKeysM.push_back(fk);
-            fkp = &foreignKeysM.back();
-            fkp->setName_(cname);
-            fkp->setParent(this);
-            fkp->updateActionM = update_rule;
-            fkp->deleteActionM = delete_rule;
-            fkp->indexNameM = ixname;
-
-            st2->Set(1, ref_constraint);
-            st2->Execute();
-            std::string rtable;
-            while (st2->Fetch())
-            {
-                st2->Get(1, rtable);
-                st2->Get(2, s);
-                fkp->referencedColumnsM.push_back(std2wxIdentifier(s, conv));
-            }
-            fkp->referencedTableM = std2wxIdentifier(rtable, conv);
-            fkp->columnsM.push_back(fname);
+            st2->Get(1, rtable);
+            st2->Get(2, s);
+            fkp->referencedColumnsM.push_back(std2wxIdentifier(s, conv));
         }
+        fkp->referencedTableM = std2wxIdentifier(rtable, conv);
     }
     foreignKeysLoadedM = true;
 }
 
+// returns the newly created foreign key (with the name of the referenced
+// constraint in refConstraint), or 0 if the row adds a column to the last one
+ForeignKey* Table::readForeignKeyRow(IBPP::Statement& st1, wxMBConv* conv,
+    std::string& refConstraint)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    st1->Get(2, s);
+    wxString fname(std2wxIdentifier(s, conv));
+
+    if (!foreignKeysM.empty() && foreignKeysM.back().getName_() == cname)
+    {
+        foreignKeysM.back().columnsM.push_back(fname);  // add column
+        return 0;
+    }
+
+    st1->Get(3, s);
+    wxString update_rule(std2wxIdentifier(s, conv));
+    st1->Get(4, s);
+    wxString delete_rule(std2wxIdentifier(s, conv));
+    st1->Get(5, refConstraint);
+    st1->Get(6, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    ForeignKey fk;
+    foreignKeysM.push_back(fk);
+    ForeignKey* fkp = &foreignKeysM.back();
+    fkp->setName_(cname);
+    fkp->setParent(this);
+    fkp->updateActionM = update_rule;
+    fkp->deleteActionM = delete_rule;
+    fkp->indexNameM = ixname;
+    fkp->columnsM.push_back(fname);
+    return fkp;
+}
+
 //! reads indices from database
 void Table::loadIndices()
 {
@@ -384,71 +465,239 @@ void Table::loadIndices()
     MetadataLoaderTransaction tr(loader);
     SubjectLocker lock(this);
 
-    IBPP::Statement& st1 = loader->getStatement(
-        "SELECT i.rdb$index_name, i.rdb$unique_flag, i.rdb$index_inactive, "
-        " i.rdb$index_type, i.rdb$statistics, "
-        " s.rdb$field_name, rc.rdb$constraint_name, i.rdb$expression_source "
-        " from rdb$indices i "
-        " left join rdb$index_segments s on i.rdb$index_name = s.rdb$index_name "
-        " left join rdb$relation_constraints rc "
-        "   on rc.rdb$index_name = i.rdb$index_name "
-        " where i.rdb$relation_name = ? "
-        " order by i.rdb$index_name, s.rdb$field_position "
-    );
+    IBPP::Statement& st1 = loader->getStatement(getIndicesSql(false));
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    Index* i = 0;
     while (st1->Fetch())
+        readIndexRow(st1, conv);
+    indicesLoadedM = true;
+}
+
+void Table::readIndexRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    short unq, inactive, type;
+    if (st1->IsNull(2))     // null = non-unique
+        unq = 0;
+    else
+        st1->Get(2, unq);
+    if (st1->IsNull(3))     // null = active
+        inactive = 0;
+    else
+        st1->Get(3, inactive);
+    if (st1->IsNull(4))     // null = ascending
+        type = 0;
+    else
+        st1->Get(4, type);
+    double statistics;
+    if (st1->IsNull(5))     // this can happen, see bug #1825725
+        statistics = -1;
+    else
+        st1->Get(5, statistics);
+
+    st1->Get(6, s);
+    wxString fname(std2wxIdentifier(s, conv));
+    wxString expression;
+    readBlob(st1, 8, expression, conv);
+
+    if (!indicesM.empty() && indicesM.back().getName_() == ixname)
+        indicesM.back().getSegments()->push_back(fname);
+    else
     {
-        std::string s;
-        st1->Get(1, s);
-        wxString ixname(std2wxIdentifier(s, conv));
+        Index x(
+            unq == 1,
+            inactive == 0,
+            type == 0,
+            statistics,
+            !st1->IsNull(7),
+            expression
+        );
+        indicesM.push_back(x);
+        Index* i = &indicesM.back();
+        i->setName_(ixname);
+        i->getSegments()->push_back(fname);
+        i->setParent(this);
+    }
+}
 
-        short unq, inactive, type;
-        if (st1->IsNull(2))     // null = non-unique
-            unq = 0;
-        else
-            st1->Get(2, unq);
-        if (st1->IsNull(3))     // null = active
-            inactive = 0;
-        else
-            st1->Get(3, inactive);
-        if (st1->IsNull(4))     // null = ascending
-            type = 0;
-        else
-            st1->Get(4, type);
-        double statistics;
-        if (st1->IsNull(5))     // this can happen, see bug #1825725
-            statistics = -1;
-        else
-            st1->Get(5, statistics);
+void Table::loadConstraintsAndIndices(DatabasePtr db,
+    const std::vector<Table*>& tables, ProgressIndicator* progressIndicator)
+{
+    typedef std::unordered_map<wxString, Table*, wxStringHash,
+        wxStringEqual> TableMap;
+    TableMap checks, primaryKeys, uniques, foreignKeys, indices;
+    for (std::vector<Table*>::const_iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        Table* t = *it;
+        if (!t->checkConstraintsLoadedM)
+        {
+            t->checkConstraintsM.clear();
+            checks[t->getName_()] = t;
+        }
+        if (!t->primaryKeyLoadedM)
+        {
+            t->primaryKeyM.columnsM.clear();
+            primaryKeys[t->getName_()] = t;
+        }
+        if (!t->uniqueConstraintsLoadedM)
+        {
+            t->uniqueConstraintsM.clear();
+            uniques[t->getName_()] = t;
+        }
+        if (!t->foreignKeysLoadedM)
+        {
+            t->foreignKeysM.clear();
+            foreignKeys[t->getName_()] = t;
+        }
+        if (!t->indicesLoadedM)
+        {
+            t->indicesM.clear();
+            indices[t->getName_()] = t;
+        }
+    }
 
-        st1->Get(6, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        wxString expression;
-        readBlob(st1, 8, expression, conv);
+    wxMBConv* conv = db->getCharsetConverter();
+    MetadataLoader* loader = db->getMetadataLoader();
+    // see loadCheckConstraints() for the order of transaction and lock
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(db.get());
 
-        if (i && i->getName_() == ixname)
-            i->getSegments()->push_back(fname);
-        else
+    // executes the statement and passes every row to the table it belongs
+    // to, rows are ordered by table so the lookup is done once per table
+    auto fetchRows = [&](const std::string& sql, int relationColumn,
+        const TableMap& pending,
+        const std::function<void(Table*, IBPP::Statement&)>& readRow)
+    {
+        if (pending.empty())
+            return;
+        checkProgressIndicatorCanceled(progressIndicator);
+        if (progressIndicator)
+            progressIndicator->stepProgress();
+
+        IBPP::Statement st1 = loader->createStatement(sql);
+        st1->Execute();
+        wxString currentName;
+        Table* current = 0;
+        while (st1->Fetch())
         {
-            Index x(
-                unq == 1,
-                inactive == 0,
-                type == 0,
-                statistics,
-                !st1->IsNull(7),
-                expression
-            );
-            indicesM.push_back(x);
-            i = &indicesM.back();
-            i->setName_(ixname);
-            i->getSegments()->push_back(fname);
-            i->setParent(this);
+            std::string s;
+            st1->Get(relationColumn, s);
+            wxString relationName(std2wxIdentifier(s, conv));
+            if (relationName != currentName)
+            {
+                currentName = relationName;
+                TableMap::const_iterator it = pending.find(relationName);
+                current = (it != pending.end()) ? it->second : 0;
+            }
+            if (current)
+                readRow(current, st1);
         }
+    };
+
+    if (progressIndicator)
+    {
+        progressIndicator->initProgress(_("Loading constraints and indices..."),
+            5, 0, 1);
+    }
+
+    fetchRows(getCheckConstraintsSql(true), 4, checks,
+        [conv](Table* t, IBPP::Statement& st) {
+            t->readCheckConstraintRow(st, conv);
+        });
+    fetchRows(getKeyConstraintsSql("PRIMARY KEY", true), 4, primaryKeys,
+        [conv](Table* t, IBPP::Statement& st) {
+            t->readPrimaryKeyRow(st, conv);
+        });
+    fetchRows(getKeyConstraintsSql("UNIQUE", true), 4, uniques,
+        [conv](Table* t, IBPP::Statement& st) {
+            t->readUniqueConstraintRow(st, conv);
+        });
+    fetchRows(getIndicesSql(true), 9, indices,
+        [conv](Table* t, IBPP::Statement& st) {
+            t->readIndexRow(st, conv);
+        });
+
+    for (TableMap::iterator it = checks.begin(); it != checks.end(); ++it)
+        it->second->checkConstraintsLoadedM = true;
+    for (TableMap::iterator it = primaryKeys.begin(); it != primaryKeys.end();
+        ++it)
+    {
+        it->second->primaryKeyM.setParent(it->second);
+        it->second->primaryKeyLoadedM = true;
+    }
+    for (TableMap::iterator it = uniques.begin(); it != uniques.end(); ++it)
+        it->second->uniqueConstraintsLoadedM = true;
+    for (TableMap::iterator it = indices.begin(); it != indices.end(); ++it)
+        it->second->indicesLoadedM = true;
+
+    // foreign keys reference primary keys and unique constraints, which are
+    // known at this point for all tables that have been passed in, so the
+    // referenced columns don't need one query per foreign key
+    typedef std::unordered_map<wxString, ColumnConstraint*, wxStringHash,
+        wxStringEqual> ConstraintMap;
+    ConstraintMap keys;
+    for (std::vector<Table*>::const_iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        Table* t = *it;
+        if (!t->primaryKeyLoadedM || !t->uniqueConstraintsLoadedM)
+            continue;
+        if (!t->primaryKeyM.columnsM.empty())
+            keys[t->primaryKeyM.getName_()] = &t->primaryKeyM;
+        for (std::vector<UniqueConstraint>::iterator uc =
+            t->uniqueConstraintsM.begin(); uc != t->uniqueConstraintsM.end();
+            ++uc)
+        {
+            keys[uc->getName_()] = &(*uc);
+        }
+    }
+
+    IBPP::Statement& st2 = loader->getStatement(
+        "select r.rdb$relation_name, i.rdb$field_name"
+        " from rdb$relation_constraints r"
+        " join rdb$index_segments i on i.rdb$index_name = r.rdb$index_name "
+        " where r.rdb$constraint_name = ?"
+        " order by i.rdb$field_position "
+    );
+    fetchRows(getForeignKeysSql(true), 7, foreignKeys,
+        [conv, &keys, &st2](Table* t, IBPP::Statement& st) {
+            std::string ref_constraint;
+            ForeignKey* fkp = t->readForeignKeyRow(st, conv, ref_constraint);
+            if (!fkp)
+                return;
+
+            ConstraintMap::const_iterator key = keys.find(
+                std2wxIdentifier(ref_constraint, conv));
+            Table* referenced = (key != keys.end()) ?
+                key->second->getTable() : 0;
+            if (referenced)
+            {
+                fkp->referencedTableM = referenced->getName_();
+                fkp->referencedColumnsM = key->second->columnsM;
+                return;
+            }
+            // referenced table is not in the list, same as loadForeignKeys()
+            st2->Set(1, ref_constraint);
+            st2->Execute();
+            std::string rtable, s;
+            while (st2->Fetch())
+            {
+                st2->Get(1, rtable);
+                st2->Get(2, s);
+                fkp->referencedColumnsM.push_back(std2wxIdentifier(s, conv));
+            }
+            fkp->referencedTableM = std2wxIdentifier(rtable, conv);
+        });
+    for (TableMap::iterator it = foreignKeys.begin(); it != foreignKeys.end();
+        ++it)
+    {
+        it->second->foreignKeysLoadedM = true;
     }
-    indicesLoadedM = true;
 }
 
 const wxString Table::getTypeName() const
@@ -36,22 +36,28 @@ private:
     PrimaryKeyConstraint primaryKeyM;           // table can have only one pk
     bool primaryKeyLoadedM;
     void loadPrimaryKey();
+    void readPrimaryKeyRow(IBPP::Statement& st, wxMBConv* converter);
 
     std::vector<ForeignKey> foreignKeysM;
     bool foreignKeysLoadedM;
     void loadForeignKeys();
+    ForeignKey* readForeignKeyRow(IBPP::Statement& st, wxMBConv* converter,
+        std::string& refConstraint);
 
     std::vector<CheckConstraint> checkConstraintsM;
     bool checkConstraintsLoadedM;
     void loadCheckConstraints();
+    void readCheckConstraintRow(IBPP::Statement& st, wxMBConv* converter);
 
     std::vector<UniqueConstraint> uniqueConstraintsM;
     bool uniqueConstraintsLoadedM;
     void loadUniqueConstraints();
+    void readUniqueConstraintRow(IBPP::Statement& st, wxMBConv* converter);
 
     std::vector<Index> indicesM;
     bool indicesLoadedM;
     void loadIndices();
+    void readIndexRow(IBPP::Statement& st, wxMBConv* converter);
 
     wxString externalPathM;
 
@@ -68,6 +74,12 @@ public:
 
     void invalidateIndices(const wxString& forIndex = wxEmptyString);
 
+    // loads the constraints and indices of all tables in the list that
+    // haven't been loaded yet, using one query per kind for the database
+    static void loadConstraintsAndIndices(DatabasePtr db,
+        const std::vector<Table*>& tables,
+        ProgressIndicator* progressIndicator = 0);
+
     wxString getExternalPath();
 
     PrimaryKeyConstraint *getPrimaryKey();
@@ -41,8 +41,9 @@
 #include "sql/MultiStatement.h"
 #include "sql/SqlTokenizer.h"
 
-IncompleteStatement::IncompleteStatement(Database *db, const wxString& sql)
-    :databaseM(db), sqlM(sql)
+IncompleteStatement::IncompleteStatement(Database *db, const wxString& sql,
+        const wxString& terminator)
+    :databaseM(db), sqlM(sql), terminatorM(terminator)
 {
 }
 
@@ -50,7 +51,7 @@ IncompleteStatement::IncompleteStatement(Database *db, const wxString& sql)
 wxString IncompleteStatement::getObjectColumns(const wxString& table,
     int position, bool sortColums)
 {
-    MultiStatement ms(sqlM);
+    MultiStatement ms(sqlM, terminatorM);
     int offset;
     SingleStatement st = ms.getStatementAt(position, offset);
     if (!st.isValid())
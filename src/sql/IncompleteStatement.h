@@ -34,6 +34,7 @@ class IncompleteStatement
 private:
     Database* databaseM;
     wxString sqlM;
+    wxString terminatorM;
 
     Relation* getCreateTriggerRelation(const wxString& sql);
     Relation* getAlterTriggerRelation(const wxString& sql);
@@ -46,7 +47,8 @@ private:
         const wxString& alias, NodeType type);
 
 public:
-    IncompleteStatement(Database* db, const wxString& sql);
+    IncompleteStatement(Database* db, const wxString& sql,
+        const wxString& terminator = ";");
 
     // position is offset at which user typed the dot character
     wxString getObjectColumns(const wxString& table, int position, bool sortColums);
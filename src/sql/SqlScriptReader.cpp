@@ -0,0 +1,279 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/wfstream.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "core/FRError.h"
+#include "sql/SqlScriptReader.h"
+
+static wxString decodeStatement(const char* data, size_t length)
+{
+    wxString sql(data, wxConvUTF8, length);
+    if (sql.empty() && length > 0)
+        sql = wxString(data, wxConvISO8859_1, length);
+    return sql;
+}
+
+SqlScriptReader::SqlScriptReader(const wxString& terminator)
+    : streamM(0), chunkSizeM(0), sizeM(0), bufferOffsetM(0), startM(0), scanM(0), stateM(ssNormal),
+        eofM(true), atEndM(true), terminatorM(terminator.utf8_str().data()),
+        statementStartM(0), statementEndM(0), lineM(1), statementLineM(1)
+{
+}
+
+bool SqlScriptReader::open(const wxString& fileName)
+{
+    fileStreamM.reset(new wxFFileInputStream(fileName, "rb"));
+    if (!fileStreamM->IsOk())
+    {
+        fileStreamM.reset();
+        return false;
+    }
+    open(*fileStreamM);
+    return true;
+}
+
+void SqlScriptReader::open(wxInputStream& stream, wxFileOffset offset,
+    size_t chunkSize)
+{
+    streamM = &stream;
+    chunkSizeM = chunkSize;
+    wxFileOffset length = stream.GetLength();
+    sizeM = (length == wxInvalidOffset ? 0 : length);
+    bufferOffsetM = offset;
+    bufferM.clear();
+    startM = scanM = 0;
+    stateM = ssNormal;
+    eofM = atEndM = false;
+    statementStartM = statementEndM = 0;
+    lineM = statementLineM = 1;
+
+    readMore();
+    // skip the UTF-8 byte order mark
+    if (offset == 0 && bufferM.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        startM = scanM = 3;
+}
+
+// appends the next chunk of the stream to the buffer after dropping the
+// statements already returned, returns false at the end of the file
+bool SqlScriptReader::readMore()
+{
+    if (eofM)
+        return false;
+    if (startM > 0)
+    {
+        bufferM.erase(0, startM);
+        bufferOffsetM += startM;
+        scanM -= startM;
+        startM = 0;
+    }
+
+    size_t oldSize = bufferM.size();
+    bufferM.resize(oldSize + chunkSizeM);
+    size_t len = streamM->Read(&bufferM[oldSize], chunkSizeM).LastRead();
+    bufferM.resize(oldSize + len);
+    if (streamM->GetLastError() == wxSTREAM_READ_ERROR)
+        throw FRError(_("Error reading the script file."));
+    if (len < chunkSizeM)
+        eofM = true;
+    return len > 0;
+}
+
+// scans for the terminator of the current statement like MultiStatement,
+// returns false if the end of the buffer has been reached before
+bool SqlScriptReader::scanStatement(size_t& end, size_t& next)
+{
+    const char* data = bufferM.data();
+    const size_t size = bufferM.size();
+    const size_t termLen = terminatorM.size();
+    size_t i = scanM;
+    while (i < size)
+    {
+        switch (stateM)
+        {
+            case ssQuote:
+            case ssLineComment:
+            {
+                const char* p = static_cast<const char*>(memchr(data + i,
+                    stateM == ssQuote ? '\'' : '\n', size - i));
+                if (!p)
+                {
+                    scanM = size;
+                    return false;
+                }
+                i = p - data + 1;
+                stateM = ssNormal;
+                break;
+            }
+            case ssBlockComment:
+            {
+                size_t p = bufferM.find("*/", i);
+                if (p == std::string::npos)
+                {
+                    // a '*' at the very end may be the start of "*/"
+                    scanM = size - 1;
+                    return false;
+                }
+                i = p + 2;
+                stateM = ssNormal;
+                break;
+            }
+            default:
+            {
+                char c = data[i];
+                if (c == '\'')
+                {
+                    stateM = ssQuote;
+                    ++i;
+                    break;
+                }
+                if (c == '-' || c == '/')
+                {
+                    if (i + 1 == size)
+                    {
+                        scanM = i;
+                        return false;
+                    }
+                    if (c == '-' && data[i + 1] == '-')
+                    {
+                        stateM = ssLineComment;
+                        i += 2;
+                        break;
+                    }
+                    if (c == '/' && data[i + 1] == '*')
+                    {
+                        stateM = ssBlockComment;
+                        i += 2;
+                        break;
+                    }
+                }
+                if (termLen && c == terminatorM[0])
+                {
+                    if (i + termLen > size)
+                    {
+                        scanM = i;
+                        return false;
+                    }
+                    if (bufferM.compare(i, termLen, terminatorM) == 0)
+                    {
+                        end = i;
+                        next = i + termLen;
+                        return true;
+                    }
+                }
+                ++i;
+            }
+        }
+    }
+    scanM = size;
+    return false;
+}
+
+SingleStatement SqlScriptReader::getNextStatement()
+{
+    while (!atEndM)
+    {
+        size_t end = 0, next = 0;
+        while (!scanStatement(end, next))
+        {
+            if (!readMore())
+            {
+                // the rest of the file is the last statement, this includes
+                // unterminated strings and comments
+                end = next = bufferM.size();
+                atEndM = true;
+                break;
+            }
+        }
+
+        statementStartM = bufferOffsetM + startM;
+        statementEndM = bufferOffsetM + end;
+        // don't count the line breaks before the statement
+        size_t first = startM;
+        while (first < end && isspace((unsigned char)bufferM[first]))
+            ++first;
+        statementLineM = lineM + std::count(bufferM.begin() + startM,
+            bufferM.begin() + first, '\n');
+        wxString sql(decodeStatement(bufferM.data() + startM, end - startM));
+        lineM += std::count(bufferM.begin() + startM, bufferM.begin() + next,
+            '\n');
+        startM = scanM = next;
+        stateM = ssNormal;
+
+        SingleStatement ss(sql);
+        wxString newTerm;
+        if (ss.isSetTermStatement(newTerm))
+        {
+            terminatorM = newTerm.utf8_str().data();
+            if (newTerm.empty())    // the caller should decide what to do
+                return ss;
+            continue;
+        }
+        return ss;
+    }
+    return SingleStatement();
+}
+
+wxString SqlScriptReader::getTerminator() const
+{
+    return wxString::FromUTF8(terminatorM.c_str());
+}
+
+wxFileOffset SqlScriptReader::getSize() const
+{
+    return sizeM;
+}
+
+wxFileOffset SqlScriptReader::getPosition() const
+{
+    return bufferOffsetM + startM;
+}
+
+wxFileOffset SqlScriptReader::getStart() const
+{
+    return statementStartM;
+}
+
+wxFileOffset SqlScriptReader::getEnd() const
+{
+    return statementEndM;
+}
+
+int SqlScriptReader::getLine() const
+{
+    return statementLineM;
+}
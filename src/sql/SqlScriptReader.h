@@ -0,0 +1,92 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_SQLSCRIPTREADER_H
+#define FR_SQLSCRIPTREADER_H
+
+#include <wx/stream.h>
+
+#include <memory>
+#include <string>
+
+#include "sql/MultiStatement.h"
+
+// Splits an SQL script file into statements the same way MultiStatement
+// does for a string (comments, quoted strings and SET TERM are handled
+// identically), but reads the file in chunks so that only the statement
+// currently being split has to be kept in memory.
+// The file has to be UTF-8 encoded (with or without BOM), statements that
+// are not valid UTF-8 are read as ISO-8859-1.
+// Instead of a file any other input stream can be split, with the offsets
+// of the statements being relative to a given start offset.
+class SqlScriptReader
+{
+private:
+    enum ScanState { ssNormal, ssQuote, ssLineComment, ssBlockComment };
+
+    std::unique_ptr<wxInputStream> fileStreamM;
+    wxInputStream* streamM;
+    size_t chunkSizeM;
+    wxFileOffset sizeM;
+    // file offset of the first byte in bufferM
+    wxFileOffset bufferOffsetM;
+    std::string bufferM;
+    // start of the current statement and scan position in bufferM
+    size_t startM;
+    size_t scanM;
+    ScanState stateM;
+    bool eofM;
+    bool atEndM;
+    std::string terminatorM;
+    wxFileOffset statementStartM;
+    wxFileOffset statementEndM;
+    // line number of startM, and of the start of the last statement
+    int lineM;
+    int statementLineM;
+
+    bool readMore();
+    bool scanStatement(size_t& end, size_t& next);
+public:
+    SqlScriptReader(const wxString& terminator = ";");
+
+    bool open(const wxString& fileName);
+    // reads from the current position of stream, which has to stay valid
+    // while the statements are read, offset is the offset of that position
+    // in the stream
+    void open(wxInputStream& stream, wxFileOffset offset = 0,
+        size_t chunkSize = 1024 * 1024);
+
+    SingleStatement getNextStatement();
+
+    wxString getTerminator() const;
+    // stream size and offset of the first byte not yet split, in bytes
+    wxFileOffset getSize() const;
+    wxFileOffset getPosition() const;
+    // file offsets of the last statement retrieved
+    wxFileOffset getStart() const;
+    wxFileOffset getEnd() const;
+    // line number (starting with 1) of the last statement retrieved
+    int getLine() const;
+};
+
+#endif // FR_SQLSCRIPTREADER_H
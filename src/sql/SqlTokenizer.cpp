@@ -31,6 +31,7 @@
 #endif
 
 #include <algorithm>
+#include <vector>
 
 #include "config/Config.h"
 #include "sql/SqlTokenizer.h"
@@ -62,6 +63,154 @@ public:
     }
 };
 
+// KeywordHashTable: perfect hash table of all keywords, used to look up the
+// type of keyword and identifier tokens directly from the statement buffer,
+// without creating upper case copies of the token strings first.
+// The table is built once using the "hash, displace" scheme: keywords are
+// distributed into buckets, and for every bucket a seed is searched for that
+// maps all of its keywords to empty slots. A lookup therefore needs exactly
+// two hash computations and one comparison.
+class KeywordHashTable
+{
+private:
+    struct Entry
+    {
+        size_t nameIndex;
+        size_t length;
+        SqlTokenType type;
+    };
+    std::vector<wxChar> namesM;
+    std::vector<Entry> keywordsM;
+    std::vector<Entry> slotsM;
+    std::vector<unsigned> seedsM;
+    unsigned slotMaskM;
+    unsigned bucketMaskM;
+
+    static inline wxChar toUpper(wxChar c)
+    {
+        if (c >= 'a' && c <= 'z')
+            return wxChar(c - 'a' + 'A');
+        return c;
+    }
+
+    static unsigned hash(const wxChar* p, size_t length, unsigned seed)
+    {
+        // FNV-1a over upper case chars, followed by the MurmurHash3
+        // finalizer so that the low bits used as index are well mixed
+        unsigned h = 2166136261u ^ (seed * 0x9E3779B9u);
+        for (; length; --length, ++p)
+        {
+            h ^= unsigned(toUpper(*p));
+            h *= 16777619u;
+        }
+        h ^= h >> 16;
+        h *= 0x85EBCA6Bu;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    unsigned hash(const Entry& entry, unsigned seed) const
+    {
+        return hash(&namesM[entry.nameIndex], entry.length, seed);
+    }
+
+    bool build(unsigned slotCount)
+    {
+        unsigned bucketCount = std::max(1u, slotCount / 4);
+        slotMaskM = slotCount - 1;
+        bucketMaskM = bucketCount - 1;
+
+        std::vector<std::vector<size_t> > buckets(bucketCount);
+        for (size_t i = 0; i < keywordsM.size(); ++i)
+            buckets[hash(keywordsM[i], 0) & bucketMaskM].push_back(i);
+        // place the largest buckets first, while the table is still empty
+        std::vector<unsigned> order(bucketCount);
+        for (unsigned i = 0; i < bucketCount; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [&buckets](unsigned lhs, unsigned rhs)
+            { return buckets[lhs].size() > buckets[rhs].size(); });
+
+        Entry empty = { 0, 0, tkIDENTIFIER };
+        slotsM.assign(slotCount, empty);
+        seedsM.assign(bucketCount, 0);
+        std::vector<unsigned> slots;
+        for (unsigned b : order)
+        {
+            const std::vector<size_t>& bucket = buckets[b];
+            if (bucket.empty())
+                break;
+            for (unsigned seed = 1; ; ++seed)
+            {
+                if (seed > 0x10000)
+                    return false;
+                slots.clear();
+                for (size_t i : bucket)
+                {
+                    unsigned slot = hash(keywordsM[i], seed) & slotMaskM;
+                    if (slotsM[slot].length != 0 || std::find(slots.begin(),
+                        slots.end(), slot) != slots.end())
+                    {
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (slots.size() == bucket.size())
+                {
+                    for (size_t i = 0; i < bucket.size(); ++i)
+                        slotsM[slots[i]] = keywordsM[bucket[i]];
+                    seedsM[b] = seed;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+public:
+    KeywordHashTable(const std::map<wxString, SqlTokenType>& keywords)
+    {
+        keywordsM.reserve(keywords.size());
+        for (std::map<wxString, SqlTokenType>::const_iterator it =
+            keywords.begin(); it != keywords.end(); ++it)
+        {
+            Entry entry = { namesM.size(), (*it).first.length(),
+                (*it).second };
+            for (wxString::const_iterator ci = (*it).first.begin();
+                ci != (*it).first.end(); ++ci)
+            {
+                namesM.push_back(toUpper(*ci));
+            }
+            keywordsM.push_back(entry);
+        }
+        // table size is a power of two, grown only if no seeds are found
+        unsigned slotCount = 1;
+        while (slotCount < keywordsM.size())
+            slotCount *= 2;
+        while (!build(slotCount))
+            slotCount *= 2;
+    }
+
+    SqlTokenType find(const wxChar* word, size_t length) const
+    {
+        if (length == 0)
+            return tkIDENTIFIER;
+        unsigned bucket = hash(word, length, 0) & bucketMaskM;
+        const Entry& entry =
+            slotsM[hash(word, length, seedsM[bucket]) & slotMaskM];
+        if (entry.length != length)
+            return tkIDENTIFIER;
+        const wxChar* name = &namesM[entry.nameIndex];
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (toUpper(word[i]) != name[i])
+                return tkIDENTIFIER;
+        }
+        return entry.type;
+    }
+};
+
 SqlTokenizer::SqlTokenizer()
     : termM(";")
 {
@@ -183,12 +332,15 @@ SqlTokenType SqlTokenizer::getKeywordTokenType(const wxString& word)
 {
     if (word.IsEmpty())
         return tkIDENTIFIER;
+    return getKeywordTokenType(word.c_str(), word.length());
+}
 
-    const KeywordToTokenMap& keywords = getKeywordToTokenMap();
-    KeywordToTokenMap::const_iterator pos = keywords.find(word.Upper());
-    if (pos != keywords.end())
-        return (*pos).second;
-    return tkIDENTIFIER;
+/*static*/
+SqlTokenType SqlTokenizer::getKeywordTokenType(const wxChar* word,
+    size_t length)
+{
+    static const KeywordHashTable keywords(getKeywordToTokenMap());
+    return keywords.find(word, length);
 }
 
 /*static*/
@@ -214,6 +366,18 @@ wxString SqlTokenizer::getCurrentTokenString()
     return wxEmptyString;
 }
 
+const wxChar* SqlTokenizer::getCurrentTokenStart() const
+{
+    return sqlTokenStartM;
+}
+
+size_t SqlTokenizer::getCurrentTokenLength() const
+{
+    if (sqlTokenStartM && sqlTokenEndM && sqlTokenEndM > sqlTokenStartM)
+        return sqlTokenEndM - sqlTokenStartM;
+    return 0;
+}
+
 bool SqlTokenizer::isKeywordToken()
 {
     return sqlTokenTypeM > tk_KEYWORDS_START_HERE;
@@ -337,8 +501,8 @@ void SqlTokenizer::keywordIdentifierToken()
         || (c >= '0' && c <= '9') || c == '_' || c == '$'));
 
     // check whether it's a keyword, and not an identifier
-    wxString checkKW(sqlTokenStartM, sqlTokenEndM);
-    SqlTokenType keywordType = getKeywordTokenType(checkKW);
+    SqlTokenType keywordType = getKeywordTokenType(sqlTokenStartM,
+        sqlTokenEndM - sqlTokenStartM);
     if (keywordType != tkIDENTIFIER)
         sqlTokenTypeM = keywordType;
 }
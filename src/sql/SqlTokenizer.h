@@ -188,6 +188,10 @@ public:
     SqlTokenType getCurrentToken();
     wxString getCurrentTokenString();
     int getCurrentTokenPosition();
+    // span of the current token in the statement buffer, use these instead
+    // of getCurrentTokenString() to inspect tokens without copying them
+    const wxChar* getCurrentTokenStart() const;
+    size_t getCurrentTokenLength() const;
     bool isKeywordToken();
     bool nextToken();
     bool jumpToken(bool skipParenthesis);   // skip whitespace and comments
@@ -205,6 +209,10 @@ public:
     // returns TokenType of parameter string if word is a keyword,
     // returns tkIdentifier otherwise
     static SqlTokenType getKeywordTokenType(const wxString& word);
+    // same for the (case-insensitive) span of length chars at word, the
+    // lookup doesn't allocate memory
+    static SqlTokenType getKeywordTokenType(const wxChar* word,
+        size_t length);
     static bool isReservedWord(const wxString& word);
 };
 
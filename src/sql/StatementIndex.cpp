@@ -0,0 +1,105 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "sql/SqlScriptReader.h"
+#include "sql/StatementIndex.h"
+
+// the editor text is read in small chunks, usually only the statements
+// around the changed position have to be split again
+static const size_t statementIndexChunkSize = 16 * 1024;
+
+void StatementIndex::clear()
+{
+    entriesM.clear();
+}
+
+void StatementIndex::invalidate(wxFileOffset position)
+{
+    // the split of a statement depends only on the text up to its end
+    // (including the terminator), so all statements ending before position
+    // are still split the same way
+    std::vector<Entry>::iterator it = std::find_if(entriesM.begin(),
+        entriesM.end(),
+        [position](const Entry& entry) { return entry.next > position; });
+    entriesM.erase(it, entriesM.end());
+}
+
+bool StatementIndex::getStatementAt(wxInputStream& script,
+    wxFileOffset position, wxFileOffset& start, wxFileOffset& end,
+    wxString& terminator)
+{
+    std::vector<Entry>::const_iterator it = std::lower_bound(
+        entriesM.begin(), entriesM.end(), position,
+        [](const Entry& entry, wxFileOffset pos) { return entry.end < pos; });
+    if (it != entriesM.end())
+    {
+        start = (*it).start;
+        end = (*it).end;
+        terminator = (*it).terminator;
+        return true;
+    }
+
+    // split the rest of the script until the statement is found
+    wxFileOffset offset = 0;
+    wxString term(";");
+    if (!entriesM.empty())
+    {
+        offset = entriesM.back().next;
+        term = entriesM.back().terminator;
+    }
+    if (script.SeekI(offset) == wxInvalidOffset)
+        return false;
+    SqlScriptReader reader(term);
+    reader.open(script, offset, statementIndexChunkSize);
+    while (true)
+    {
+        SingleStatement ss = reader.getNextStatement();
+        if (!ss.isValid())
+            return false;
+        start = reader.getStart();
+        end = reader.getEnd();
+        terminator = reader.getTerminator();
+        // the last statement may still grow when text is appended, it is
+        // only kept if it has been terminated already
+        bool terminated = reader.getPosition() > end;
+        if (terminated)
+        {
+            Entry entry = { start, end, reader.getPosition(), terminator };
+            entriesM.push_back(entry);
+        }
+        if (end >= position || !terminated)
+            return true;
+    }
+}
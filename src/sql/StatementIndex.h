@@ -0,0 +1,62 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_STATEMENTINDEX_H
+#define FR_STATEMENTINDEX_H
+
+#include <wx/stream.h>
+
+#include <vector>
+
+// Keeps the boundaries of the statements of an SQL script that is being
+// edited, so that the statement at a position can be found without splitting
+// the whole script again after every change.
+// Statements are split like MultiStatement does it, and the script is read
+// only as far as needed. After a change the statements before the changed
+// position stay valid, the others are split again when they are needed.
+// All positions are byte offsets into the UTF-8 encoded script.
+class StatementIndex
+{
+private:
+    struct Entry
+    {
+        wxFileOffset start;
+        wxFileOffset end;
+        // offset after the terminator, where the next statement starts
+        wxFileOffset next;
+        wxString terminator;
+    };
+    std::vector<Entry> entriesM;
+public:
+    void clear();
+    // drops all statements that may be affected by a change at position
+    void invalidate(wxFileOffset position);
+
+    // finds the statement that position is in (or the next one if position
+    // is between statements), like MultiStatement::getStatementAt(), the
+    // part of the script not split before is read from the seekable stream
+    bool getStatementAt(wxInputStream& script, wxFileOffset position,
+        wxFileOffset& start, wxFileOffset& end, wxString& terminator);
+};
+
+#endif // FR_STATEMENTINDEX_H
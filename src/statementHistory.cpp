@@ -32,13 +32,27 @@
 
 #include <wx/ffile.h>
 #include <wx/filefn.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
 #include <map>
 
 #include "config/Config.h"
 #include "metadata/database.h"
 #include "statementHistory.h"
 
-wxString StatementHistory::getFilename(StatementHistory::Position item)
+// every record of the log is "FRH <time> <duration> <result> <length>\n",
+// followed by length bytes of UTF-8 encoded text and "\n"
+static const size_t maxRecordHeaderSize = 80;
+
+static bool isTokenChar(wxUniChar c)
+{
+    return wxIsalnum(c) || c == '_' || c == '$';
+}
+
+wxString StatementHistory::getStoragePath()
 {
     wxString fn = config().getUserHomePath() + "history/";
     if (!wxDirExists(fn))
@@ -46,26 +60,190 @@ wxString StatementHistory::getFilename(StatementHistory::Position item)
 
     for (Position i=0; i<storageNameM.Length(); ++i)
         fn += wxString::Format("%04x", storageNameM[i]);
+    return fn;
+}
+
+// history items were stored in one file each in previous versions
+wxString StatementHistory::getFilename(StatementHistory::Position item)
+{
+    wxString fn = getStoragePath();
     fn << "_ITEM_" << (item);
     return fn;
 }
 
+wxString StatementHistory::getLogFilename()
+{
+    return getStoragePath() + "_HISTORY";
+}
+
 StatementHistory::StatementHistory(const wxString& storageName)
+    : storageNameM(storageName), logSizeM(0), fileSizeM(0),
+        tokensIndexedM(false)
+{
+    if (!wxFileExists(getLogFilename()) && wxFileExists(getFilename(0)))
+        migrate();
+    load();
+}
+
+StatementHistory::StatementHistory(const StatementHistory& source)
+    : storageNameM(source.storageNameM), entriesM(source.entriesM),
+        logSizeM(source.logSizeM), fileSizeM(source.fileSizeM),
+        tokensM(source.tokensM),
+        tokensIndexedM(source.tokensIndexedM)
 {
-    storageNameM = storageName;
-    sizeM = 0;
-    while (true)    // load history
+}
+
+// reads the record headers of the log, a partially written record at the
+// end is ignored and overwritten by the next statement added
+void StatementHistory::load()
+{
+    entriesM.clear();
+    logSizeM = 0;
+    fileSizeM = 0;
+    wxFFile f(getLogFilename(), "rb");
+    if (!f.IsOpened())
+        return;
+    wxFileOffset fileSize = f.Length();
+    fileSizeM = fileSize;
+    char header[maxRecordHeaderSize + 1];
+    while (logSizeM < fileSize && f.Seek(logSizeM))
     {
-        if (!wxFileExists(getFilename(sizeM)))
+        size_t len = f.Read(header, maxRecordHeaderSize);
+        header[len] = 0;
+        const char* eol = strchr(header, '\n');
+        wxLongLong_t time;
+        long duration;
+        int result;
+        unsigned long length;
+        if (!eol || sscanf(header, "FRH %" wxLongLongFmtSpec "d %ld %d %lu",
+            &time, &duration, &result, &length) != 4)
+        {
             break;
-        sizeM++;
+        }
+        Entry entry;
+        entry.offset = logSizeM + (eol + 1 - header);
+        entry.length = length;
+        entry.time = time;
+        entry.duration = duration;
+        entry.result = (result == erSucceeded || result == erFailed)
+            ? ExecutionResult(result) : erUnknown;
+        wxFileOffset next = entry.offset + wxFileOffset(length) + 1;
+        if (next > fileSize)
+            break;
+        entriesM.push_back(entry);
+        logSizeM = next;
     }
 }
 
-StatementHistory::StatementHistory(const StatementHistory& source)
+// moves the items stored in separate files into the log, the files are
+// only removed if all of them have been copied
+void StatementHistory::migrate()
+{
+    Position count = 0;
+    while (wxFileExists(getFilename(count)))
+    {
+        wxString fn(getFilename(count));
+        wxString sql;
+        wxFFile f(fn, "rb");
+        bool ok = f.IsOpened() && f.ReadAll(&sql);
+        f.Close();
+        if (!ok || !append(sql, wxLongLong_t(::wxFileModificationTime(fn)),
+            erUnknown, -1))
+        {
+            // try again next time
+            wxRemoveFile(getLogFilename());
+            entriesM.clear();
+            logSizeM = 0;
+            fileSizeM = 0;
+            return;
+        }
+        ++count;
+    }
+    for (Position i = 0; i < count; ++i)
+        wxRemoveFile(getFilename(i));
+}
+
+/*static*/
+bool StatementHistory::writeRecord(wxFFile& file, Entry& entry,
+    const char* text)
+{
+    char header[maxRecordHeaderSize];
+    int len = snprintf(header, sizeof(header),
+        "FRH %" wxLongLongFmtSpec "d %ld %d %lu\n", entry.time,
+        entry.duration, int(entry.result), (unsigned long)entry.length);
+    if (len <= 0 || size_t(len) >= sizeof(header))
+        return false;
+    entry.offset = file.Tell() + len;
+    return file.Write(header, len) == size_t(len)
+        && file.Write(text, entry.length) == entry.length
+        && file.Write("\n", 1) == 1;
+}
+
+/*static*/
+wxString StatementHistory::readText(wxFFile& file, const Entry& entry)
 {
-    storageNameM = source.storageNameM;
-    sizeM = source.sizeM;
+    if (entry.length == 0 || !file.Seek(entry.offset))
+        return wxEmptyString;
+    wxCharBuffer buffer(entry.length);
+    if (file.Read(buffer.data(), entry.length) != entry.length)
+        return wxEmptyString;
+    return wxString::FromUTF8(buffer.data(), entry.length);
+}
+
+bool StatementHistory::append(const wxString& sql, wxLongLong_t time,
+    ExecutionResult result, long duration)
+{
+    wxString fn(getLogFilename());
+    wxFFile f(fn, wxFileExists(fn) ? "r+b" : "w+b");
+    if (!f.IsOpened())
+        return false;
+    // records added by another instance using the same history must not
+    // be overwritten, so the index is read again and the new record is
+    // written after them
+    if (f.Length() != fileSizeM)
+    {
+        load();
+        // positions may have changed if statements were deleted
+        tokensM.clear();
+        tokensIndexedM = false;
+    }
+    if (!f.Seek(logSizeM))
+        return false;
+
+    wxScopedCharBuffer text(sql.utf8_str());
+    Entry entry;
+    entry.length = text.length();
+    entry.time = time;
+    entry.duration = duration;
+    entry.result = result;
+    if (!writeRecord(f, entry, text.data()) || !f.Flush())
+        return false;
+    logSizeM = entry.offset + wxFileOffset(entry.length) + 1;
+    fileSizeM = f.Length();
+    entriesM.push_back(entry);
+    if (tokensIndexedM)
+        indexTokens(entriesM.size() - 1, sql);
+    return true;
+}
+
+void StatementHistory::indexTokens(Position position, const wxString& sql)
+{
+    wxString upper(sql.Upper());
+    wxString::const_iterator it = upper.begin();
+    while (it != upper.end())
+    {
+        if (!isTokenChar(*it))
+        {
+            ++it;
+            continue;
+        }
+        wxString::const_iterator start = it;
+        while (it != upper.end() && isTokenChar(*it))
+            ++it;
+        std::vector<Position>& items = tokensM[wxString(start, it)];
+        if (items.empty() || items.back() != position)
+            items.push_back(position);
+    }
 }
 
 //! reads granularity from config() and gives pointer to appropriate history object
@@ -104,31 +282,39 @@ StatementHistory& StatementHistory::get(Database* db)
 
 wxDateTime StatementHistory::getDateTime(StatementHistory::Position pos)
 {
-    if (pos < sizeM)
-    {
-        return wxDateTime(::wxFileModificationTime(getFilename(pos)));
-    }
+    if (pos < entriesM.size())
+        return wxDateTime(time_t(entriesM[pos].time));
     return wxInvalidDateTime;
 }
 
+long StatementHistory::getDuration(StatementHistory::Position pos)
+{
+    if (pos < entriesM.size())
+        return entriesM[pos].duration;
+    return -1;
+}
+
+StatementHistory::ExecutionResult StatementHistory::getResult(
+    StatementHistory::Position pos)
+{
+    if (pos < entriesM.size())
+        return entriesM[pos].result;
+    return erUnknown;
+}
+
 wxString StatementHistory::get(StatementHistory::Position pos)
 {
-    if (pos < sizeM)
+    if (pos < entriesM.size())
     {
-        wxFFile f(getFilename(pos), "rb");
-        if (!f.IsOpened())
-            return wxEmptyString;
-        wxString retval;
-        if (f.ReadAll(&retval))
-        {
-            f.Close();
-            return retval;
-        }
+        wxFFile f(getLogFilename(), "rb");
+        if (f.IsOpened())
+            return readText(f, entriesM[pos]);
     }
     return wxEmptyString;
 }
 
-void StatementHistory::add(const wxString& str)
+void StatementHistory::add(const wxString& str, ExecutionResult result,
+    long duration)
 {
     if (str.Strip().IsEmpty() ||    // empty or too big string
         (config().get("limitHistoryItemSize", false) &&
@@ -137,47 +323,132 @@ void StatementHistory::add(const wxString& str)
         return;
     }
 
-    if (sizeM == 0 || get(sizeM-1) != str)
+    // don't store the same statement twice in a row
+    if (!entriesM.empty() && entriesM.back().length == str.utf8_str().length()
+        && get(entriesM.size() - 1) == str)
     {
-        wxFFile f(getFilename(sizeM), "wb+");
-        if (f.IsOpened())
-        {
-            f.Write(str);
-            f.Close();
-            sizeM++;
-        }
+        return;
     }
+    append(str, wxDateTime::Now().GetTicks(), result, duration);
 }
 
 StatementHistory::Position StatementHistory::size()
 {
-    return sizeM;
+    return entriesM.size();
 }
 
 void StatementHistory::deleteItems(
     const std::vector<StatementHistory::Position>& items)
 {
-    // remove the files (remembering the "lowest" deleted)
-    Position start = size();
+    std::vector<bool> deleted(entriesM.size(), false);
     for (std::vector<Position>::const_iterator ci = items.begin();
         ci != items.end(); ++ci)
     {
-        wxRemoveFile(getFilename(*ci));
-        if ((*ci) < start)
-            start = (*ci);
+        if ((*ci) < deleted.size())
+            deleted[*ci] = true;
     }
 
-    // move existing files
-    for (Position currentpos = start; currentpos < size(); currentpos++)
+    // copy the remaining records to a new log, and replace the old one
+    wxString fn(getLogFilename());
+    wxString tempFn(fn + ".tmp");
+    std::vector<Entry> entries;
+    bool ok;
     {
-        if (!wxFileExists(getFilename(currentpos)))
+        wxFFile source(fn, "rb");
+        wxFFile target(tempFn, "wb");
+        ok = source.IsOpened() && target.IsOpened();
+        for (Position i = 0; ok && i < entriesM.size(); ++i)
+        {
+            if (deleted[i])
+                continue;
+            Entry entry(entriesM[i]);
+            wxCharBuffer text(entry.length);
+            ok = source.Seek(entry.offset)
+                && source.Read(text.data(), entry.length) == entry.length
+                && writeRecord(target, entry, text.data());
+            entries.push_back(entry);
+        }
+        ok = ok && target.Close();
+    }
+    if (!ok || !wxRenameFile(tempFn, fn, true))
+    {
+        wxRemoveFile(tempFn);
+        return;
+    }
+    entriesM.swap(entries);
+    logSizeM = entriesM.empty() ? 0
+        : entriesM.back().offset + wxFileOffset(entriesM.back().length) + 1;
+    fileSizeM = logSizeM;
+    // positions have changed
+    tokensM.clear();
+    tokensIndexedM = false;
+}
+
+void StatementHistory::findCandidates(const wxString& text,
+    std::vector<Position>& items)
+{
+    items.clear();
+    // search words are the token char sequences of text
+    wxArrayString words;
+    wxString upper(text.Upper());
+    wxString::const_iterator it = upper.begin();
+    while (it != upper.end())
+    {
+        if (!isTokenChar(*it))
+        {
+            ++it;
             continue;
-        if (currentpos != start)
-            wxRenameFile(getFilename(currentpos), getFilename(start));
-        start++;
+        }
+        wxString::const_iterator start = it;
+        while (it != upper.end() && isTokenChar(*it))
+            ++it;
+        words.Add(wxString(start, it));
+    }
+    if (words.IsEmpty())
+    {
+        for (Position i = 0; i < entriesM.size(); ++i)
+            items.push_back(i);
+        return;
     }
 
-    // set new size
-    sizeM = start;
-}
+    if (!tokensIndexedM)
+    {
+        tokensM.clear();
+        wxFFile f(getLogFilename(), "rb");
+        if (f.IsOpened())
+        {
+            for (Position i = 0; i < entriesM.size(); ++i)
+                indexTokens(i, readText(f, entriesM[i]));
+        }
+        tokensIndexedM = true;
+    }
 
+    // every word has to be contained in one of the tokens of a statement
+    for (size_t w = 0; w < words.GetCount(); ++w)
+    {
+        std::vector<Position> matches;
+        for (TokenIndex::const_iterator ti = tokensM.begin();
+            ti != tokensM.end(); ++ti)
+        {
+            if ((*ti).first.find(words[w]) != wxString::npos)
+            {
+                matches.insert(matches.end(), (*ti).second.begin(),
+                    (*ti).second.end());
+            }
+        }
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()),
+            matches.end());
+        if (w == 0)
+            items.swap(matches);
+        else
+        {
+            std::vector<Position> both;
+            std::set_intersection(items.begin(), items.end(),
+                matches.begin(), matches.end(), std::back_inserter(both));
+            items.swap(both);
+        }
+        if (items.empty())
+            break;
+    }
+}
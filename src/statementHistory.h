@@ -25,20 +25,59 @@
 #define FR_HISTORY_H
 
 #include <wx/wx.h>
+#include <wx/ffile.h>
+#include <wx/hashmap.h>
+
+#include <unordered_map>
 #include <vector>
 
 class Database;
 
+// The statements of a history are appended to a single log file, every
+// statement is preceded by a header with its time and execution metrics.
+// Only the headers are read when the history is opened, the offsets of the
+// statements in the log are kept so that each statement can be read when
+// it is needed. Deleting statements rewrites the log without them.
 class StatementHistory
 {
 public:
     typedef size_t Position;
+    enum ExecutionResult { erUnknown, erSucceeded, erFailed };
 
 private:
+    struct Entry
+    {
+        wxFileOffset offset;    // of the statement text in the log
+        size_t length;          // of the UTF-8 encoded text
+        wxLongLong_t time;
+        long duration;          // in milliseconds, -1 if unknown
+        ExecutionResult result;
+    };
+    typedef std::unordered_map<wxString, std::vector<Position>,
+        wxStringHash, wxStringEqual> TokenIndex;
+
     StatementHistory(const wxString& storageName);
+    wxString getStoragePath();
     wxString getFilename(Position item);
+    wxString getLogFilename();
     wxString storageNameM;
-    Position sizeM;
+    std::vector<Entry> entriesM;
+    // end of the last complete record in the log
+    wxFileOffset logSizeM;
+    // length of the log when it was last read or written, if it differs
+    // another instance has changed the log in the meantime
+    wxFileOffset fileSizeM;
+    // statement positions per (upper case) token, built for the first search
+    TokenIndex tokensM;
+    bool tokensIndexedM;
+
+    void load();
+    void migrate();
+    bool append(const wxString& sql, wxLongLong_t time,
+        ExecutionResult result, long duration);
+    static bool writeRecord(wxFFile& file, Entry& entry, const char* text);
+    static wxString readText(wxFFile& file, const Entry& entry);
+    void indexTokens(Position position, const wxString& sql);
 
 public:
     // copy ctor needed for std:: containers
@@ -49,8 +88,15 @@ public:
 
     wxString get(Position position);
     wxDateTime getDateTime(Position position);
-    void add(const wxString&);
+    // execution time in milliseconds, -1 if not known
+    long getDuration(Position position);
+    ExecutionResult getResult(Position position);
+    void add(const wxString& sql, ExecutionResult result = erUnknown,
+        long duration = -1);
     void deleteItems(const std::vector<Position>& items);
+    // returns (ascending) positions of all statements that may contain text,
+    // ignoring case; the caller has to check the statements themselves
+    void findCandidates(const wxString& text, std::vector<Position>& items);
     Position size();
 };
 
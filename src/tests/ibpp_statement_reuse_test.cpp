@@ -0,0 +1,106 @@
+/*
+  Copyright (c) 2004-2025 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <ibpp.h>
+
+// ibpp_statement_reuse_test checks that a prepared statement survives the
+// end of its transaction: a select is executed, only its first row is
+// fetched (leaving the cursor open), the transaction is committed or rolled
+// back and started again, and the statement is executed once more.
+// MetadataLoader keeps its statements prepared across transactions this way.
+//
+// It needs a Firebird server and an existing database:
+//   FR_TEST_DATABASE  database path or alias (the test is skipped if unset)
+//   FR_TEST_SERVER    server name, empty for an embedded connection
+//   FR_TEST_USER      user name, defaults to SYSDBA
+//   FR_TEST_PASSWORD  password, defaults to masterkey
+
+static const int skipTest = 77;
+
+static std::string getEnv(const char* name, const char* defaultValue)
+{
+    const char* value = std::getenv(name);
+    return (value != 0) ? std::string(value) : std::string(defaultValue);
+}
+
+static bool fetchFirstRow(IBPP::Statement& st, const char* step)
+{
+    st->Execute();
+    if (st->Fetch())
+        return true;
+    std::printf("FAILED: %s: no row fetched\n", step);
+    return false;
+}
+
+int main()
+{
+    std::string database(getEnv("FR_TEST_DATABASE", ""));
+    if (database.empty())
+    {
+        std::printf("FR_TEST_DATABASE not set, test skipped\n");
+        return skipTest;
+    }
+
+    try
+    {
+        IBPP::Database db = IBPP::DatabaseFactory(
+            getEnv("FR_TEST_SERVER", ""), database,
+            getEnv("FR_TEST_USER", "SYSDBA"),
+            getEnv("FR_TEST_PASSWORD", "masterkey"));
+        db->Connect();
+
+        IBPP::Transaction tr = IBPP::TransactionFactory(db, IBPP::amRead);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(db, tr,
+            "select rdb$relation_name from rdb$relations");
+
+        bool ok = fetchFirstRow(st, "first execute");
+        tr->Commit();
+
+        tr->Start();
+        ok = fetchFirstRow(st, "execute after commit") && ok;
+        tr->Rollback();
+
+        tr->Start();
+        ok = fetchFirstRow(st, "execute after rollback") && ok;
+        tr->Commit();
+
+        st->Close();
+        db->Disconnect();
+        if (!ok)
+            return EXIT_FAILURE;
+    }
+    catch (IBPP::Exception& e)
+    {
+        std::printf("FAILED: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    std::printf("OK\n");
+    return EXIT_SUCCESS;
+}